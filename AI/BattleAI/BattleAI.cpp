@@ -11,13 +11,17 @@
 #include "BattleAI.h"
 #include "StackWithBonuses.h"
 #include "EnemyInfo.h"
+#include "BattleSearch.h"
+#include "StackValueCache.h"
+#include "../../lib/CConfigHandler.h"
+#include "../../lib/CThreadHelper.h"
 #include "../../lib/spells/CSpellHandler.h"
 
 #define LOGL(text) print(text)
 #define LOGFL(text, formattingEl) print(boost::str(boost::format(text) % formattingEl))
 
 CBattleAI::CBattleAI(void)
-	: side(-1), wasWaitingForRealize(false), wasUnlockingGs(false)
+	: side(-1), searchTime(0), spellEvaluationTime(0), wasWaitingForRealize(false), wasUnlockingGs(false)
 {
 }
 
@@ -40,6 +44,8 @@ void CBattleAI::init(std::shared_ptr<CBattleCallback> CB)
 	wasUnlockingGs = CB->unlockGsWhenWaiting;
 	CB->waitTillRealize = true;
 	CB->unlockGsWhenWaiting = false;
+	searchTime = settings["server"]["battleAISearchTime"].Float();
+	spellEvaluationTime = settings["server"]["battleAISpellTime"].Float();
 }
 
 BattleAction CBattleAI::activeStack( const CStack * stack )
@@ -76,6 +82,11 @@ BattleAction CBattleAI::activeStack( const CStack * stack )
 
 		if(auto action = considerFleeingOrSurrendering())
 			return *action;
+		if(searchTime > 0)
+		{
+			if(auto action = searchBestAction(stack))
+				return *action;
+		}
 		PotentialTargets targets(stack);
 		if(targets.possibleAttacks.size())
 		{
@@ -160,6 +171,34 @@ BattleAction CBattleAI::goTowards(const CStack * stack, BattleHex destination)
 	}
 }
 
+boost::optional<BattleAction> CBattleAI::searchBestAction(const CStack * stack)
+{
+	BattleSnapshot snapshot(*cb);
+	if(snapshot.activeUnit() < 0 || snapshot.info(snapshot.activeUnit()).stack != stack)
+		return boost::none;
+
+	BattleSearch search(stack->side, searchTime);
+	auto best = search.findBestAction(snapshot);
+	if(!best)
+		return boost::none;
+
+	LOGFL("Search reached depth %d in %d nodes, value %f", search.getReachedDepth() % search.getVisitedNodes() % search.getBestValue());
+
+	switch(best->type)
+	{
+	case SnapshotAction::WAIT:
+		return BattleAction::makeWait(stack);
+	case SnapshotAction::MOVE:
+		return BattleAction::makeMove(stack, best->destination);
+	case SnapshotAction::MELEE:
+		return BattleAction::makeMeleeAttack(stack, snapshot.info(best->target).stack, best->destination.isValid() ? best->destination : stack->position);
+	case SnapshotAction::SHOOT:
+		return BattleAction::makeShotAttack(stack, snapshot.info(best->target).stack);
+	default:
+		return BattleAction::makeDefend(stack);
+	}
+}
+
 BattleAction CBattleAI::useCatapult(const CStack * stack)
 {
 	throw std::runtime_error("The method or operation is not implemented.");
@@ -216,6 +255,7 @@ void CBattleAI::attemptCastingSpell()
 	if(possibleCasts.empty())
 		return;
 
+	//evaluated serially, this also fills bonus caches of stacks before they are read by concurrent evaluations below
 	std::map<const CStack*, int> valueOfStack;
 	for(auto stack : cb->battleGetStacks())
 	{
@@ -223,6 +263,20 @@ void CBattleAI::attemptCastingSpell()
 		valueOfStack[stack] = pt.bestActionValue();
 	}
 
+	//the same spell effects on a stack are often considered for many destinations, evaluate them only once
+	StackValueCache valueWithBonuses;
+
+	auto evaluateStackWithBonuses = [&](const StackWithBonuses & swb) -> int
+	{
+		return valueWithBonuses.get(swb.stack, swb.bonusesToAdd, [&swb]() -> int
+		{
+			HypotheticChangesToBattleState state;
+			state.bonusesOfStacks[swb.stack] = &swb;
+			PotentialTargets pt(swb.stack, state);
+			return pt.bestActionValue();
+		});
+	};
+
 	auto evaluateSpellcast = [&] (const PossibleSpellcast &ps) -> int
 	{
 		const int skillLevel = hero->getSpellSchoolLevel(ps.spell);
@@ -262,11 +316,8 @@ void CBattleAI::attemptCastingSpell()
 				//todo: handle effect actualization in HypotheticChangesToBattleState
 				ps.spell->getEffects(swb.bonusesToAdd, skillLevel, false, hero->getEnchantPower(ps.spell));
 				ps.spell->getEffects(swb.bonusesToAdd, skillLevel, true, hero->getEnchantPower(ps.spell));
-				HypotheticChangesToBattleState state;
-				state.bonusesOfStacks[swb.stack] = &swb;
-				PotentialTargets pt(swb.stack, state);
-				auto newValue = pt.bestActionValue();
-				auto oldValue = valueOfStack[swb.stack];
+				auto newValue = evaluateStackWithBonuses(swb);
+				auto oldValue = getValOr(valueOfStack, swb.stack, 0);
 				auto gain = newValue - oldValue;
 				if(swb.stack->owner != playerID) //enemy
 					gain = -gain;
@@ -284,13 +335,37 @@ void CBattleAI::attemptCastingSpell()
 		}
 	};
 
-	for(PossibleSpellcast & psc : possibleCasts)
-		psc.value = evaluateSpellcast(psc);
+	//evaluations are independent, casts not evaluated before deadline are not considered
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(spellEvaluationTime);
+	std::vector<ui8> evaluated(possibleCasts.size(), false);
+	std::vector<Task> tasks;
+	for(size_t i = 0; i < possibleCasts.size(); i++)
+	{
+		tasks.push_back([&, i]()
+		{
+			if(spellEvaluationTime > 0 && std::chrono::steady_clock::now() >= deadline)
+				return;
+			possibleCasts[i].value = evaluateSpellcast(possibleCasts[i]);
+			evaluated[i] = true;
+		});
+	}
+
+	CThreadHelper::runParallel(tasks);
+
+	LOGFL("Evaluated %d of %d spell-target combinations, %d stack evaluations reused.", boost::count(evaluated, true) % possibleCasts.size() % valueWithBonuses.reusedCount());
+
+	std::vector<PossibleSpellcast> evaluatedCasts;
+	for(size_t i = 0; i < possibleCasts.size(); i++)
+		if(evaluated[i])
+			evaluatedCasts.push_back(possibleCasts[i]);
+	if(evaluatedCasts.empty())
+		return;
+
 	auto pscValue = [] (const PossibleSpellcast &ps) -> int
 	{
 		return ps.value;
 	};
-	auto castToPerform = *vstd::maxElementByFun(possibleCasts, pscValue);
+	auto castToPerform = *vstd::maxElementByFun(evaluatedCasts, pscValue);
 	LOGFL("Best spell is %s. Will cast.", castToPerform.spell->name);
 	BattleAction spellcast;
 	spellcast.actionType = Battle::HERO_SPELL;
@@ -56,6 +56,8 @@ class CBattleAI : public CBattleGameInterface
 {
 	int side;
 	std::shared_ptr<CBattleCallback> cb;
+	int searchTime; //time limit of lookahead search in milliseconds, greedy evaluation is used if 0
+	int spellEvaluationTime; //time limit of evaluating possible spell casts in milliseconds, 0 means no limit
 
 	//Previous setting of cb
 	bool wasWaitingForRealize, wasUnlockingGs;
@@ -69,6 +71,7 @@ public:
 
 	BattleAction activeStack(const CStack * stack) override; //called when it's turn of that stack
 	BattleAction goTowards(const CStack * stack, BattleHex hex );
+	boost::optional<BattleAction> searchBestAction(const CStack * stack);
 
 	boost::optional<BattleAction> considerFleeingOrSurrendering();
 
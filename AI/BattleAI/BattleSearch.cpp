@@ -0,0 +1,243 @@
+/*
+ * BattleSearch.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "BattleSearch.h"
+#include "../../lib/CStack.h"
+#include "../../lib/CCreatureHandler.h"
+#include "../../lib/CThreadHelper.h"
+
+namespace
+{
+	const int MAX_DEPTH = 16;
+	const double WIN_VALUE = 1e9;
+	const double INF_VALUE = 1e18;
+	const size_t MAX_MELEE_HEXES_PER_TARGET = 2;
+	const size_t MAX_MOVES = 3;
+
+	int distanceToNearestEnemy(const BattleSnapshot & state, ui8 unit, BattleHex hex)
+	{
+		int ret = std::numeric_limits<int>::max();
+		for(size_t i = 0; i < state.unitCount(); i++)
+			if(state.alive(i) && state.info(i).side != state.info(unit).side)
+				vstd::amin(ret, BattleHex::getDistance(hex, state.unit(i).position));
+		return ret;
+	}
+}
+
+BattleSearch::BattleSearch(ui8 side, int timeLimit)
+	: side(side), timeLimit(timeLimit), stopped(false), depthLimited(false), nodes(0), reachedDepth(0), bestValue(0)
+{
+}
+
+boost::optional<SnapshotAction> BattleSearch::findBestAction(const BattleSnapshot & root)
+{
+	deadline = TClock::now() + std::chrono::milliseconds(timeLimit);
+	stopped = false;
+	nodes = 0;
+	reachedDepth = 0;
+
+	valuePerHealth.clear();
+	for(size_t i = 0; i < root.unitCount(); i++)
+		valuePerHealth.push_back(std::max<ui32>(1, root.info(i).stack->getCreature()->AIValue) / static_cast<double>(root.info(i).maxHealth));
+
+	if(root.activeUnit() < 0)
+		return boost::none;
+
+	const std::vector<SnapshotAction> rootActions = getCandidates(root);
+	if(rootActions.empty())
+		return boost::none;
+
+	//candidates are ordered by static evaluation, so first one is choice of greedy evaluation
+	SnapshotAction best = rootActions.front();
+	bestValue = evaluate(root);
+	if(rootActions.size() == 1)
+		return best;
+
+	std::vector<double> values(rootActions.size());
+
+	for(int depth = 1; depth <= MAX_DEPTH; depth++)
+	{
+		depthLimited = false;
+
+		std::vector<Task> tasks;
+		for(size_t i = 0; i < rootActions.size(); i++)
+		{
+			tasks.push_back([&, i, depth]()
+			{
+				BattleSnapshot next = root;
+				next.apply(rootActions[i]);
+				values[i] = search(next, depth - 1, -INF_VALUE, INF_VALUE);
+			});
+		}
+
+		CThreadHelper::runParallel(tasks);
+
+		//results of interrupted iteration are incomplete
+		if(stopped)
+			break;
+
+		const size_t bestIndex = std::max_element(values.begin(), values.end()) - values.begin();
+		best = rootActions[bestIndex];
+		bestValue = values[bestIndex];
+		reachedDepth = depth;
+
+		if(!depthLimited)
+			break;
+	}
+
+	return best;
+}
+
+double BattleSearch::search(const BattleSnapshot & state, int depth, double alpha, double beta)
+{
+	nodes++;
+
+	if(state.isFinished() || state.activeUnit() < 0)
+		return evaluate(state);
+
+	if(depth <= 0 || timeIsUp())
+	{
+		depthLimited = true;
+		return evaluate(state);
+	}
+
+	const bool maximizing = state.info(state.activeUnit()).side == side;
+
+	for(const SnapshotAction & action : getCandidates(state))
+	{
+		BattleSnapshot next = state;
+		next.apply(action);
+		const double value = search(next, depth - 1, alpha, beta);
+
+		if(maximizing)
+			vstd::amax(alpha, value);
+		else
+			vstd::amin(beta, value);
+
+		if(alpha >= beta)
+			break;
+	}
+
+	return maximizing ? alpha : beta;
+}
+
+std::vector<SnapshotAction> BattleSearch::getCandidates(const BattleSnapshot & state) const
+{
+	const ui8 unit = state.activeUnit();
+	const bool ours = state.info(unit).side == side;
+
+	std::vector<std::pair<double, SnapshotAction>> attacks, moves, others;
+	std::map<ui8, size_t> meleeHexesOfTarget;
+
+	for(const SnapshotAction & action : state.getPossibleActions())
+	{
+		switch(action.type)
+		{
+		case SnapshotAction::MELEE:
+		case SnapshotAction::SHOOT:
+			{
+				BattleSnapshot next = state;
+				next.apply(action);
+				const double value = material(next);
+				attacks.push_back(std::make_pair(ours ? value : -value, action));
+			}
+			break;
+		case SnapshotAction::MOVE:
+			moves.push_back(std::make_pair(-distanceToNearestEnemy(state, unit, action.destination), action));
+			break;
+		default:
+			others.push_back(std::make_pair(0, action));
+			break;
+		}
+	}
+
+	auto byScore = [](const std::pair<double, SnapshotAction> & a, const std::pair<double, SnapshotAction> & b)
+	{
+		return a.first > b.first;
+	};
+
+	std::vector<SnapshotAction> ret;
+
+	//only few best hexes to attack each target from are worth checking
+	boost::stable_sort(attacks, byScore);
+	for(auto & attack : attacks)
+	{
+		if(attack.second.type == SnapshotAction::MELEE && ++meleeHexesOfTarget[attack.second.target] > MAX_MELEE_HEXES_PER_TARGET)
+			continue;
+		ret.push_back(attack.second);
+	}
+
+	//approaching enemy is usually better than running away
+	boost::stable_sort(moves, byScore);
+	for(size_t i = 0; i < moves.size() && i < MAX_MOVES; i++)
+		ret.push_back(moves[i].second);
+
+	for(auto & other : others)
+		ret.push_back(other.second);
+
+	return ret;
+}
+
+double BattleSearch::material(const BattleSnapshot & state) const
+{
+	double ret = 0;
+	for(size_t i = 0; i < state.unitCount(); i++)
+	{
+		if(!state.alive(i))
+			continue;
+		const double value = valuePerHealth[i] * state.availableHealth(i);
+		ret += state.info(i).side == side ? value : -value;
+	}
+	return ret;
+}
+
+double BattleSearch::evaluate(const BattleSnapshot & state) const
+{
+	const double army = material(state);
+
+	if(auto result = state.isFinished())
+	{
+		if(*result == side)
+			return WIN_VALUE + army;
+		else if(*result == 2)
+			return army;
+		else
+			return -WIN_VALUE + army;
+	}
+
+	const int active = state.activeUnit();
+	if(active < 0)
+		return army;
+
+	//greedy evaluation: active unit performs its best attack
+	const bool ours = state.info(active).side == side;
+	double ret = army;
+	for(const SnapshotAction & action : state.getPossibleActions())
+	{
+		if(action.type != SnapshotAction::MELEE && action.type != SnapshotAction::SHOOT)
+			continue;
+
+		BattleSnapshot next = state;
+		next.apply(action);
+		const double value = material(next);
+		if(ours)
+			vstd::amax(ret, value);
+		else
+			vstd::amin(ret, value);
+	}
+	return ret;
+}
+
+bool BattleSearch::timeIsUp()
+{
+	if(!stopped && TClock::now() >= deadline)
+		stopped = true;
+	return stopped;
+}
@@ -0,0 +1,49 @@
+/*
+ * BattleSearch.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+#include "BattleSnapshot.h"
+
+/// Time limited lookahead over BattleSnapshot. Activations of units of both sides are simulated several moves ahead,
+/// our side maximizes and enemy minimizes value of army; at leaves active unit makes its best greedy attack.
+/// Damage is resolved as its average, so chance nodes of expectimax collapse to one outcome and alpha-beta pruning applies.
+class BattleSearch
+{
+public:
+	/// Side is the one we are choosing action for, timeLimit is in milliseconds
+	BattleSearch(ui8 side, int timeLimit);
+
+	/// Iterative deepening search for best action of active unit, root children are evaluated in parallel.
+	/// Returns none if there is no active unit.
+	boost::optional<SnapshotAction> findBestAction(const BattleSnapshot & root);
+
+	int getReachedDepth() const { return reachedDepth; }
+	ui64 getVisitedNodes() const { return nodes; }
+	double getBestValue() const { return bestValue; }
+
+private:
+	typedef std::chrono::steady_clock TClock;
+
+	ui8 side;
+	int timeLimit;
+	TClock::time_point deadline;
+	std::atomic<bool> stopped;
+	std::atomic<bool> depthLimited; //some line was cut by depth limit, deeper search may change result
+	std::atomic<ui64> nodes;
+	int reachedDepth;
+	double bestValue;
+	std::vector<double> valuePerHealth;
+
+	double search(const BattleSnapshot & state, int depth, double alpha, double beta);
+	/// Actions worth searching, best first according to static evaluation
+	std::vector<SnapshotAction> getCandidates(const BattleSnapshot & state) const;
+	double material(const BattleSnapshot & state) const;
+	double evaluate(const BattleSnapshot & state) const;
+	bool timeIsUp();
+};
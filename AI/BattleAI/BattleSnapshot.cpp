@@ -0,0 +1,691 @@
+/*
+ * BattleSnapshot.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "BattleSnapshot.h"
+#include "../../lib/CStack.h"
+#include "../../lib/CCreatureHandler.h"
+#include "../../lib/battle/CBattleInfoCallback.h"
+#include "../../lib/battle/CObstacleInstance.h"
+#include "../../lib/battle/DamageFormula.h"
+#include "../../lib/spells/CSpellHandler.h"
+
+namespace
+{
+	int battleBonusValue(const CStack * stack, const CSelector & selector, bool shooting)
+	{
+		auto noLimit = Selector::effectRange(Bonus::NO_LIMIT);
+		auto limitMatches = shooting
+							? Selector::effectRange(Bonus::ONLY_DISTANCE_FIGHT)
+							: Selector::effectRange(Bonus::ONLY_MELEE_FIGHT);
+
+		return stack->getBonuses(selector, noLimit.Or(limitMatches))->totalValue();
+	}
+
+	si32 defenseInStance(const CStack * stack)
+	{
+		if(stack->hasBonusOfType(Bonus::IN_FRENZY))
+			return 0;
+
+		return std::max(0, stack->Defense(false) + stack->getDefensiveStanceGain());
+	}
+
+	BattleSnapshot::UnitInfo makeUnitInfo(const CStack * stack)
+	{
+		BattleSnapshot::UnitInfo ret;
+		ret.stack = stack;
+		ret.side = stack->side;
+		ret.creature = stack->getCreature()->idNumber;
+
+		ret.doubleWide = stack->doubleWide();
+		ret.flying = stack->hasBonusOfType(Bonus::FLYING);
+		ret.clone = stack->isClone();
+		ret.siegeWeapon = stack->hasBonusOfType(Bonus::SIEGE_WEAPON);
+		ret.shooter = stack->hasBonusOfType(Bonus::SHOOTER);
+		ret.canAct = stack->canMove() && ret.creature != CreatureID::CATAPULT && (ret.shooter || !ret.siegeWeapon);
+		ret.freeShooting = stack->hasBonusOfType(Bonus::FREE_SHOOTING);
+		ret.blocksRetaliation = stack->hasBonusOfType(Bonus::BLOCKS_RETALIATION);
+		ret.noRetaliation = ret.siegeWeapon || stack->hasBonusOfType(Bonus::HYPNOTIZED) || stack->hasBonusOfType(Bonus::NO_RETALIATION);
+		ret.unlimitedRetaliations = stack->hasBonusOfType(Bonus::UNLIMITED_RETALIATIONS);
+
+		ret.speed = stack->Speed(0, true);
+		ret.maxHealth = stack->MaxHealth();
+		ret.retaliationsPerRound = stack->counterAttacks.total();
+
+		ret.minDamage = stack->getMinDamage();
+		ret.maxDamage = stack->getMaxDamage();
+		if(ret.siegeWeapon)
+		{
+			//minDmg and maxDmg are multiplied by hero attack + 1
+			const std::shared_ptr<Bonus> b = stack->getBonus(Selector::sourceTypeSel(Bonus::HERO_BASE_SKILL).And(Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK)));
+			const int multiplier = (b ? b->val : 0) + 1;
+			ret.minDamage *= multiplier;
+			ret.maxDamage *= multiplier;
+		}
+
+		for(int shooting = 0; shooting < 2; shooting++)
+		{
+			ret.totalAttacks[shooting] = 1 + battleBonusValue(stack, Selector::type(Bonus::ADDITIONAL_ATTACK), shooting);
+			ret.attack[shooting] = battleBonusValue(stack, Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK), shooting);
+			ret.attackReduction[shooting] = battleBonusValue(stack, Selector::type(Bonus::GENERAL_ATTACK_REDUCTION), shooting);
+			ret.enemyDefenceReduction[shooting] = battleBonusValue(stack, Selector::type(Bonus::ENEMY_DEFENCE_REDUCTION), shooting);
+			ret.damageReduction[shooting] = stack->valOfBonuses(Bonus::GENERAL_DAMAGE_REDUCTION, shooting);
+		}
+		ret.skillPremy[0] = stack->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::OFFENCE);
+		ret.skillPremy[1] = stack->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARCHERY);
+
+		if(const std::shared_ptr<Bonus> slayerEffect = stack->getBonus(Selector::type(Bonus::SLAYER)))
+		{
+			ret.slayerLevel = slayerEffect->val;
+			ret.slayerPower = SpellID(SpellID::SLAYER).toSpell()->getPower(ret.slayerLevel);
+		}
+
+		TBonusListPtr forgetfulList = stack->getBonuses(Selector::type(Bonus::FORGETFULL), BonusCacheKey::type(Bonus::FORGETFULL));
+		if(!forgetfulList->empty())
+			ret.forgetful = forgetfulList->valOfBonuses(Selector::type(Bonus::FORGETFULL));
+
+		ret.jousting = stack->hasBonusOfType(Bonus::JOUSTING);
+		ret.noDistancePenalty = stack->hasBonusOfType(Bonus::NO_DISTANCE_PENALTY);
+		ret.noWallPenalty = stack->hasBonusOfType(Bonus::NO_WALL_PENALTY);
+		ret.noMeleePenalty = stack->hasBonusOfType(Bonus::NO_MELEE_PENALTY);
+
+		TBonusListPtr curseEffects = stack->getBonuses(Selector::type(Bonus::ALWAYS_MINIMUM_DAMAGE));
+		TBonusListPtr blessEffects = stack->getBonuses(Selector::type(Bonus::ALWAYS_MAXIMUM_DAMAGE));
+		ret.curseCount = curseEffects->size();
+		ret.curseTotal = curseEffects->totalValue();
+		if(ret.curseCount)
+			ret.curseMaxPenalty = (*std::max_element(curseEffects->begin(), curseEffects->end(), &Bonus::compareByAdditionalInfo<std::shared_ptr<Bonus>>))->additionalInfo;
+		ret.blessCount = blessEffects->size();
+		ret.blessTotal = blessEffects->totalValue();
+
+		std::set<si32> hatedCreatures;
+		for(auto & b : *stack->getBonuses(Selector::type(Bonus::HATE)))
+			hatedCreatures.insert(b->subtype);
+		for(si32 hated : hatedCreatures)
+			ret.hate.push_back(std::make_pair(CreatureID(hated), stack->valOfBonuses(Bonus::HATE, hated)));
+
+		if(vstd::contains(stack->state, EBattleStackState::DEFENDING))
+			ret.defense[0] = ret.defense[1] = stack->Defense();
+		else
+		{
+			ret.defense[0] = stack->Defense();
+			ret.defense[1] = defenseInStance(stack);
+		}
+		ret.armorer = stack->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARMORER);
+
+		for(const auto & b : stack->getCreature()->getBonusList())
+		{
+			if(b->type == Bonus::KING1)
+				vstd::amin(ret.slayerLevelRequired, 0);
+			else if(b->type == Bonus::KING2)
+				vstd::amin(ret.slayerLevelRequired, 2);
+			else if(b->type == Bonus::KING3)
+				vstd::amin(ret.slayerLevelRequired, 3);
+		}
+
+		ret.chargeImmunity = stack->hasBonusOfType(Bonus::CHARGE_IMMUNITY);
+		ret.mindImmunity = stack->hasBonusOfType(Bonus::MIND_IMMUNITY);
+		ret.advancedAirShield = stack->hasBonus([](const Bonus * bonus)
+		{
+			return bonus->source == Bonus::SPELL_EFFECT
+					&& bonus->sid == SpellID::AIR_SHIELD
+					&& bonus->val >= SecSkillLevel::ADVANCED;
+		});
+
+		return ret;
+	}
+
+	BattleSnapshot::Unit makeUnit(const CStack * stack)
+	{
+		BattleSnapshot::Unit ret;
+		ret.position = stack->position;
+		ret.firstHPleft = stack->getFirstHPleft();
+		ret.fullUnits = stack->getCount() - (ret.firstHPleft > 0 ? 1 : 0);
+		ret.shots = stack->shots.available();
+		ret.retaliations = stack->counterAttacks.available();
+		ret.acted = stack->moved();
+		ret.waited = stack->waited();
+		ret.defending = vstd::contains(stack->state, EBattleStackState::DEFENDING);
+		return ret;
+	}
+}
+
+SnapshotAction::SnapshotAction()
+	: type(DEFEND), unit(0), target(0), destination(BattleHex::INVALID), chargedFields(0)
+{
+}
+
+SnapshotAction SnapshotAction::makeWait(ui8 unit)
+{
+	SnapshotAction ret;
+	ret.type = WAIT;
+	ret.unit = unit;
+	return ret;
+}
+
+SnapshotAction SnapshotAction::makeDefend(ui8 unit)
+{
+	SnapshotAction ret;
+	ret.type = DEFEND;
+	ret.unit = unit;
+	return ret;
+}
+
+SnapshotAction SnapshotAction::makeMove(ui8 unit, BattleHex destination)
+{
+	SnapshotAction ret;
+	ret.type = MOVE;
+	ret.unit = unit;
+	ret.destination = destination;
+	return ret;
+}
+
+SnapshotAction SnapshotAction::makeMeleeAttack(ui8 unit, ui8 target, BattleHex destination, si16 chargedFields)
+{
+	SnapshotAction ret;
+	ret.type = MELEE;
+	ret.unit = unit;
+	ret.target = target;
+	ret.destination = destination;
+	ret.chargedFields = chargedFields;
+	return ret;
+}
+
+SnapshotAction SnapshotAction::makeShotAttack(ui8 unit, ui8 target)
+{
+	SnapshotAction ret;
+	ret.type = SHOOT;
+	ret.unit = unit;
+	ret.target = target;
+	return ret;
+}
+
+BattleSnapshot::UnitInfo::UnitInfo()
+	: stack(nullptr), side(0), creature(CreatureID::NONE),
+	doubleWide(false), flying(false), canAct(false), clone(false), siegeWeapon(false), shooter(false),
+	freeShooting(false), blocksRetaliation(false), noRetaliation(false), unlimitedRetaliations(false),
+	speed(0), maxHealth(1), retaliationsPerRound(0), totalAttacks{1, 1},
+	minDamage(0), maxDamage(0), attack{0, 0}, attackReduction{0, 0}, enemyDefenceReduction{0, 0}, skillPremy{0, 0},
+	slayerLevel(-1), slayerPower(0), forgetful(-1), jousting(false), noDistancePenalty(false), noWallPenalty(false), noMeleePenalty(false),
+	curseCount(0), curseTotal(0), curseMaxPenalty(0), blessCount(0), blessTotal(0),
+	defense{0, 0}, armorer(0), damageReduction{0, 0}, slayerLevelRequired(std::numeric_limits<si32>::max()),
+	chargeImmunity(false), mindImmunity(false), advancedAirShield(false)
+{
+}
+
+BattleSnapshot::Unit::Unit()
+	: position(BattleHex::INVALID), firstHPleft(0), fullUnits(0), shots(0), retaliations(0), acted(false), waited(false), defending(false)
+{
+}
+
+BattleSnapshot::BattleSnapshot(const CBattleInfoCallback & cb)
+	: round(0), active(-1), lastMovedSide(0)
+{
+	auto state = std::make_shared<SharedState>();
+
+	auto stacks = cb.battleGetStacksIf([](const CStack * s)
+	{
+		return s->alive() && !s->isTurret();
+	});
+
+	std::vector<BattleHex> occupied;
+	for(const CStack * s : stacks)
+		range::copy(s->getHexes(), std::back_inserter(occupied));
+	state->terrain = cb.getAccesibility(occupied);
+
+	//obstacles as they are visible for our side
+	for(auto & obstacle : cb.battleGetAllObstacles())
+		for(BattleHex hex : obstacle->getStoppingTile())
+			if(hex.isValid())
+				state->stoppers.set(hex);
+
+	state->siege = cb.battleGetSiegeLevel() > 0;
+	for(int row = 0; row < GameConstants::BFIELD_HEIGHT; row++)
+		state->wallPenaltyInRow[row] = state->siege && !cb.isWallPartPotentiallyAttackable(cb.battleHexToWallPart(CBattleInfoCallback::lineToWallHex(row)));
+
+	const CStack * activeStack = cb.battleActiveStack();
+	for(const CStack * s : stacks)
+	{
+		if(s == activeStack)
+			active = units.size();
+		state->units.push_back(makeUnitInfo(s));
+		units.push_back(makeUnit(s));
+	}
+	shared = state;
+
+	if(activeStack)
+		lastMovedSide = activeStack->side;
+	if(active < 0)
+		nextActive();
+}
+
+int BattleSnapshot::indexOf(const CStack * stack) const
+{
+	for(size_t i = 0; i < units.size(); i++)
+		if(shared->units[i].stack == stack)
+			return i;
+	return -1;
+}
+
+si32 BattleSnapshot::getCount(ui8 unit) const
+{
+	return units[unit].fullUnits + (units[unit].firstHPleft > 0 ? 1 : 0);
+}
+
+si64 BattleSnapshot::availableHealth(ui8 unit) const
+{
+	return static_cast<si64>(units[unit].firstHPleft) + static_cast<si64>(shared->units[unit].maxHealth) * units[unit].fullUnits;
+}
+
+boost::optional<int> BattleSnapshot::isFinished() const
+{
+	bool hasStack[2] = {false, false};
+
+	for(size_t i = 0; i < units.size(); i++)
+		if(alive(i) && !shared->units[i].siegeWeapon)
+			hasStack[shared->units[i].side] = true;
+
+	if(!hasStack[0] && !hasStack[1])
+		return 2;
+	if(!hasStack[1])
+		return 0;
+	if(!hasStack[0])
+		return 1;
+	return boost::none;
+}
+
+BattleHex BattleSnapshot::occupiedHex(ui8 unit, BattleHex position) const
+{
+	const UnitInfo & unitInfo = shared->units[unit];
+	if(!unitInfo.doubleWide)
+		return BattleHex::INVALID;
+	return unitInfo.side == BattleSide::ATTACKER ? position - 1 : position + 1;
+}
+
+bool BattleSnapshot::coversPos(ui8 unit, BattleHex hex) const
+{
+	return units[unit].position == hex || occupiedHex(unit, units[unit].position) == hex;
+}
+
+ReachabilityInfo::TDistances BattleSnapshot::getDistances(ui8 unit) const
+{
+	const UnitInfo & unitInfo = shared->units[unit];
+	const BattleHex start = units[unit].position;
+
+	AccessibilityInfo accessibility = shared->terrain;
+	for(size_t other = 0; other < units.size(); other++)
+	{
+		if(other == unit || !alive(other))
+			continue;
+		accessibility[units[other].position] = EAccessibility::ALIVE_STACK;
+		const BattleHex second = occupiedHex(other, units[other].position);
+		if(second.isValid())
+			accessibility[second] = EAccessibility::ALIVE_STACK;
+	}
+
+	ReachabilityInfo::TDistances distances;
+	distances.fill(ReachabilityInfo::INFINITE_DIST);
+
+	if(unitInfo.flying)
+	{
+		for(int i = 0; i < GameConstants::BFIELD_SIZE; i++)
+			if(accessibility.accessible(i, unitInfo.doubleWide, unitInfo.side))
+				distances[i] = BattleHex::getDistance(start, i);
+		return distances;
+	}
+
+	//same as CBattleInfoCallback::makeBFS
+	std::array<BattleHex, GameConstants::BFIELD_SIZE> hexq;
+	size_t queueBegin = 0, queueEnd = 0;
+
+	hexq[queueEnd++] = start;
+	distances[start] = 0;
+
+	while(queueBegin != queueEnd)
+	{
+		const BattleHex curHex = hexq[queueBegin++];
+
+		if(curHex != start && shared->stoppers.test(curHex))
+			continue;
+
+		const int costToNeighbour = distances[curHex] + 1;
+		for(BattleHex neighbour : curHex.precomputedNeighbouringTiles())
+		{
+			if(!neighbour.isValid())
+				break;
+
+			if(costToNeighbour < distances[neighbour] && accessibility.accessible(neighbour, unitInfo.doubleWide, unitInfo.side))
+			{
+				hexq[queueEnd++] = neighbour;
+				distances[neighbour] = costToNeighbour;
+			}
+		}
+	}
+
+	return distances;
+}
+
+std::vector<BattleHex> BattleSnapshot::getAvailableHexes(ui8 unit, const ReachabilityInfo::TDistances & distances) const
+{
+	std::vector<BattleHex> ret;
+	for(int i = 0; i < GameConstants::BFIELD_SIZE; i++)
+		if(distances[i] <= shared->units[unit].speed)
+			ret.push_back(i);
+	return ret;
+}
+
+bool BattleSnapshot::isBlocked(ui8 unit) const
+{
+	const UnitInfo & unitInfo = shared->units[unit];
+	if(unitInfo.siegeWeapon)
+		return false;
+
+	const BattleHex hexes[] = {units[unit].position, occupiedHex(unit, units[unit].position)};
+	for(size_t enemy = 0; enemy < units.size(); enemy++)
+	{
+		if(!alive(enemy) || shared->units[enemy].side == unitInfo.side)
+			continue;
+
+		for(BattleHex hex : hexes)
+		{
+			if(!hex.isValid())
+				continue;
+			for(BattleHex neighbour : hex.precomputedNeighbouringTiles())
+			{
+				if(!neighbour.isValid())
+					break;
+				if(coversPos(enemy, neighbour))
+					return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool BattleSnapshot::canShoot(ui8 attacker, ui8 target) const
+{
+	const UnitInfo & attackerInfo = shared->units[attacker];
+
+	if(!attackerInfo.shooter || units[attacker].shots <= 0 || attackerInfo.creature == CreatureID::CATAPULT)
+		return false;
+	if(attackerInfo.forgetful > 1) //advanced+ forgetfulness
+		return false;
+	if(!alive(target) || shared->units[target].side == attackerInfo.side)
+		return false;
+
+	return attackerInfo.freeShooting || !isBlocked(attacker);
+}
+
+std::vector<SnapshotAction> BattleSnapshot::getPossibleActions() const
+{
+	std::vector<SnapshotAction> ret;
+	if(active < 0)
+		return ret;
+
+	const ui8 unit = active;
+	const UnitInfo & unitInfo = shared->units[unit];
+	const auto distances = getDistances(unit);
+	const auto hexes = getAvailableHexes(unit, distances);
+
+	for(size_t target = 0; target < units.size(); target++)
+	{
+		if(!alive(target) || shared->units[target].side == unitInfo.side)
+			continue;
+
+		if(canShoot(unit, target))
+		{
+			ret.push_back(SnapshotAction::makeShotAttack(unit, target));
+			continue;
+		}
+
+		for(BattleHex hex : hexes)
+		{
+			if(CStack::isMeleeAttackPossible(unitInfo.stack, shared->units[target].stack, hex, units[target].position))
+			{
+				const BattleHex destination = hex == units[unit].position ? BattleHex(BattleHex::INVALID) : hex;
+				ret.push_back(SnapshotAction::makeMeleeAttack(unit, target, destination, distances[hex]));
+			}
+		}
+	}
+
+	for(BattleHex hex : hexes)
+		if(hex != units[unit].position)
+			ret.push_back(SnapshotAction::makeMove(unit, hex));
+
+	if(!units[unit].waited)
+		ret.push_back(SnapshotAction::makeWait(unit));
+	ret.push_back(SnapshotAction::makeDefend(unit));
+
+	return ret;
+}
+
+bool BattleSnapshot::hasDistancePenalty(BattleHex shooterPosition, ui8 defender) const
+{
+	//if any hex of target creature is within range, there is no penalty
+	const BattleHex hexes[] = {units[defender].position, occupiedHex(defender, units[defender].position)};
+	for(BattleHex hex : hexes)
+		if(hex.isValid() && BattleHex::getDistance(shooterPosition, hex) <= GameConstants::BATTLE_PENALTY_DISTANCE)
+			return false;
+	return true;
+}
+
+bool BattleSnapshot::hasWallPenalty(ui8 attacker, BattleHex shooterPosition, BattleHex destHex) const
+{
+	//same as CBattleInfoCallback::battleHasWallPenalty with state of walls taken in advance
+	if(!shared->siege || shared->units[attacker].noWallPenalty)
+		return false;
+
+	const int row = CBattleInfoCallback::wallLineOfShot(shooterPosition, destHex);
+	return row >= 0 && shared->wallPenaltyInRow[row];
+}
+
+TDmgRange BattleSnapshot::estimateDamage(ui8 attacker, ui8 defender, bool shooting, int chargedFields, BattleHex attackerPosition) const
+{
+	const UnitInfo & att = shared->units[attacker];
+	const UnitInfo & def = shared->units[defender];
+	const int mode = shooting ? 1 : 0;
+
+	if(!attackerPosition.isValid())
+		attackerPosition = units[attacker].position;
+
+	DamageFormula formula;
+	formula.minDamage = att.minDamage * getCount(attacker);
+	formula.maxDamage = att.maxDamage * getCount(attacker);
+
+	formula.attack = att.attack[mode];
+	formula.attackReduction = att.attackReduction[mode];
+	formula.enemyDefenceReduction = att.enemyDefenceReduction[mode];
+	formula.defense = def.defense[units[defender].defending ? 1 : 0];
+	if(att.slayerLevel >= def.slayerLevelRequired)
+		formula.slayerPower = att.slayerPower;
+
+	if(att.jousting && !def.chargeImmunity)
+		formula.chargedFields = chargedFields;
+	formula.skillPremy = att.skillPremy[mode];
+	for(auto & hated : att.hate)
+		if(hated.first == def.creature)
+			formula.hate = hated.second;
+
+	formula.armorer = def.armorer;
+	formula.damageReduction = def.damageReduction[mode];
+
+	formula.curseCount = att.curseCount;
+	formula.curseTotal = att.curseTotal;
+	formula.curseMaxPenalty = att.curseMaxPenalty;
+	formula.blessCount = att.blessCount;
+	formula.blessTotal = att.blessTotal;
+
+	if(shooting)
+	{
+		if(att.forgetful == 0 || att.forgetful == 1)
+			formula.halvingPenalties++;
+		if((!att.noDistancePenalty && hasDistancePenalty(attackerPosition, defender)) || def.advancedAirShield)
+			formula.halvingPenalties++;
+		if(hasWallPenalty(attacker, attackerPosition, units[defender].position))
+			formula.halvingPenalties++;
+	}
+	else if(att.shooter && !att.noMeleePenalty)
+	{
+		formula.halvingPenalties++;
+	}
+
+	if(att.creature == CreatureID::PSYCHIC_ELEMENTAL && def.mindImmunity)
+		formula.halvingPenalties++;
+
+	return formula.calculate();
+}
+
+bool BattleSnapshot::canRetaliate(ui8 unit) const
+{
+	const UnitInfo & unitInfo = shared->units[unit];
+	return alive(unit)
+		&& !unitInfo.noRetaliation
+		&& (unitInfo.unlimitedRetaliations || units[unit].retaliations > 0);
+}
+
+void BattleSnapshot::damage(ui8 unit, si32 amount)
+{
+	if(amount <= 0)
+		return;
+
+	const UnitInfo & unitInfo = shared->units[unit];
+	Unit & state = units[unit];
+	const si64 remaining = availableHealth(unit) - amount;
+
+	if(unitInfo.clone || remaining <= 0)
+	{
+		state.firstHPleft = 0;
+		state.fullUnits = 0;
+		return;
+	}
+
+	//same as CHealth::setFromTotal
+	state.firstHPleft = remaining % unitInfo.maxHealth;
+	state.fullUnits = remaining / unitInfo.maxHealth;
+	if(state.firstHPleft == 0 && state.fullUnits >= 1)
+	{
+		state.firstHPleft = unitInfo.maxHealth;
+		state.fullUnits -= 1;
+	}
+}
+
+void BattleSnapshot::attack(ui8 attacker, ui8 defender, bool shooting, int chargedFields)
+{
+	const UnitInfo & attackerInfo = shared->units[attacker];
+
+	for(int i = 0; i < attackerInfo.totalAttacks[shooting ? 1 : 0]; i++)
+	{
+		if(!alive(attacker) || !alive(defender))
+			break;
+
+		if(shooting)
+		{
+			if(units[attacker].shots <= 0)
+				break;
+			units[attacker].shots--;
+		}
+
+		const TDmgRange dealt = estimateDamage(attacker, defender, shooting, chargedFields);
+		damage(defender, (dealt.first + dealt.second) / 2);
+
+		if(!shooting && !attackerInfo.blocksRetaliation && canRetaliate(defender))
+		{
+			const TDmgRange received = estimateDamage(defender, attacker, false, 0);
+			damage(attacker, (received.first + received.second) / 2);
+			if(!shared->units[defender].unlimitedRetaliations)
+				units[defender].retaliations--;
+		}
+	}
+}
+
+void BattleSnapshot::apply(const SnapshotAction & action)
+{
+	Unit & actor = units[action.unit];
+
+	switch(action.type)
+	{
+	case SnapshotAction::WAIT:
+		actor.waited = true;
+		break;
+	case SnapshotAction::DEFEND:
+		actor.defending = true;
+		actor.acted = true;
+		break;
+	case SnapshotAction::MOVE:
+		actor.position = action.destination;
+		actor.acted = true;
+		break;
+	case SnapshotAction::MELEE:
+		if(action.destination.isValid())
+			actor.position = action.destination;
+		actor.acted = true;
+		attack(action.unit, action.target, false, action.chargedFields);
+		break;
+	case SnapshotAction::SHOOT:
+		actor.acted = true;
+		attack(action.unit, action.target, true, 0);
+		break;
+	}
+
+	lastMovedSide = shared->units[action.unit].side;
+	nextActive();
+}
+
+void BattleSnapshot::nextActive()
+{
+	active = -1;
+	if(isFinished())
+		return;
+
+	//units that have not waited act first starting from the fastest, waiting ones act last starting from the slowest
+	//on equal speed side which has not moved last goes first
+	auto movesBefore = [this](size_t a, size_t b) -> bool
+	{
+		if(units[a].waited != units[b].waited)
+			return !units[a].waited;
+
+		const si32 speedA = shared->units[a].speed, speedB = shared->units[b].speed;
+		if(speedA != speedB)
+			return units[a].waited ? speedA < speedB : speedA > speedB;
+
+		return shared->units[a].side != lastMovedSide && shared->units[b].side == lastMovedSide;
+	};
+
+	for(int attempt = 0; attempt < 2; attempt++)
+	{
+		int best = -1;
+		for(size_t i = 0; i < units.size(); i++)
+		{
+			if(!alive(i) || !shared->units[i].canAct || units[i].acted)
+				continue;
+			if(best < 0 || movesBefore(i, best))
+				best = i;
+		}
+
+		if(best >= 0)
+		{
+			active = best;
+			units[best].defending = false; //defensive stance lasts until next turn of unit
+			return;
+		}
+
+		newRound();
+	}
+}
+
+void BattleSnapshot::newRound()
+{
+	round++;
+	for(size_t i = 0; i < units.size(); i++)
+	{
+		units[i].acted = false;
+		units[i].waited = false;
+		units[i].retaliations = shared->units[i].retaliationsPerRound;
+	}
+}
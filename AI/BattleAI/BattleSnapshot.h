@@ -0,0 +1,174 @@
+/*
+ * BattleSnapshot.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+#include "../../lib/battle/BattleHex.h"
+#include "../../lib/battle/AccessibilityInfo.h"
+#include "../../lib/battle/ReachabilityInfo.h"
+
+class CStack;
+class CBattleInfoCallback;
+
+/// Action that can be applied to BattleSnapshot, reduced form of BattleAction
+struct SnapshotAction
+{
+	enum EType : ui8
+	{
+		WAIT, DEFEND, MOVE, MELEE, SHOOT
+	};
+
+	EType type;
+	ui8 unit; //index of acting unit in snapshot
+	ui8 target; //index of attacked unit
+	BattleHex destination; //where unit moves before attack, INVALID if it attacks from current position
+	si16 chargedFields; //hexes travelled before melee attack (for jousting)
+
+	SnapshotAction();
+
+	static SnapshotAction makeWait(ui8 unit);
+	static SnapshotAction makeDefend(ui8 unit);
+	static SnapshotAction makeMove(ui8 unit, BattleHex destination);
+	static SnapshotAction makeMeleeAttack(ui8 unit, ui8 target, BattleHex destination, si16 chargedFields);
+	static SnapshotAction makeShotAttack(ui8 unit, ui8 target);
+};
+
+/// Compact copyable state of a battle used for searching ahead without touching game state or bonus system.
+/// Bonuses are aggregated once when snapshot is taken, only health, position and per-round state of units
+/// are copied together with snapshot; everything else is shared between copies.
+/// Arrow towers are not represented, morale, luck, spells and abilities other than handled below are ignored.
+class BattleSnapshot
+{
+public:
+	/// Properties of unit that do not change during simulation
+	struct UnitInfo
+	{
+		const CStack * stack;
+		ui8 side;
+		CreatureID creature;
+
+		bool doubleWide;
+		bool flying;
+		bool canAct; //false for passive war machines and disabled units
+		bool clone;
+		bool siegeWeapon;
+		bool shooter; //has SHOOTER bonus, does not mean there are shots left
+		bool freeShooting;
+		bool blocksRetaliation;
+		bool noRetaliation;
+		bool unlimitedRetaliations;
+
+		si32 speed;
+		si32 maxHealth;
+		si32 retaliationsPerRound;
+		si32 totalAttacks[2]; //index is 1 for shooting
+
+		//offence
+		double minDamage, maxDamage; //per creature, including war machine multiplier
+		si32 attack[2];
+		si32 attackReduction[2];
+		si32 enemyDefenceReduction[2];
+		si32 skillPremy[2]; //offence and archery
+		si32 slayerLevel; //-1 if not affected by slayer
+		si32 slayerPower;
+		si32 forgetful; //-1 if not affected
+		bool jousting;
+		bool noDistancePenalty;
+		bool noWallPenalty;
+		bool noMeleePenalty;
+		si32 curseCount, curseTotal, curseMaxPenalty;
+		si32 blessCount, blessTotal;
+		std::vector<std::pair<CreatureID, si32>> hate;
+
+		//defence
+		si32 defense[2]; //index is 1 when unit is in defensive stance
+		si32 armorer;
+		si32 damageReduction[2];
+		si32 slayerLevelRequired; //lowest slayer level affecting this creature, INT_MAX if none
+		bool chargeImmunity;
+		bool mindImmunity;
+		bool advancedAirShield;
+
+		UnitInfo();
+	};
+
+	/// Part of unit state that changes during simulation
+	struct Unit
+	{
+		BattleHex position;
+		si32 firstHPleft;
+		si32 fullUnits;
+		si32 shots;
+		si32 retaliations;
+		bool acted;
+		bool waited;
+		bool defending;
+
+		Unit();
+	};
+
+	explicit BattleSnapshot(const CBattleInfoCallback & cb);
+
+	size_t unitCount() const { return units.size(); }
+	const UnitInfo & info(ui8 unit) const { return shared->units[unit]; }
+	const Unit & unit(ui8 unit) const { return units[unit]; }
+	/// Returns index of unit representing given stack or -1
+	int indexOf(const CStack * stack) const;
+
+	bool alive(ui8 unit) const { return units[unit].firstHPleft > 0; }
+	si32 getCount(ui8 unit) const;
+	si64 availableHealth(ui8 unit) const;
+
+	/// Index of unit that will act next or -1 if battle is finished or nobody can act
+	int activeUnit() const { return active; }
+	si32 getRound() const { return round; }
+	/// Same meaning as CBattleInfoCallback::battleIsFinished
+	boost::optional<int> isFinished() const;
+
+	ReachabilityInfo::TDistances getDistances(ui8 unit) const;
+	/// Movement destinations within speed of unit, contains its current position
+	std::vector<BattleHex> getAvailableHexes(ui8 unit, const ReachabilityInfo::TDistances & distances) const;
+	bool canShoot(ui8 attacker, ui8 target) const;
+	bool isBlocked(ui8 unit) const;
+	/// All sensible actions of currently active unit
+	std::vector<SnapshotAction> getPossibleActions() const;
+
+	/// Same as CBattleInfoCallback::calculateDmgRange without luck (both use DamageFormula), using current state of both units
+	TDmgRange estimateDamage(ui8 attacker, ui8 defender, bool shooting, int chargedFields, BattleHex attackerPosition = BattleHex::INVALID) const;
+
+	/// Applies action of active unit, attacks are resolved with average damage
+	void apply(const SnapshotAction & action);
+
+private:
+	/// State shared between all copies of snapshot
+	struct SharedState
+	{
+		std::vector<UnitInfo> units;
+		AccessibilityInfo terrain; //accessibility without any units
+		std::bitset<GameConstants::BFIELD_SIZE> stoppers;
+		bool siege;
+		std::array<bool, GameConstants::BFIELD_HEIGHT> wallPenaltyInRow;
+	};
+
+	std::shared_ptr<const SharedState> shared;
+	std::vector<Unit> units;
+	si32 round;
+	si8 active;
+	ui8 lastMovedSide;
+
+	BattleHex occupiedHex(ui8 unit, BattleHex position) const;
+	bool coversPos(ui8 unit, BattleHex hex) const;
+	bool hasDistancePenalty(BattleHex shooterPosition, ui8 defender) const;
+	bool hasWallPenalty(ui8 attacker, BattleHex shooterPosition, BattleHex destHex) const;
+	bool canRetaliate(ui8 unit) const;
+
+	void attack(ui8 attacker, ui8 defender, bool shooting, int chargedFields);
+	void damage(ui8 unit, si32 amount);
+	void nextActive();
+	void newRound();
+};
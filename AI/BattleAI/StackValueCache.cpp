@@ -0,0 +1,60 @@
+/*
+ * StackValueCache.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "StackValueCache.h"
+
+StackValueCache::StackValueCache()
+	: reused(0)
+{
+}
+
+int StackValueCache::get(const CStack * stack, const std::vector<Bonus> & bonuses, const TEvaluator & evaluator)
+{
+	auto bonusesId = fingerprint(bonuses);
+	if(!bonusesId)
+		return evaluator();
+
+	const auto key = std::make_pair(stack, std::move(*bonusesId));
+	{
+		TLockGuard lock(mx);
+		auto it = values.find(key);
+		if(it != values.end())
+		{
+			reused++;
+			return it->second;
+		}
+	}
+
+	//evaluated without lock, other threads may compute the same value meanwhile but it will be equal
+	const int value = evaluator();
+
+	TLockGuard lock(mx);
+	values[key] = value;
+	return value;
+}
+
+int StackValueCache::reusedCount() const
+{
+	return reused;
+}
+
+boost::optional<std::vector<si32>> StackValueCache::fingerprint(const std::vector<Bonus> & bonuses)
+{
+	std::vector<si32> ret;
+	for(const Bonus & b : bonuses)
+	{
+		if(b.limiter || b.propagator)
+			return boost::none;
+
+		const si32 fields[] = {b.duration, b.turnsRemain, b.type, b.subtype, b.source, b.val, static_cast<si32>(b.sid), b.valType, b.additionalInfo, b.effectRange};
+		ret.insert(ret.end(), std::begin(fields), std::end(fields));
+	}
+	return ret;
+}
@@ -0,0 +1,36 @@
+/*
+ * StackValueCache.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+#include "../../lib/HeroBonus.h"
+
+class CStack;
+
+/// Remembers values of stacks under hypothetical spell effects, can be shared by threads evaluating spellcasts
+class StackValueCache
+{
+public:
+	typedef std::function<int()> TEvaluator;
+
+	StackValueCache();
+
+	/// Value of stack with given bonuses added, evaluator is called only if equal bonuses were not evaluated before
+	int get(const CStack * stack, const std::vector<Bonus> & bonuses, const TEvaluator & evaluator);
+	/// Number of values returned without calling evaluator
+	int reusedCount() const;
+
+	/// Identifies set of bonuses, equal sets give equal evaluation
+	/// Empty if some bonus has limiter or propagator, such bonuses can't be compared by value
+	static boost::optional<std::vector<si32>> fingerprint(const std::vector<Bonus> & bonuses);
+
+private:
+	boost::mutex mx;
+	std::map<std::pair<const CStack *, std::vector<si32>>, int> values;
+	std::atomic<int> reused;
+};
@@ -13,10 +13,10 @@
 
 
 const TBonusListPtr StackWithBonuses::getAllBonuses(const CSelector &selector, const CSelector &limit,
-							const CBonusSystemNode * root, const std::string & cachingStr) const
+							const CBonusSystemNode * root, const BonusCacheKey & cachingKey) const
 {
 	TBonusListPtr ret = std::make_shared<BonusList>();
-	const TBonusListPtr originalList = stack->getAllBonuses(selector, limit, root, cachingStr);
+	const TBonusListPtr originalList = stack->getAllBonuses(selector, limit, root, cachingKey);
 	range::copy(*originalList, std::back_inserter(*ret));
 	for(auto &bonus : bonusesToAdd)
 	{
@@ -27,3 +27,8 @@ const TBonusListPtr StackWithBonuses::getAllBonuses(const CSelector &selector, c
 	//TODO limiters?
 	return ret;
 }
+
+int64_t StackWithBonuses::getTreeVersion() const
+{
+	return stack->getTreeVersion();
+}
@@ -17,6 +17,7 @@
 #include "../../lib/CHeroHandler.h"
 #include "../../lib/CModHandler.h"
 #include "../../lib/CGameState.h"
+#include "../../lib/FogOfWarMap.h"
 #include "../../lib/NetPacks.h"
 #include "../../lib/serializer/CTypeList.h"
 #include "../../lib/serializer/BinarySerializer.h"
@@ -791,6 +792,9 @@ void VCAI::makeTurnInternal()
 
 	try
 	{
+		//most of goal evaluation queries paths of every hero, calculate them all at once
+		cb->precalculatePaths(cb->getHeroesInfo());
+
 		//Pick objects reserved in previous turn - we expect only nerby objects there
 		auto reservedHeroesCopy = reservedHeroesMap; //work on copy => the map may be changed while iterating (eg because hero died when attempting a goal)
 		for (auto hero : reservedHeroesCopy)
@@ -3112,19 +3116,12 @@ const SectorMap::TSectorID &SectorMap::retreiveTileN(const SectorMap::TSectorArr
 void SectorMap::clear()
 {
 	//TODO: rotate to [z][x][y]
-	auto fow = cb->getVisibilityMap();
-	//TODO: any magic to automate this? will need array->array conversion
-	//std::transform(fow.begin(), fow.end(), sector.begin(), [](const ui8 &f) -> unsigned short
-	//{
-	//	return f; //type conversion
-	//});
-	auto width = fow.size();
-	auto height = fow.front().size();
-	auto depth = fow.front().front().size();
-	for (size_t x = 0; x < width; x++)
-		for (size_t y = 0; y < height; y++ )
-			for (size_t z = 0; z < depth; z++)
-				sector[x][y][z] = fow[x][y][z];
+	const auto & fow = cb->getVisibilityMap();
+	const int3 sizes = fow.getSizes();
+	for (int x = 0; x < sizes.x; x++)
+		for (int y = 0; y < sizes.y; y++ )
+			for (int z = 0; z < sizes.z; z++)
+				sector[x][y][z] = fow.isVisible(int3(x, y, z));
 	valid = false;
 }
 
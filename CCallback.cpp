@@ -172,7 +172,7 @@ bool CCallback::buildBuilding(const CGTownInstance *town, BuildingID buildingID)
 	return true;
 }
 
-int CBattleCallback::battleMakeAction(BattleAction* action)
+int CClientBattleCallback::battleMakeAction(BattleAction* action)
 {
 	assert(action->actionType == Battle::HERO_SPELL);
 	MakeCustomAction mca(*action);
@@ -180,7 +180,7 @@ int CBattleCallback::battleMakeAction(BattleAction* action)
 	return 0;
 }
 
-int CBattleCallback::sendRequest(const CPack *request)
+int CClientBattleCallback::sendRequest(const CPack *request)
 {
 	int requestID = cl->sendRequest(request, *player);
 	if(waitTillRealize)
@@ -268,10 +268,8 @@ void CCallback::buildBoat( const IShipyard *obj )
 }
 
 CCallback::CCallback( CGameState * GS, boost::optional<PlayerColor> Player, CClient *C )
-	:CBattleCallback(GS, Player, C)
+	:CClientBattleCallback(GS, Player, C)
 {
-	waitTillRealize = false;
-	unlockGsWhenWaiting = false;
 }
 
 CCallback::~CCallback()
@@ -290,12 +288,17 @@ const CPathsInfo * CCallback::getPathsInfo(const CGHeroInstance *h)
 	return cl->getPathsInfo(h);
 }
 
+void CCallback::precalculatePaths(const std::vector<const CGHeroInstance *> & heroes)
+{
+	cl->precalculatePaths(heroes);
+}
+
 int3 CCallback::getGuardingCreaturePosition(int3 tile)
 {
 	if (!gs->map->isInTheMap(tile))
 		return int3(-1,-1,-1);
 
-	return gs->map->guardingCreaturePositions[tile.x][tile.y][tile.z];
+	return gs->map->guardingCreaturePositions[gs->map->getTileIndex(tile)];
 }
 
 void CCallback::calculatePaths( const CGHeroInstance *hero, CPathsInfo &out)
@@ -355,14 +358,12 @@ void CCallback::unregisterBattleInterface(std::shared_ptr<IBattleEventsReceiver>
 	cl->additionalBattleInts[*player] -= battleEvents;
 }
 
-CBattleCallback::CBattleCallback(CGameState *GS, boost::optional<PlayerColor> Player, CClient *C )
+CClientBattleCallback::CClientBattleCallback(CGameState *GS, boost::optional<PlayerColor> Player, CClient *C )
+	:CBattleCallback(GS, Player), cl(C)
 {
-	gs = GS;
-	player = Player;
-	cl = C;
 }
 
-bool CBattleCallback::battleMakeTacticAction( BattleAction * action )
+bool CClientBattleCallback::battleMakeTacticAction( BattleAction * action )
 {
 	assert(cl->gs->curB->tacticDistance);
 	MakeAction ma;
@@ -79,15 +79,28 @@ public:
 
 struct CPack;
 
+/// Battle callback given to battle interfaces, requests are sent to server by client or handled in process by battle simulator
 class CBattleCallback : public IBattleCallback, public CPlayerBattleCallback
 {
+protected:
+	CBattleCallback(CGameState *GS, boost::optional<PlayerColor> Player)
+	{
+		gs = GS;
+		player = Player;
+		waitTillRealize = false;
+		unlockGsWhenWaiting = false;
+	}
+};
+
+class CClientBattleCallback : public CBattleCallback
+{
 protected:
 	int sendRequest(const CPack *request); //returns requestID (that'll be matched to requestID in PackageApplied)
 	CClient *cl;
 	//virtual bool hasAccess(int playerId) const;
 
 public:
-	CBattleCallback(CGameState *GS, boost::optional<PlayerColor> Player, CClient *C);
+	CClientBattleCallback(CGameState *GS, boost::optional<PlayerColor> Player, CClient *C);
 	int battleMakeAction(BattleAction* action) override;//for casting spells by hero - DO NOT use it for moving active stack
 	bool battleMakeTacticAction(BattleAction * action) override; // performs tactic phase actions
 
@@ -95,7 +108,7 @@ public:
 	friend class CClient;
 };
 
-class CCallback : public CPlayerSpecificInfoCallback, public IGameActionCallback, public CBattleCallback
+class CCallback : public CPlayerSpecificInfoCallback, public IGameActionCallback, public CClientBattleCallback
 {
 public:
 	CCallback(CGameState * GS, boost::optional<PlayerColor> Player, CClient *C);
@@ -105,6 +118,7 @@ public:
 	virtual bool canMoveBetween(const int3 &a, const int3 &b);
 	virtual int3 getGuardingCreaturePosition(int3 tile);
 	virtual const CPathsInfo * getPathsInfo(const CGHeroInstance *h);
+	virtual void precalculatePaths(const std::vector<const CGHeroInstance *> & heroes); //fills paths cache for all given heroes at once
 
 	virtual void calculatePaths(const CGHeroInstance *hero, CPathsInfo &out);
 
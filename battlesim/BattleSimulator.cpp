@@ -0,0 +1,400 @@
+/*
+ * BattleSimulator.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "BattleSimulator.h"
+
+#include "../CCallback.h"
+#include "../lib/CGameState.h"
+#include "../lib/CGameInterface.h"
+#include "../lib/CStack.h"
+#include "../lib/CCreatureHandler.h"
+#include "../lib/CHeroHandler.h"
+#include "../lib/CArtHandler.h"
+#include "../lib/NetPacks.h"
+#include "../lib/StringConstants.h"
+#include "../lib/battle/BattleInfo.h"
+#include "../lib/mapping/CMap.h"
+#include "../lib/mapObjects/CGHeroInstance.h"
+#include "../lib/spells/CSpellHandler.h"
+
+namespace
+{
+	const PlayerColor SIDE_COLORS[2] = {PlayerColor(0), PlayerColor(1)};
+
+	si32 decodeOrThrow(si32 (*decode)(const std::string &), const JsonNode & node, const std::string & type)
+	{
+		const si32 ret = decode(node.String());
+		if(ret < 0)
+			throw std::runtime_error(boost::str(boost::format("Unknown %s '%s'") % type % node.String()));
+		return ret;
+	}
+
+	int findOrThrow(const std::vector<std::string> & names, const std::string & name, const std::string & type)
+	{
+		const int ret = vstd::find_pos(names, name);
+		if(ret < 0)
+			throw std::runtime_error(boost::str(boost::format("Unknown %s '%s'") % type % name));
+		return ret;
+	}
+
+	/// Value below which given fraction of sorted values lies
+	double percentile(const std::vector<double> & sorted, double fraction)
+	{
+		if(sorted.empty())
+			return 0;
+		const size_t index = std::min<size_t>(sorted.size() - 1, fraction * sorted.size());
+		return sorted[index];
+	}
+
+	/// In-process players have no client, so battle callback passes their requests directly to the simulator.
+	/// Callbacks are created for each battle after it is set up.
+	class SimulatorBattleCallback : public CBattleCallback
+	{
+		BattleSimulator & simulator;
+
+	public:
+		SimulatorBattleCallback(BattleSimulator & simulator, CGameState * GS, PlayerColor Player)
+			: CBattleCallback(GS, Player), simulator(simulator)
+		{
+			setBattle(GS->curB);
+		}
+
+		int battleMakeAction(BattleAction * action) override
+		{
+			assert(action->actionType == Battle::HERO_SPELL);
+			simulator.playerCustomAction(*player, *action);
+			return 0;
+		}
+
+		bool battleMakeTacticAction(BattleAction * action) override
+		{
+			assert(gs->curB->tacticDistance);
+			return simulator.playerTacticAction(*player, *action);
+		}
+	};
+}
+
+BattleSimulator::BattleSimulator(const JsonNode & spec)
+	: battlesFought(0), draws(0), rounds(0), wallTime(0)
+{
+	damageCacheStats = {0, 0, 0, 0};
+
+	if(!spec["seed"].isNull())
+		getRandomGenerator().setSeed(spec["seed"].Float());
+
+	const std::string & terrainName = spec["terrain"].isNull() ? GameConstants::TERRAIN_NAMES[ETerrainType::GRASS] : spec["terrain"].String();
+	const std::vector<std::string> terrainNames(std::begin(GameConstants::TERRAIN_NAMES), std::end(GameConstants::TERRAIN_NAMES));
+	terrain = ETerrainType(findOrThrow(terrainNames, terrainName, "terrain"));
+
+	const JsonVector & sidesConfig = spec["sides"].Vector();
+	if(sidesConfig.size() != 2)
+		throw std::runtime_error("Specification must contain exactly two sides");
+
+	gs = new CGameState();
+	gs->map = new CMap();
+
+	for(int i = 0; i < 2; i++)
+	{
+		const JsonNode & config = sidesConfig[i];
+		Side & side = sides[i];
+
+		side.color = SIDE_COLORS[i];
+		side.aiName = config["ai"].isNull() ? (i == 0 ? "BattleAI" : "StupidAI") : config["ai"].String();
+		side.hero = nullptr;
+
+		if(config["hero"].isNull())
+		{
+			side.army = new CArmedInstance();
+			side.army->tempOwner = side.color;
+			addObject(side.army);
+			addArmy(side.army, config["army"]);
+		}
+		else
+		{
+			side.hero = createHero(config["hero"], config["army"], side.color);
+			side.army = side.hero;
+			addObject(side.hero);
+		}
+
+		if(!side.army->stacksCount())
+			throw std::runtime_error(boost::str(boost::format("Army of side %d is empty") % i));
+		side.army->setFormation(config["tightFormation"].Bool());
+
+		stats[i].ai = side.aiName;
+		stats[i].wins = stats[i].escapes = stats[i].invalidActions = 0;
+	}
+}
+
+CGHeroInstance * BattleSimulator::createHero(const JsonNode & node, const JsonNode & army, PlayerColor color)
+{
+	auto hero = new CGHeroInstance();
+	hero->ID = Obj::HERO;
+	hero->tempOwner = color;
+	if(!node["experience"].isNull())
+		hero->exp = node["experience"].Float();
+
+	//hero without army receives default one on initialization
+	addArmy(hero, army);
+	hero->initHero(getRandomGenerator(), HeroTypeID(decodeOrThrow(&CHeroHandler::decodeHero, node["type"], "hero")));
+	hero->recreateSecondarySkillsBonuses();
+
+	const std::vector<std::string> primarySkills(std::begin(PrimarySkill::names), std::end(PrimarySkill::names));
+	for(const auto & skill : node["primarySkills"].Struct())
+	{
+		auto which = static_cast<PrimarySkill::PrimarySkill>(findOrThrow(primarySkills, skill.first, "primary skill"));
+		hero->setPrimarySkill(which, skill.second.Float(), true);
+	}
+
+	for(const auto & skill : node["secondarySkills"].Struct())
+	{
+		JsonNode skillName(JsonNode::DATA_STRING);
+		skillName.String() = skill.first;
+		const SecondarySkill which(decodeOrThrow(&CHeroHandler::decodeSkill, skillName, "secondary skill"));
+		hero->setSecSkillLevel(which, findOrThrow(NSecondarySkill::levels, skill.second.String(), "skill level"), true);
+	}
+
+	for(const JsonNode & spell : node["spells"].Vector())
+		hero->spells.insert(SpellID(decodeOrThrow(&CSpellHandler::decodeSpell, spell, "spell")));
+
+	if(!node["spells"].Vector().empty() && !hero->hasSpellbook())
+		hero->putArtifact(ArtifactPosition::SPELLBOOK, CArtifactInstance::createNewArtifactInstance(ArtifactID::SPELLBOOK));
+
+	return hero;
+}
+
+void BattleSimulator::addArmy(CArmedInstance * army, const JsonNode & node) const
+{
+	const JsonVector & stacks = node.Vector();
+	if(stacks.size() > GameConstants::ARMY_SIZE)
+		throw std::runtime_error("Army has too many stacks");
+
+	for(size_t i = 0; i < stacks.size(); i++)
+	{
+		const CreatureID creature(decodeOrThrow(&CCreatureHandler::decodeCreature, stacks[i]["type"], "creature"));
+		const TQuantity amount = stacks[i]["amount"].Float();
+		if(amount <= 0)
+			throw std::runtime_error("Stack amount must be positive");
+
+		army->putStack(SlotID(i), new CStackInstance(creature, amount));
+	}
+}
+
+void BattleSimulator::addObject(CGObjectInstance * obj)
+{
+	obj->id = ObjectInstanceID(gs->map->objects.size());
+	gs->map->objects.push_back(obj);
+}
+
+void BattleSimulator::run(int battles)
+{
+	const auto start = TClock::now();
+
+	for(int i = 0; i < battles; i++)
+	{
+		//obstacles are generated from battle tile
+		const int3 tile(getRandomGenerator().nextInt(0, 255), getRandomGenerator().nextInt(0, 255), 0);
+		fightBattle(tile);
+	}
+
+	wallTime += std::chrono::duration<double>(TClock::now() - start).count();
+}
+
+void BattleSimulator::fightBattle(int3 tile)
+{
+	const CArmedInstance * armies[2];
+	const CGHeroInstance * heroes[2];
+	for(int i = 0; i < 2; i++)
+	{
+		armies[i] = sides[i].army;
+		heroes[i] = sides[i].hero;
+		if(sides[i].hero)
+			sides[i].hero->mana = sides[i].hero->manaLimit();
+	}
+
+	BattleStart bs;
+	bs.info = BattleInfo::setupBattle(tile, terrain, BFieldType::NONE, armies, heroes, false, nullptr);
+	sendAndApply(&bs);
+
+	for(ui8 i = 0; i < 2; i++)
+	{
+		Side & side = sides[i];
+		side.ai = CDynLibHandler::getNewBattleAI(side.aiName);
+		side.cb = std::make_shared<SimulatorBattleCallback>(*this, gs, side.color);
+		side.ai->init(side.cb);
+	}
+
+	for(ui8 i = 0; i < 2; i++)
+		sides[i].ai->battleStart(armies[0], armies[1], tile, heroes[0], heroes[1], i);
+
+	runBattle();
+
+	for(auto & side : sides)
+	{
+		side.ai.reset();
+		side.cb.reset();
+	}
+}
+
+void BattleSimulator::askTacticPhaseActions()
+{
+	const ui8 side = gs->curB->tacticsSide;
+	sides[side].ai->yourTacticPhase(gs->curB->tacticDistance);
+
+	if(gs->curB->tacticDistance)
+	{
+		BattleAction end = BattleAction::makeEndOFTacticPhase(side);
+		makeBattleAction(end);
+	}
+}
+
+void BattleSimulator::askStackAction(const CStack * stack)
+{
+	const ui8 sideIndex = stack->side;
+	Side & side = sides[sideIndex];
+
+	const auto start = TClock::now();
+	BattleAction action = side.ai->activeStack(stack);
+	stats[sideIndex].latencies.push_back(std::chrono::duration<double, std::milli>(TClock::now() - start).count());
+
+	//spell cast while deciding could have finished battle or killed the stack
+	if(gs->curB->battleIsFinished() || !stack->alive())
+		return;
+
+	if(action.actionType == Battle::SURRENDER)
+	{
+		//there is no treasury to pay from, surrender is free
+		if(gs->curB->battleGetSurrenderCost(side.color) >= 0)
+		{
+			setBattleResult(BattleResult::SURRENDER, !sideIndex);
+			return;
+		}
+	}
+	else if(makeBattleAction(action))
+	{
+		return;
+	}
+
+	logGlobal->warn("%s made invalid action %d with %s, defending instead", side.aiName, action.actionType, stack->nodeName());
+	stats[sideIndex].invalidActions++;
+	BattleAction defend = BattleAction::makeDefend(stack);
+	makeBattleAction(defend);
+}
+
+bool BattleSimulator::playerTacticAction(PlayerColor player, BattleAction & action)
+{
+	const BattleInfo * b = gs->curB;
+	if(!b || !b->tacticDistance || b->sides[b->tacticsSide].color != player)
+		return false;
+	if(action.actionType != Battle::WALK && action.actionType != Battle::END_TACTIC_PHASE)
+		return false;
+
+	return makeBattleAction(action);
+}
+
+bool BattleSimulator::playerCustomAction(PlayerColor player, BattleAction & action)
+{
+	const BattleInfo * b = gs->curB;
+	if(!b || b->tacticDistance)
+		return false;
+	const CStack * active = b->battleGetStackByID(b->activeStack);
+	if(!active || active->owner != player || action.actionType != Battle::HERO_SPELL)
+		return false;
+
+	return makeCustomAction(action);
+}
+
+void BattleSimulator::endBattle(int3 tile, const CGHeroInstance * hero1, const CGHeroInstance * hero2)
+{
+	std::unique_ptr<BattleResult> result = takeBattleResult();
+
+	for(auto & side : sides)
+		side.ai->battleEnd(result.get());
+
+	battlesFought++;
+	rounds += std::max(gs->curB->round, 0);
+	if(result->winner > 1)
+	{
+		draws++;
+	}
+	else
+	{
+		stats[result->winner].wins++;
+		if(result->result != BattleResult::NORMAL)
+			stats[!result->winner].escapes++;
+	}
+
+	const DamageCache::Stats cache = gs->curB->battleDamageCacheStats();
+	damageCacheStats.hits += cache.hits;
+	damageCacheStats.misses += cache.misses;
+	damageCacheStats.invalidations += cache.invalidations;
+
+	//armies are reused by next battle, applying result only removes battle without casualties or experience
+	result->exp[0] = result->exp[1] = 0;
+	sendAndApply(result.get());
+}
+
+JsonNode BattleSimulator::getReport() const
+{
+	JsonNode ret(JsonNode::DATA_STRUCT);
+	ret["battles"].Integer() = battlesFought;
+	ret["draws"].Integer() = draws;
+	ret["averageRounds"].Float() = battlesFought ? double(rounds) / battlesFought : 0;
+	ret["wallTime"].Float() = wallTime;
+
+	for(const SideStats & side : stats)
+	{
+		std::vector<double> sorted = side.latencies;
+		boost::sort(sorted);
+		const double thinkingTime = std::accumulate(sorted.begin(), sorted.end(), 0.0) / 1000;
+
+		JsonNode node(JsonNode::DATA_STRUCT);
+		node["ai"].String() = side.ai;
+		node["wins"].Integer() = side.wins;
+		node["winRate"].Float() = battlesFought ? double(side.wins) / battlesFought : 0;
+		node["escapes"].Integer() = side.escapes;
+		node["decisions"].Integer() = sorted.size();
+		node["decisionsPerSecond"].Float() = thinkingTime > 0 ? sorted.size() / thinkingTime : 0;
+		node["invalidActions"].Integer() = side.invalidActions;
+		node["latency"]["p50"].Float() = percentile(sorted, 0.5);
+		node["latency"]["p90"].Float() = percentile(sorted, 0.9);
+		node["latency"]["p99"].Float() = percentile(sorted, 0.99);
+		node["latency"]["max"].Float() = sorted.empty() ? 0 : sorted.back();
+		ret["sides"].Vector().push_back(node);
+	}
+
+	const ui64 lookups = damageCacheStats.hits + damageCacheStats.misses;
+	ret["damageCache"]["hits"].Integer() = damageCacheStats.hits;
+	ret["damageCache"]["misses"].Integer() = damageCacheStats.misses;
+	ret["damageCache"]["invalidations"].Integer() = damageCacheStats.invalidations;
+	ret["damageCache"]["hitRate"].Float() = lookups ? double(damageCacheStats.hits) / lookups : 0;
+	return ret;
+}
+
+void BattleSimulator::printReport(std::ostream & out) const
+{
+	const JsonNode report = getReport();
+
+	out << boost::format("Battles: %d, draws: %d, average rounds: %.1f, wall time: %.2f s")
+		% report["battles"].Integer() % report["draws"].Integer() % report["averageRounds"].Float() % report["wallTime"].Float() << std::endl;
+
+	for(size_t i = 0; i < report["sides"].Vector().size(); i++)
+	{
+		const JsonNode & side = report["sides"].Vector()[i];
+		out << boost::format("Side %d (%s): %d wins (%.1f%%), %d escapes, %d invalid actions")
+			% i % side["ai"].String() % side["wins"].Integer() % (side["winRate"].Float() * 100) % side["escapes"].Integer() % side["invalidActions"].Integer() << std::endl;
+		out << boost::format("  %d decisions, %.1f decisions/s, latency p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms")
+			% side["decisions"].Integer() % side["decisionsPerSecond"].Float() % side["latency"]["p50"].Float()
+			% side["latency"]["p90"].Float() % side["latency"]["p99"].Float() % side["latency"]["max"].Float() << std::endl;
+	}
+
+	out << boost::format("Damage cache: %d hits, %d misses, %d invalidations (%.1f%% hit rate)")
+		% report["damageCache"]["hits"].Integer() % report["damageCache"]["misses"].Integer()
+		% report["damageCache"]["invalidations"].Integer() % (report["damageCache"]["hitRate"].Float() * 100) << std::endl;
+}
@@ -0,0 +1,78 @@
+/*
+ * BattleSimulator.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "../server/CGameHandler.h"
+#include "../lib/battle/DamageCache.h"
+
+class CBattleGameInterface;
+class CBattleCallback;
+
+/// Game handler fighting battles between two in-process battle AIs without client or network.
+/// Battle flow and action handling are the ones of server, players are asked for their actions directly.
+/// Armies are built once from JSON specification and reused by every battle, battle results are not applied to them.
+/// Hero specialties are not supported because they need hero placed on adventure map.
+class BattleSimulator : public CGameHandler
+{
+public:
+	struct SideStats
+	{
+		std::string ai;
+		ui32 wins;
+		ui32 escapes; //battles lost by retreat or surrender
+		ui32 invalidActions; //actions rejected by game handler, stack defended instead
+		std::vector<double> latencies; //time of each decision in milliseconds
+	};
+
+	/// Throws std::runtime_error if specification is not valid
+	explicit BattleSimulator(const JsonNode & spec);
+
+	/// Fights given number of battles, obstacles differ between battles
+	void run(int battles);
+
+	void printReport(std::ostream & out) const;
+	JsonNode getReport() const;
+
+	/// Requests of in-process players, validated like ones received from clients
+	bool playerTacticAction(PlayerColor player, BattleAction & action);
+	bool playerCustomAction(PlayerColor player, BattleAction & action);
+
+protected:
+	void askTacticPhaseActions() override;
+	void askStackAction(const CStack * stack) override;
+	void endBattle(int3 tile, const CGHeroInstance * hero1, const CGHeroInstance * hero2) override;
+
+private:
+	typedef std::chrono::steady_clock TClock;
+
+	struct Side
+	{
+		PlayerColor color;
+		std::string aiName;
+		CGHeroInstance * hero;
+		CArmedInstance * army;
+		std::shared_ptr<CBattleGameInterface> ai;
+		std::shared_ptr<CBattleCallback> cb;
+	};
+
+	std::array<Side, 2> sides;
+	std::array<SideStats, 2> stats;
+	ETerrainType terrain;
+	ui32 battlesFought;
+	ui32 draws;
+	ui64 rounds;
+	DamageCache::Stats damageCacheStats;
+	double wallTime; //seconds
+
+	void fightBattle(int3 tile);
+	CGHeroInstance * createHero(const JsonNode & node, const JsonNode & army, PlayerColor color);
+	void addArmy(CArmedInstance * army, const JsonNode & node) const;
+	void addObject(CGObjectInstance * obj);
+};
@@ -0,0 +1,111 @@
+/*
+ * main.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "BattleSimulator.h"
+
+#include <boost/program_options.hpp>
+
+#include "../lib/CConsoleHandler.h"
+#include "../lib/CConfigHandler.h"
+#include "../lib/VCMIDirs.h"
+#include "../lib/VCMI_Lib.h"
+#include "../lib/filesystem/Filesystem.h"
+#include "../lib/logging/CBasicLogConfigurator.h"
+
+namespace po = boost::program_options;
+
+std::atomic<bool> serverShuttingDown(false); //used by game handler, normally defined by server
+
+int main(int argc, char * argv[])
+{
+	po::options_description opts("Allowed options");
+	opts.add_options()
+		("help,h", "display help and exit")
+		("spec", po::value<std::string>(), "JSON file with armies and heroes of both sides")
+		("battles,n", po::value<int>(), "number of battles to fight, overrides value from specification")
+		("seed", po::value<int>(), "seed of random generator, overrides value from specification")
+		("report", po::value<std::string>(), "write report in JSON format to given file");
+
+	po::positional_options_description positional;
+	positional.add("spec", 1);
+
+	po::variables_map options;
+	try
+	{
+		po::store(po::command_line_parser(argc, argv).options(opts).positional(positional).run(), options);
+		po::notify(options);
+	}
+	catch(std::exception & e)
+	{
+		std::cerr << "Failure during parsing command-line options:\n" << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if(options.count("help") || !options.count("spec"))
+	{
+		std::cout << "Usage: vcmibattlesim [options] <spec>\n";
+		std::cout << "Fights battles between two battle AIs and reports win rates and decision latencies.\n";
+		std::cout << "Time limits of BattleAI are read from server section of settings.\n\n";
+		std::cout << opts;
+		return options.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	//paths given by user are relative to original working directory
+	const boost::filesystem::path specPath = boost::filesystem::system_complete(options["spec"].as<std::string>());
+	boost::filesystem::path reportPath;
+	if(options.count("report"))
+		reportPath = boost::filesystem::system_complete(options["report"].as<std::string>());
+
+	// Correct working dir executable folder (not bundle folder) so we can use executable relative paths
+	boost::filesystem::current_path(boost::filesystem::system_complete(argv[0]).parent_path());
+
+	console = new CConsoleHandler();
+	CBasicLogConfigurator logConfig(VCMIDirs::get().userCachePath() / "VCMI_BattleSim_log.txt", console);
+	logConfig.configureDefault();
+
+	preinitDLL(console);
+	settings.init();
+	logConfig.configure();
+	loadDLLClasses();
+
+	int ret = EXIT_SUCCESS;
+	try
+	{
+		std::ifstream file(specPath.string(), std::ios::binary);
+		if(!file)
+			throw std::runtime_error("Cannot open " + specPath.string());
+		const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		JsonNode spec(data.c_str(), data.size());
+		if(options.count("battles"))
+			spec["battles"].Float() = options["battles"].as<int>();
+		if(options.count("seed"))
+			spec["seed"].Float() = options["seed"].as<int>();
+
+		BattleSimulator simulator(spec);
+		simulator.run(spec["battles"].isNull() ? 1 : spec["battles"].Float());
+		simulator.printReport(std::cout);
+
+		if(!reportPath.empty())
+		{
+			std::ofstream report(reportPath.string());
+			report << simulator.getReport().toJson();
+		}
+	}
+	catch(std::exception & e)
+	{
+		logGlobal->error(e.what());
+		ret = EXIT_FAILURE;
+	}
+
+	vstd::clear_pointer(VLC);
+	CResourceHandler::clear();
+	return ret;
+}
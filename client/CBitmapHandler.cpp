@@ -10,6 +10,7 @@
 #include "StdInc.h"
 
 #include "../lib/filesystem/Filesystem.h"
+#include "../lib/filesystem/CResourceCache.h"
 #include "SDL.h"
 #include "SDL_image.h"
 #include "CBitmapHandler.h"
@@ -18,7 +19,7 @@
 
 namespace BitmapHandler
 {
-	SDL_Surface * loadH3PCX(ui8 * data, size_t size);
+	SDL_Surface * loadH3PCX(const ui8 * data, size_t size);
 
 	SDL_Surface * loadBitmapFromDir(std::string path, std::string fname, bool setKey=true);
 }
@@ -37,7 +38,7 @@ enum Epcxformat
 	PCX24B
 };
 
-SDL_Surface * BitmapHandler::loadH3PCX(ui8 * pcx, size_t size)
+SDL_Surface * BitmapHandler::loadH3PCX(const ui8 * pcx, size_t size)
 {
 	SDL_Surface * ret;
 
@@ -116,11 +117,11 @@ SDL_Surface * BitmapHandler::loadBitmapFromDir(std::string path, std::string fna
 
 	SDL_Surface * ret=nullptr;
 
-	auto readFile = CResourceHandler::get()->load(ResourceID(path + fname, EResType::IMAGE))->readAll();
+	auto readFile = CResourceHandler::getCache().load(ResourceID(path + fname, EResType::IMAGE));
 
-	if (isPCX(readFile.first.get()))
+	if (isPCX(readFile->data()))
 	{//H3-style PCX
-		ret = loadH3PCX(readFile.first.get(), readFile.second);
+		ret = loadH3PCX(readFile->data(), readFile->size());
 		if (ret)
 		{
 			if(ret->format->BytesPerPixel == 1  &&  setKey)
@@ -138,7 +139,7 @@ SDL_Surface * BitmapHandler::loadBitmapFromDir(std::string path, std::string fna
 	{ //loading via SDL_Image
 		ret = IMG_Load_RW(
 		          //create SDL_RW with our data (will be deleted by SDL)
-		          SDL_RWFromConstMem((void*)readFile.first.get(), readFile.second),
+		          SDL_RWFromConstMem(readFile->data(), readFile->size()),
 		          1); // mark it for auto-deleting
 		if (ret)
 		{
@@ -20,6 +20,7 @@
 
 #include "../lib/filesystem/Filesystem.h"
 #include "../lib/filesystem/FileStream.h"
+#include "../lib/filesystem/CResourceCache.h"
 #include "CPreGame.h"
 #include "windows/CCastleInterface.h"
 #include "../lib/CConsoleHandler.h"
@@ -310,6 +311,7 @@ int main(int argc, char * argv[])
 	// Init filesystem and settings
 	preinitDLL(::console);
 	settings.init();
+	CResourceHandler::getCache().setByteBudget(settings["general"]["resourceCacheSize"].Integer() * 1024 * 1024);
 	Settings session = settings.write["session"];
 	session["onlyai"].Bool() = vm.count("onlyAI");
 	if(vm.count("headless"))
@@ -649,6 +651,12 @@ void processCommand(const std::string &message)
 	{
 		GH.totalRedraw();
 	}
+	else if(cn=="resourcecache")
+	{
+		auto stats = CResourceHandler::getCache().getStats();
+		logGlobal->info("Resource cache: %d entries, %d of %d bytes used", stats.entries, stats.bytes, CResourceHandler::getCache().getByteBudget());
+		logGlobal->info("Hits: %d, misses: %d, evictions: %d", stats.hits, stats.misses, stats.evictions);
+	}
 	else if(cn=="screen")
 	{
 		std::cout << "Screenbuf points to ";
@@ -1247,6 +1255,14 @@ static void handleEvent(SDL_Event & ev)
 		case FULLSCREEN_TOGGLED:
 			fullScreenChanged();
 			break;
+		case SAVE_FAILED:
+			{
+				std::unique_ptr<std::string> error(reinterpret_cast<std::string *>(ev.user.data1));
+				boost::unique_lock<boost::recursive_mutex> lock(*CPlayerInterface::pim);
+				if(LOCPLINT)
+					LOCPLINT->showInfoDialog("Failed to save game: " + *error);
+			}
+			break;
 		default:
 			logGlobal->error("Unknown user event. Code %d", ev.user.code);
 			break;
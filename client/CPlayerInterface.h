@@ -75,7 +75,8 @@ enum
 	RETURN_TO_MENU_LOAD,
 	FULLSCREEN_TOGGLED,
 	PREPARE_RESTART_CAMPAIGN,
-	FORCE_QUIT //quit client without question
+	FORCE_QUIT, //quit client without question
+	SAVE_FAILED //data1 is std::string with error, owned by receiver
 };
 
 /// Central class for managing user interface logic
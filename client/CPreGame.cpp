@@ -31,6 +31,7 @@
 #include "../lib/serializer/CTypeList.h"
 #include "../lib/VCMIDirs.h"
 #include "../lib/mapping/CMap.h"
+#include "../lib/mapping/CMapInfoCache.h"
 #include "windows/GUIClasses.h"
 #include "CPlayerInterface.h"
 #include "../CCallback.h"
@@ -1117,75 +1118,61 @@ void SelectionTab::parseMaps(const std::unordered_set<ResourceID> &files)
 {
 	logGlobal->debug("Parsing %d maps", files.size());
 	allItems.clear();
-	for(auto & file : files)
+	auto infos = CMapInfoCache::scan(VCMIDirs::get().userCachePath() / "mapInfoCache.bin", CGI->modh->getActiveModsChecksum(), files, [](CMapInfo & mapInfo, const ResourceID & file)
 	{
-		try
-		{
-			CMapInfo mapInfo;
-			mapInfo.mapInit(file.getName());
+		mapInfo.mapInit(file.getName());
+	});
 
-			// ignore unsupported map versions (e.g. WoG maps without WoG)
-			// but accept VCMI maps
-			if((mapInfo.mapHeader->version >= EMapFormat::VCMI) || (mapInfo.mapHeader->version <= CGI->modh->settings.data["textData"]["mapVersion"].Float()))
-				allItems.push_back(std::move(mapInfo));
-		}
-		catch(std::exception & e)
-		{
-			logGlobal->error("Map %s is invalid. Message: %s", file.getName(), e.what());
-		}
+	for(auto & mapInfo : infos)
+	{
+		// ignore unsupported map versions (e.g. WoG maps without WoG)
+		// but accept VCMI maps
+		if((mapInfo.mapHeader->version >= EMapFormat::VCMI) || (mapInfo.mapHeader->version <= CGI->modh->settings.data["textData"]["mapVersion"].Float()))
+			allItems.push_back(std::move(mapInfo));
 	}
 }
 
 void SelectionTab::parseGames(const std::unordered_set<ResourceID> &files, CMenuScreen::EGameMode gameMode)
 {
-	for(auto & file : files)
+	auto infos = CMapInfoCache::scan(VCMIDirs::get().userCachePath() / "saveInfoCache.bin", CGI->modh->getActiveModsChecksum(), files, [](CMapInfo & mapInfo, const ResourceID & file)
 	{
-		try
-		{
-			CLoadFile lf(*CResourceHandler::get()->getResourceName(file), MINIMAL_SERIALIZATION_VERSION);
-			lf.checkMagicBytes(SAVEGAME_MAGIC);
-// 			ui8 sign[8];
-// 			lf >> sign;
-// 			if(std::memcmp(sign,"VCMISVG",7))
-// 			{
-// 				throw std::runtime_error("not a correct savefile!");
-// 			}
-
-			// Create the map info object
-			CMapInfo mapInfo;
-			mapInfo.mapHeader = make_unique<CMapHeader>();
-			mapInfo.scenarioOpts = nullptr;//to be created by serialiser
-			lf >> *(mapInfo.mapHeader.get()) >> mapInfo.scenarioOpts;
-			mapInfo.fileURI = file.getName();
-			mapInfo.countPlayers();
-			std::time_t time = boost::filesystem::last_write_time(*CResourceHandler::get()->getResourceName(file));
-			mapInfo.date = std::asctime(std::localtime(&time));
-
-			// Filter out other game modes
-			bool isCampaign = mapInfo.scenarioOpts->mode == StartInfo::CAMPAIGN;
-			bool isMultiplayer = mapInfo.actualHumanPlayers > 1;
-			switch(gameMode)
-			{
-			case CMenuScreen::SINGLE_PLAYER:
-				if(isMultiplayer || isCampaign)
-					mapInfo.mapHeader.reset();
-				break;
-			case CMenuScreen::SINGLE_CAMPAIGN:
-				if(!isCampaign)
-					mapInfo.mapHeader.reset();
-				break;
-			default:
-				if(!isMultiplayer)
-					mapInfo.mapHeader.reset();
-				break;
-			}
+		CLoadFile lf(*CResourceHandler::get()->getResourceName(file), MINIMAL_SERIALIZATION_VERSION);
+		lf.checkMagicBytes(SAVEGAME_MAGIC);
 
-			allItems.push_back(std::move(mapInfo));
-		}
-		catch(const std::exception & e)
+		// Create the map info object
+		mapInfo.mapHeader = make_unique<CMapHeader>();
+		mapInfo.scenarioOpts = nullptr;//to be created by serialiser
+		lf >> *(mapInfo.mapHeader.get()) >> mapInfo.scenarioOpts;
+		mapInfo.fileURI = file.getName();
+		mapInfo.countPlayers();
+	});
+
+	for(auto & mapInfo : infos)
+	{
+		// std::localtime is not thread safe, so date is not filled by parallel parser
+		std::time_t time = boost::filesystem::last_write_time(*CResourceHandler::get()->getResourceName(ResourceID(mapInfo.fileURI, EResType::CLIENT_SAVEGAME)));
+		mapInfo.date = std::asctime(std::localtime(&time));
+
+		// Filter out other game modes
+		bool isCampaign = mapInfo.scenarioOpts->mode == StartInfo::CAMPAIGN;
+		bool isMultiplayer = mapInfo.actualHumanPlayers > 1;
+		switch(gameMode)
 		{
-			logGlobal->error("Error: Failed to process %s: %s", file.getName(), e.what());
+		case CMenuScreen::SINGLE_PLAYER:
+			if(isMultiplayer || isCampaign)
+				mapInfo.mapHeader.reset();
+			break;
+		case CMenuScreen::SINGLE_CAMPAIGN:
+			if(!isCampaign)
+				mapInfo.mapHeader.reset();
+			break;
+		default:
+			if(!isMultiplayer)
+				mapInfo.mapHeader.reset();
+			break;
 		}
+
+		allItems.push_back(std::move(mapInfo));
 	}
 }
 
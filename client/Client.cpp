@@ -34,6 +34,7 @@
 #include "../lib/serializer/CTypeList.h"
 #include "../lib/serializer/Connection.h"
 #include "../lib/serializer/CLoadIntegrityValidator.h"
+#include "../lib/serializer/CSaveBuffer.h"
 #ifndef VCMI_ANDROID
 #include "../lib/Interprocess.h"
 #endif
@@ -119,7 +120,9 @@ void CClient::init()
 		TLockGuard _(connectionHandlerMutex);
 		connectionHandler.reset();
 	}
-	pathInfo = nullptr;
+	pathfinder.reset();
+	pathsCache.clear();
+	saveWriter = make_unique<CBackgroundSaveWriter>();
 	applier = new CApplier<CBaseForCLApply>();
 	registerTypesClientPacks1(*applier);
 	registerTypesClientPacks2(*applier);
@@ -261,6 +264,7 @@ void CClient::loadGame(const std::string & fname, const bool server, const std::
 {
 	PlayerColor player(player_); //intentional shadowing
 	logNetwork->info("Loading procedure started!");
+	saveWriter->wait(); //save may be just being written
 
 	CServerHandler sh;
 	if(server)
@@ -298,7 +302,7 @@ void CClient::loadGame(const std::string & fname, const bool server, const std::
 		logNetwork->info("Loaded common part of save %d ms", tmh.getDiff());
 		const_cast<CGameInfo*>(CGI)->mh = new CMapHandler();
 		const_cast<CGameInfo*>(CGI)->mh->map = gs->map;
-		pathInfo = make_unique<CPathsInfo>(getMapSize());
+		resetPaths();
 		CGI->mh->init();
 		logNetwork->info("Initing maphandler: %d ms", tmh.getDiff());
 	}
@@ -445,7 +449,7 @@ void CClient::newGame( CConnection *con, StartInfo *si )
 			logNetwork->info("Creating mapHandler: %d ms", tmh.getDiff());
 			CGI->mh->init();
 		}
-		pathInfo = make_unique<CPathsInfo>(getMapSize());
+		resetPaths();
 		logNetwork->info("Initializing mapHandler (together): %d ms", tmh.getDiff());
 	}
 
@@ -862,22 +866,92 @@ void CClient::commenceTacticPhaseForInt(std::shared_ptr<CBattleGameInterface> ba
 	}
 }
 
+void CClient::resetPaths()
+{
+	boost::unique_lock<boost::mutex> cacheLock(pathsCacheMx);
+	pathsCache.clear();
+	pathfinder = make_unique<CPathfinderService>(gs, VLC->modh->settings.MAX_HEROES_ON_MAP_PER_PLAYER);
+}
+
+std::shared_ptr<CPathsInfo> CClient::getPathsBuffer(const CGHeroInstance * h)
+{
+	boost::unique_lock<boost::mutex> cacheLock(pathsCacheMx);
+	auto it = boost::find_if(pathsCache, [h](const TCachedPaths & entry)
+	{
+		return entry.first == h;
+	});
+
+	if(it != pathsCache.end())
+	{
+		pathsCache.splice(pathsCache.begin(), pathsCache, it);
+	}
+	else if(pathsCache.size() < static_cast<size_t>(VLC->modh->settings.MAX_HEROES_ON_MAP_PER_PLAYER))
+	{
+		pathsCache.push_front(std::make_pair(h, pathfinder->acquire()));
+	}
+	else
+	{
+		// recalculate least recently used buffer in place so pointers given out earlier stay valid
+		pathsCache.splice(pathsCache.begin(), pathsCache, std::prev(pathsCache.end()));
+		pathsCache.front().first = h;
+	}
+	return pathsCache.front().second;
+}
+
 void CClient::invalidatePaths()
 {
 	// turn pathfinding info into invalid. It will be regenerated later
-	boost::unique_lock<boost::mutex> pathLock(pathInfo->pathMx);
-	pathInfo->hero = nullptr;
+	boost::unique_lock<boost::mutex> cacheLock(pathsCacheMx);
+	for(auto & entry : pathsCache)
+	{
+		boost::unique_lock<boost::mutex> pathLock(entry.second->pathMx);
+		entry.second->hero = nullptr;
+		entry.second->changedTiles.clear();
+	}
+}
+
+void CClient::invalidatePaths(const std::unordered_set<int3, ShashInt3> & changedTiles)
+{
+	boost::unique_lock<boost::mutex> cacheLock(pathsCacheMx);
+	for(auto & entry : pathsCache)
+	{
+		boost::unique_lock<boost::mutex> pathLock(entry.second->pathMx);
+		if(entry.second->hero)
+			entry.second->changedTiles.insert(changedTiles.begin(), changedTiles.end());
+	}
 }
 
 const CPathsInfo * CClient::getPathsInfo(const CGHeroInstance *h)
 {
 	assert(h);
-	boost::unique_lock<boost::mutex> pathLock(pathInfo->pathMx);
-	if (pathInfo->hero != h)
+	auto paths = getPathsBuffer(h);
+	boost::unique_lock<boost::mutex> pathLock(paths->pathMx);
+	if (paths->hero != h)
+	{
+		gs->calculatePaths(h, *paths);
+	}
+	else if(!paths->changedTiles.empty())
+	{
+		gs->repairPaths(h, *paths);
+	}
+	return paths.get();
+}
+
+void CClient::precalculatePaths(const std::vector<const CGHeroInstance *> & heroes)
+{
+	//more heroes than cache can hold would just evict each other
+	const size_t count = std::min<size_t>(heroes.size(), VLC->modh->settings.MAX_HEROES_ON_MAP_PER_PLAYER);
+
+	std::vector<CPathfinderService::TJob> jobs;
+	for(size_t i = 0; i < count; i++)
 	{
-		gs->calculatePaths(h, *pathInfo.get());
+		auto h = heroes[i];
+		auto paths = getPathsBuffer(h);
+		boost::unique_lock<boost::mutex> pathLock(paths->pathMx);
+		if(paths->hero != h || !paths->changedTiles.empty())
+			jobs.push_back(std::make_pair(h, paths.get()));
 	}
-	return pathInfo.get();
+	pathfinder->calculatePaths(jobs);
 }
 
 int CClient::sendRequest(const CPack *request, PlayerColor player)
@@ -950,7 +1024,7 @@ void CClient::installNewBattleInterface(std::shared_ptr<CBattleGameInterface> ba
 	if(needCallback)
 	{
 		logGlobal->trace("\tInitializing the battle interface for player %s", *color);
-		auto cbc = std::make_shared<CBattleCallback>(gs, color, this);
+		auto cbc = std::make_shared<CClientBattleCallback>(gs, color, this);
 		battleCallbacks[colorUsed] = cbc;
 		battleInterface->init(cbc);
 	}
@@ -31,6 +31,8 @@ struct SharedMemory;
 class CClient;
 class CScriptingModule;
 struct CPathsInfo;
+class CPathfinderService;
+class CBackgroundSaveWriter;
 class BinaryDeserializer;
 class BinarySerializer;
 namespace boost { class thread; }
@@ -122,7 +124,14 @@ public:
 /// Class which handles client - server logic
 class CClient : public IGameCallback
 {
-	std::unique_ptr<CPathsInfo> pathInfo;
+	typedef std::pair<const CGHeroInstance *, std::shared_ptr<CPathsInfo>> TCachedPaths;
+
+	std::unique_ptr<CPathfinderService> pathfinder;
+	std::list<TCachedPaths> pathsCache; //most recently used first, buffers are reused in place
+	boost::mutex pathsCacheMx;
+
+	std::shared_ptr<CPathsInfo> getPathsBuffer(const CGHeroInstance * h);
+	void resetPaths();
 public:
 	std::map<PlayerColor,std::shared_ptr<CCallback> > callbacks; //callbacks given to player interfaces
 	std::map<PlayerColor,std::shared_ptr<CBattleCallback> > battleCallbacks; //callbacks given to player interfaces
@@ -168,11 +177,14 @@ public:
 	void proposeNextMission(std::shared_ptr<CCampaignState> camp);
 
 	void invalidatePaths();
+	void invalidatePaths(const std::unordered_set<int3, ShashInt3> & changedTiles); //paths will be repaired around given tiles if possible
 	const CPathsInfo * getPathsInfo(const CGHeroInstance *h);
+	void precalculatePaths(const std::vector<const CGHeroInstance *> & heroes); //calculates paths of all heroes in parallel
 
 	bool terminate;	// tell to terminate
 	std::unique_ptr<boost::thread> connectionHandler; //thread running run() method
 	boost::mutex connectionHandlerMutex;
+	std::unique_ptr<CBackgroundSaveWriter> saveWriter; //writes saves ordered by server without blocking network thread
 
 	//////////////////////////////////////////////////////////////////////////
 	virtual PlayerColor getLocalPlayer() const override;
@@ -234,7 +246,7 @@ public:
 
 	//////////////////////////////////////////////////////////////////////////
 	friend class CCallback; //handling players actions
-	friend class CBattleCallback; //handling players actions
+	friend class CClientBattleCallback; //handling players actions
 
 	int sendRequest(const CPack *request, PlayerColor player); //returns ID given to that request
 
@@ -18,6 +18,7 @@
 #include "CGameInfo.h"
 #include "../lib/serializer/Connection.h"
 #include "../lib/serializer/BinarySerializer.h"
+#include "../lib/serializer/CSaveBuffer.h"
 #include "../lib/CGeneralTextHandler.h"
 #include "../lib/CHeroHandler.h"
 #include "../lib/VCMI_Lib.h"
@@ -111,6 +112,25 @@
 	}																					\
 	BATTLE_INTERFACE_CALL_RECEIVERS(function, __VA_ARGS__)
 
+/// Tiles which pathfinding may depend on given object: ones it occupies and ones it may guard
+static std::unordered_set<int3, ShashInt3> getAffectedTiles(CClient * cl, const CGObjectInstance * obj)
+{
+	std::unordered_set<int3, ShashInt3> tiles;
+	for(const int3 & pos : obj->getBlockedPos())
+	{
+		for(int dx = -1; dx <= 1; dx++)
+		{
+			for(int dy = -1; dy <= 1; dy++)
+			{
+				const int3 tile = pos + int3(dx, dy, 0);
+				if(cl->isInTheMap(tile))
+					tiles.insert(tile);
+			}
+		}
+	}
+	return tiles;
+}
+
 void SetResources::applyCl(CClient *cl)
 {
 	//todo: inform on actual resource set transfered
@@ -183,7 +203,7 @@ void FoWChange::applyCl(CClient *cl)
 				i.second->tileHidden(tiles);
 		}
 	}
-	cl->invalidatePaths();
+	cl->invalidatePaths(tiles);
 }
 
 void SetAvailableHeroes::applyCl(CClient *cl)
@@ -261,6 +281,9 @@ void HeroVisit::applyCl(CClient *cl)
 void NewTurn::applyCl(CClient *cl)
 {
 	cl->invalidatePaths();
+
+	for(auto & creatureSet : cres)
+		creatureSet.second.requestResyncIfMissed(cl);
 }
 
 
@@ -342,6 +365,8 @@ void PrepareForAdvancingCampaign::applyCl(CClient *cl)
 void RemoveObject::applyFirstCl(CClient *cl)
 {
 	const CGObjectInstance *o = cl->getObj(id);
+	if(o->ID != Obj::HERO)
+		affectedTiles = getAffectedTiles(cl, o);
 
 	if(CGI->mh)
 		CGI->mh->hideObject(o, true);
@@ -356,7 +381,11 @@ void RemoveObject::applyFirstCl(CClient *cl)
 
 void RemoveObject::applyCl(CClient *cl)
 {
-	cl->invalidatePaths();
+	//removed hero may be one of the cached ones
+	if(affectedTiles.empty())
+		cl->invalidatePaths();
+	else
+		cl->invalidatePaths(affectedTiles);
 }
 
 void TryMoveHero::applyFirstCl(CClient *cl)
@@ -387,7 +416,15 @@ void TryMoveHero::applyFirstCl(CClient *cl)
 void TryMoveHero::applyCl(CClient *cl)
 {
 	const CGHeroInstance *h = cl->getHero(id);
-	cl->invalidatePaths();
+	if(result == SUCCESS && !attackedFrom)
+	{
+		auto changedTiles = fowRevealed;
+		changedTiles.insert(start - int3(1, 0, 0));
+		changedTiles.insert(end - int3(1, 0, 0));
+		cl->invalidatePaths(changedTiles);
+	}
+	else
+		cl->invalidatePaths();
 
 	if(CGI->mh)
 	{
@@ -439,8 +476,22 @@ void RazeStructures::applyCl (CClient *cl)
 	}
 }
 
+void SetAvailableCreatures::requestResyncIfMissed(CClient *cl) const
+{
+	const CGDwelling *dw = static_cast<const CGDwelling*>(cl->getObj(tid));
+	if(!version || dw->creaturesVersion == version)
+		return;
+
+	logNetwork->warn("Missed update of creatures in dwelling %d, requesting full state", tid.getNum());
+	RequestAvailableCreatures request;
+	request.tid = tid;
+	cl->sendRequest(&request, cl->getLocalPlayer());
+}
+
 void SetAvailableCreatures::applyCl(CClient *cl)
 {
+	requestResyncIfMissed(cl);
+
 	const CGDwelling *dw = static_cast<const CGDwelling*>(cl->getObj(tid));
 
 	//inform order about the change
@@ -807,9 +858,19 @@ void SaveGame::applyCl(CClient *cl)
 
 	try
 	{
-		CSaveFile save(*CResourceHandler::get()->getResourceName(ResourceID(stem.to_string(), EResType::CLIENT_SAVEGAME)));
-		cl->saveCommonState(save);
-		save << *cl;
+		auto save = make_unique<CSaveBuffer>();
+		cl->saveCommonState(*save);
+		*save << *cl;
+		//network thread may wait for writer while holding interface mutex, so failure is passed to GUI thread
+		cl->saveWriter->write(std::move(save), *CResourceHandler::get()->getResourceName(ResourceID(stem.to_string(), EResType::CLIENT_SAVEGAME)),
+			[](const std::string & error)
+		{
+			SDL_Event event;
+			event.type = SDL_USEREVENT;
+			event.user.code = SAVE_FAILED;
+			event.user.data1 = new std::string(error);
+			SDL_PushEvent(&event);
+		});
 	}
 	catch(std::exception &e)
 	{
@@ -918,9 +979,9 @@ void CenterView::applyCl(CClient *cl)
 
 void NewObject::applyCl(CClient *cl)
 {
-	cl->invalidatePaths();
-
 	const CGObjectInstance *obj = cl->getObj(id);
+	cl->invalidatePaths(getAffectedTiles(cl, obj));
+
 	if(CGI->mh)
 		CGI->mh->printObject(obj, true);
 
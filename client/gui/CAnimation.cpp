@@ -18,6 +18,7 @@
 #include "../gui/SDL_Pixels.h"
 
 #include "../lib/filesystem/Filesystem.h"
+#include "../lib/filesystem/CResourceCache.h"
 #include "../lib/filesystem/ISimpleResourceLoader.h"
 #include "../lib/JsonNode.h"
 #include "../lib/CRandomGenerator.h"
@@ -49,7 +50,9 @@ private:
 	//offset[group][frame] - offset of frame data in file
 	std::map<size_t, std::vector <size_t> > offset;
 
-	std::unique_ptr<ui8[]>       data;
+	/// shared content of def file, parsed in place
+	std::shared_ptr<const CCachedResource> resource;
+	const ui8 *                  data;
 	std::unique_ptr<SDL_Color[]> palette;
 
 public:
@@ -206,50 +209,6 @@ public:
 	~CompImageLoader();
 };
 
-// Extremely simple file cache. TODO: smarter, more general solution
-class CFileCache
-{
-	static const int cacheSize = 50; //Max number of cached files
-	struct FileData
-	{
-		ResourceID             name;
-		size_t                 size;
-		std::unique_ptr<ui8[]> data;
-
-		std::unique_ptr<ui8[]> getCopy()
-		{
-			auto ret = std::unique_ptr<ui8[]>(new ui8[size]);
-			std::copy(data.get(), data.get() + size, ret.get());
-			return ret;
-		}
-		FileData(ResourceID name_, size_t size_, std::unique_ptr<ui8[]> data_):
-			name{std::move(name_)},
-			size{size_},
-			data{std::move(data_)}
-		{}
-	};
-
-	std::deque<FileData> cache;
-public:
-	std::unique_ptr<ui8[]> getCachedFile(ResourceID rid)
-	{
-		for(auto & file : cache)
-		{
-			if (file.name == rid)
-				return file.getCopy();
-		}
-		// Still here? Cache miss
-		if (cache.size() > cacheSize)
-			cache.pop_front();
-
-		auto data =  CResourceHandler::get()->load(rid)->readAll();
-
-		cache.emplace_back(std::move(rid), data.second, std::move(data.first));
-
-		return cache.back().getCopy();
-	}
-};
-
 enum class DefType : uint32_t
 {
 	SPELL = 0x40,
@@ -264,8 +223,6 @@ enum class DefType : uint32_t
 	BATTLE_HERO = 0x49
 };
 
-static CFileCache animationCache;
-
 /*************************************************************************
  *  DefFile, class used for def loading                                  *
  *************************************************************************/
@@ -306,17 +263,18 @@ CDefFile::CDefFile(std::string Name):
 		{   0,   0,   0, 128},//  50% - shadow body   below selection
 		{   0,   0,   0,  64} // 75% - shadow border below selection
 	};
-	data = animationCache.getCachedFile(ResourceID(std::string("SPRITES/") + Name, EResType::ANIMATION));
+	resource = CResourceHandler::getCache().load(ResourceID(std::string("SPRITES/") + Name, EResType::ANIMATION));
+	data = resource->data();
 
 	palette = std::unique_ptr<SDL_Color[]>(new SDL_Color[256]);
 	int it = 0;
 
-	ui32 type = read_le_u32(data.get() + it);
+	ui32 type = read_le_u32(data + it);
 	it+=4;
 	//int width  = read_le_u32(data + it); it+=4;//not used
 	//int height = read_le_u32(data + it); it+=4;
 	it+=8;
-	ui32 totalBlocks = read_le_u32(data.get() + it);
+	ui32 totalBlocks = read_le_u32(data + it);
 	it+=4;
 
 	for (ui32 i= 0; i<256; i++)
@@ -382,9 +340,9 @@ CDefFile::CDefFile(std::string Name):
 
 	for (ui32 i=0; i<totalBlocks; i++)
 	{
-		size_t blockID = read_le_u32(data.get() + it);
+		size_t blockID = read_le_u32(data + it);
 		it+=4;
-		size_t totalEntries = read_le_u32(data.get() + it);
+		size_t totalEntries = read_le_u32(data + it);
 		it+=12;
 		//8 unknown bytes - skipping
 
@@ -393,7 +351,7 @@ CDefFile::CDefFile(std::string Name):
 
 		for (ui32 j=0; j<totalEntries; j++)
 		{
-			size_t currOffset = read_le_u32(data.get() + it);
+			size_t currOffset = read_le_u32(data + it);
 			offset[blockID].push_back(currOffset);
 			it += 4;
 		}
@@ -407,7 +365,7 @@ void CDefFile::loadFrame(size_t frame, size_t group, ImageLoader &loader) const
 	it = offset.find(group);
 	assert (it != offset.end());
 
-	const ui8 * FDef = data.get()+it->second[frame];
+	const ui8 * FDef = data+it->second[frame];
 
 	const SSpriteDef sd = * reinterpret_cast<const SSpriteDef *>(FDef);
 	SSpriteDef sprite;
@@ -40,7 +40,7 @@
 #include "../mapHandler.h"
 
 
-const TBonusListPtr CHeroWithMaybePickedArtifact::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root, const std::string & cachingStr) const
+const TBonusListPtr CHeroWithMaybePickedArtifact::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root, const BonusCacheKey & cachingKey) const
 {
 	TBonusListPtr out(new BonusList());
 	TBonusListPtr heroBonuses = hero->getAllBonuses(selector, limit, hero);
@@ -61,6 +61,11 @@ const TBonusListPtr CHeroWithMaybePickedArtifact::getAllBonuses(const CSelector
 	return out;
 }
 
+int64_t CHeroWithMaybePickedArtifact::getTreeVersion() const
+{
+	return hero->getTreeVersion();  //this assumes that hero and artifact belongs to main bonus tree
+}
+
 CHeroWithMaybePickedArtifact::CHeroWithMaybePickedArtifact(CWindowWithArtifacts *Cww, const CGHeroInstance *Hero)
 	:  hero(Hero), cww(Cww)
 {
@@ -724,8 +724,8 @@ void CArtHandler::afterLoadFinalization()
 			assert(bonus->source == Bonus::ARTIFACT);
 			bonus->sid = art->id;
 		}
+		art->nodeHasChanged();
 	}
-	CBonusSystemNode::treeHasChanged();
 }
 
 si32 CArtHandler::decodeArfifact(const std::string& identifier)
@@ -148,7 +148,7 @@ void CCreature::setId(CreatureID ID)
 		if(bonus->source == Bonus::CREATURE_ABILITY)
 			bonus->sid = ID;
 	}
-	CBonusSystemNode::treeHasChanged();
+	nodeHasChanged();
 }
 
 void CCreature::fillWarMachine()
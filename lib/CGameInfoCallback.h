@@ -27,6 +27,7 @@ class CGDwelling;
 class CGTeleport;
 class CMapHeader;
 struct TeamState;
+class FogOfWarMap;
 struct QuestInfo;
 class int3;
 
@@ -138,7 +139,7 @@ public:
 
 	int getResourceAmount(Res::ERes type) const;
 	TResources getResourceAmount() const;
-	const std::vector< std::vector< std::vector<ui8> > > & getVisibilityMap()const; //returns visibility map
+	const FogOfWarMap & getVisibilityMap()const; //returns visibility map
 	const PlayerSettings * getPlayerSettings(PlayerColor color) const;
 };
 
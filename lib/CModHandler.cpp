@@ -853,6 +853,19 @@ std::vector<std::string> CModHandler::getActiveMods()
 	return activeMods;
 }
 
+ui32 CModHandler::getActiveModsChecksum() const
+{
+	boost::crc_32_type checksum;
+	checksum.process_bytes(reinterpret_cast<const void *>(&coreMod.checksum), sizeof(coreMod.checksum));
+	for(const TModID & modName : activeMods)
+	{
+		const ui32 modChecksum = allMods.at(modName).checksum;
+		checksum.process_bytes(reinterpret_cast<const void *>(modName.data()), modName.size());
+		checksum.process_bytes(reinterpret_cast<const void *>(&modChecksum), sizeof(modChecksum));
+	}
+	return checksum.checksum();
+}
+
 static JsonNode genDefaultFS()
 {
 	// default FS config for mods: directory "Content" that acts as H3 root directory
@@ -261,6 +261,8 @@ public:
 	/// returns list of all (active) mods
 	std::vector<std::string> getAllMods();
 	std::vector<std::string> getActiveMods();
+	/// checksum of active mods in their load order, changes whenever any of them is added, removed or modified
+	ui32 getActiveModsChecksum() const;
 
 	/// load content from all available mods
 	void load();
@@ -17,6 +17,7 @@
 #include "GameConstants.h"
 #include "CStopWatch.h"
 #include "CConfigHandler.h"
+#include "CThreadHelper.h"
 #include "../lib/CPlayerState.h"
 
 CPathfinder::PathfinderOptions::PathfinderOptions()
@@ -34,10 +35,17 @@ CPathfinder::PathfinderOptions::PathfinderOptions()
 	lightweightFlyingMode = settings["pathfinder"]["lightweightFlyingMode"].Bool();
 	oneTurnSpecialLayersLimit = settings["pathfinder"]["oneTurnSpecialLayersLimit"].Bool();
 	originalMovementRules = settings["pathfinder"]["originalMovementRules"].Bool();
+	useBucketQueue = settings["pathfinder"]["engine"].String() == "bucketQueue";
+	incremental = settings["pathfinder"]["incremental"].Bool();
 }
 
 CPathfinder::CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstance * _hero)
-	: CGameInfoCallback(_gs, boost::optional<PlayerColor>()), out(_out), hero(_hero), FoW(getPlayerTeam(hero->tempOwner)->fogOfWarMap), patrolTiles({})
+	: CPathfinder(_out, _gs, _hero, PathfinderOptions())
+{
+}
+
+CPathfinder::CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstance * _hero, const PathfinderOptions & _options)
+	: CGameInfoCallback(_gs, boost::optional<PlayerColor>()), options(_options), out(_out), hero(_hero), FoW(getPlayerTeam(hero->tempOwner)->fogOfWarMap), patrolTiles({})
 {
 	assert(hero);
 	assert(hero == getHero(hero->id));
@@ -46,10 +54,9 @@ CPathfinder::CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstan
     ct = dt = nullptr;
     ctObj = dtObj = nullptr;
     destAction = CGPathNode::UNKNOWN;
+	repairing = false;
 
-	out.hero = hero;
-	out.hpos = hero->getPosition(false);
-	if(!isInTheMap(out.hpos)/* || !gs->map->isInTheMap(dest)*/) //check input
+	if(!isInTheMap(hero->getPosition(false))/* || !gs->map->isInTheMap(dest)*/) //check input
 	{
 		logGlobal->error("CGameState::calculatePaths: Hero outside the gs->map? How dare you...");
 		throw std::runtime_error("Wrong checksum");
@@ -57,13 +64,185 @@ CPathfinder::CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstan
 
 	hlp = make_unique<CPathfinderHelper>(hero, options);
 
-	initializePatrol();
-	initializeGraph();
 	neighbourTiles.reserve(8);
 	neighbours.reserve(16);
 }
 
 void CPathfinder::calculatePaths()
+{
+	out.hero = hero;
+	out.hpos = hero->getPosition(false);
+	out.changedTiles.clear();
+
+	initializePatrol();
+	initializeGraph();
+
+	//logGlobal->info("Calculating paths for hero %s (adress  %d) of player %d", hero->name, hero , hero->tempOwner);
+
+	//initial tile - set cost on 0 and add to the queue
+	CGPathNode * initialNode = out.getNode(out.hpos, hero->boat ? ELayer::SAIL : ELayer::LAND);
+	initialNode->turns = 0;
+	initialNode->moveRemains = hero->movement;
+	if(isHeroPatrolLocked())
+		return;
+
+	pushNode(initialNode);
+	processQueue();
+}
+
+bool CPathfinder::repairPaths()
+{
+	if(!options.incremental || out.hero != hero)
+		return false;
+
+	initializePatrol();
+	if(patrolState != PATROL_NONE)
+		return false;
+
+	//when a lot changed it's faster to start from scratch
+	if(out.changedTiles.size() > static_cast<size_t>(out.sizes.x * out.sizes.y / 4))
+		return false;
+
+	const int3 heroPos = hero->getPosition(false);
+	const bool moved = heroPos != out.hpos;
+	CGPathNode * root = out.getNode(heroPos, hero->boat ? ELayer::SAIL : ELayer::LAND);
+	if(root->turns != 0 || root->moveRemains != hero->movement)
+		return false;
+
+	if(moved)
+	{
+		//hero must stand on node from which paths were expanded, nodes reached through it stay valid
+		if(!root->locked || root->action == CGPathNode::BATTLE)
+			return false;
+	}
+	else if(vstd::contains(out.changedTiles, heroPos))
+	{
+		return false;
+	}
+
+	enum ENodeState : ui8
+	{
+		UNKNOWN = 0,
+		VALID,
+		INVALID,
+		SEED
+	};
+
+	CGPathNode * const firstNode = out.nodes.data();
+	const size_t nodesCount = out.nodes.num_elements();
+	std::vector<ui8> state(nodesCount, UNKNOWN);
+	auto stateOf = [&](const CGPathNode * node) -> ui8 &
+	{
+		return state[node - firstNode];
+	};
+
+	for(const int3 & tile : out.changedTiles)
+	{
+		for(ELayer layer = ELayer::LAND; layer < ELayer::NUM_LAYERS; layer.advance(1))
+			stateOf(out.getNode(tile, layer)) = INVALID;
+	}
+	stateOf(root) = VALID;
+
+	//node is valid only if none of nodes on the way to it changed
+	std::vector<CGPathNode *> chain;
+	for(size_t i = 0; i < nodesCount; i++)
+	{
+		CGPathNode * node = firstNode + i;
+		ui8 result = UNKNOWN;
+		chain.clear();
+		while(result == UNKNOWN)
+		{
+			result = stateOf(node);
+			if(result != UNKNOWN)
+				break;
+
+			chain.push_back(node);
+			if(!node->reachable())
+				result = VALID;
+			else if(!node->theNodeBefore)
+				result = INVALID; //initial node of previous calculation
+			else
+				node = node->theNodeBefore;
+		}
+		for(auto chainNode : chain)
+			stateOf(chainNode) = result;
+	}
+
+	for(const int3 & tile : out.changedTiles)
+		initializeTile(tile);
+
+	std::vector<CGPathNode *> seeds;
+	auto addSeed = [&](CGPathNode * node)
+	{
+		auto & nodeState = stateOf(node);
+		if(nodeState == VALID && node->locked)
+		{
+			nodeState = SEED;
+			seeds.push_back(node);
+		}
+	};
+
+	std::vector<int3> tiles;
+	for(size_t i = 0; i < nodesCount; i++)
+	{
+		CGPathNode * node = firstNode + i;
+		if(state[i] != INVALID || node->layer == ELayer::WRONG)
+			continue;
+
+		if(!vstd::contains(out.changedTiles, node->coord))
+		{
+			auto accessible = node->accessible;
+			node->reset();
+			node->accessible = accessible;
+		}
+
+		//valid nodes around have to be expanded again to reach this one
+		tiles.clear();
+		CPathfinderHelper::getNeighbours(gs->map, gs->map->getTile(node->coord), node->coord, tiles, boost::logic::indeterminate, false);
+		for(const int3 & tile : tiles)
+		{
+			for(ELayer layer = ELayer::LAND; layer < ELayer::NUM_LAYERS; layer.advance(1))
+				addSeed(out.getNode(tile, layer));
+		}
+	}
+
+	//teleports may lead to any of invalidated nodes
+	for(const CGObjectInstance * obj : gs->map->objects)
+	{
+		if(obj && (dynamic_cast<const CGTeleport *>(obj) || (options.useCastleGate && obj->ID == Obj::TOWN)))
+		{
+			for(ELayer layer = ELayer::LAND; layer < ELayer::NUM_LAYERS; layer.advance(1))
+				addSeed(out.getNode(obj->visitablePos(), layer));
+		}
+	}
+
+	out.hpos = heroPos;
+	out.changedTiles.clear();
+	if(moved)
+	{
+		//hero tile was initialized again as it's changed, restore it as initial node
+		root->turns = 0;
+		root->moveRemains = hero->movement;
+		root->theNodeBefore = nullptr;
+		root->action = CGPathNode::UNKNOWN;
+		root->locked = true;
+		stateOf(root) = VALID;
+		addSeed(root);
+	}
+
+	repairing = true;
+	for(auto seed : seeds)
+	{
+		seed->locked = false;
+		pushNode(seed);
+	}
+	processQueue();
+	repairing = false;
+
+	return true;
+}
+
+void CPathfinder::processQueue()
 {
 	auto passOneTurnLimitCheck = [&]() -> bool
 	{
@@ -95,20 +274,11 @@ void CPathfinder::calculatePaths()
 		return false;
 	};
 
-	//logGlobal->info("Calculating paths for hero %s (adress  %d) of player %d", hero->name, hero , hero->tempOwner);
-
-	//initial tile - set cost on 0 and add to the queue
-	CGPathNode * initialNode = out.getNode(out.hpos, hero->boat ? ELayer::SAIL : ELayer::LAND);
-	initialNode->turns = 0;
-	initialNode->moveRemains = hero->movement;
-	if(isHeroPatrolLocked())
-		return;
-
-	pq.push(initialNode);
-	while(!pq.empty())
+	while(!isQueueEmpty())
 	{
-		cp = pq.top();
-		pq.pop();
+		cp = topAndPopNode();
+		if(cp->locked)
+			continue; //duplicate entry, node was already expanded with same or better cost
 		cp->locked = true;
 
 		int movement = cp->moveRemains, turn = cp->turns;
@@ -142,7 +312,7 @@ void CPathfinder::calculatePaths()
 					continue;
 
 				dp = out.getNode(neighbour, i);
-				if(dp->locked)
+				if(dp->locked && !repairing)
 					continue;
 
 				if(dp->accessible == CGPathNode::NOT_SET)
@@ -179,13 +349,14 @@ void CPathfinder::calculatePaths()
 					((cp->turns == turnAtNextTile && remains) || passOneTurnLimitCheck()))
 				{
 					assert(dp != cp->theNodeBefore); //two tiles can't point to each other
+					dp->locked = false; //only when repairing: node got better way and have to be expanded again
 					dp->moveRemains = remains;
 					dp->turns = turnAtNextTile;
 					dp->theNodeBefore = cp;
 					dp->action = destAction;
 
 					if(isMovementAfterDestPossible())
-						pq.push(dp);
+						pushNode(dp);
 				}
 			}
 		} //neighbours loop
@@ -195,7 +366,7 @@ void CPathfinder::calculatePaths()
 		for(auto & neighbour : neighbours)
 		{
 			dp = out.getNode(neighbour, cp->layer);
-			if(dp->locked)
+			if(dp->locked && !repairing)
 				continue;
 			/// TODO: We may consider use invisible exits on FoW border in future
 			/// Useful for AI when at least one tile around exit is visible and passable
@@ -209,17 +380,41 @@ void CPathfinder::calculatePaths()
 			{
 				dtObj = gs->map->getTile(neighbour).topVisitableObj();
 
+				dp->locked = false;
 				dp->moveRemains = movement;
 				dp->turns = turn;
 				dp->theNodeBefore = cp;
 				dp->action = getTeleportDestAction();
 				if(dp->action == CGPathNode::TELEPORT_NORMAL)
-					pq.push(dp);
+					pushNode(dp);
 			}
 		}
 	} //queue loop
 }
 
+void CPathfinder::pushNode(CGPathNode * node)
+{
+	if(options.useBucketQueue)
+		bucketQueue.push(node);
+	else
+		pq.push(node);
+}
+
+CGPathNode * CPathfinder::topAndPopNode()
+{
+	if(options.useBucketQueue)
+		return bucketQueue.pop();
+
+	auto node = pq.top();
+	pq.pop();
+	return node;
+}
+
+bool CPathfinder::isQueueEmpty() const
+{
+	return options.useBucketQueue ? bucketQueue.empty() : pq.empty();
+}
+
 void CPathfinder::addNeighbours()
 {
 	neighbours.clear();
@@ -673,48 +868,54 @@ void CPathfinder::initializePatrol()
 
 void CPathfinder::initializeGraph()
 {
-	auto updateNode = [&](int3 pos, ELayer layer, const TerrainTile * tinfo)
-	{
-		auto node = out.getNode(pos, layer);
-		auto accessibility = evaluateAccessibility(pos, tinfo, layer);
-		node->update(pos, layer, accessibility);
-	};
-
+	//same order as map tiles are stored
 	int3 pos;
-	for(pos.x=0; pos.x < out.sizes.x; ++pos.x)
+	for(pos.z=0; pos.z < out.sizes.z; ++pos.z)
 	{
 		for(pos.y=0; pos.y < out.sizes.y; ++pos.y)
 		{
-			for(pos.z=0; pos.z < out.sizes.z; ++pos.z)
+			for(pos.x=0; pos.x < out.sizes.x; ++pos.x)
 			{
-				const TerrainTile * tinfo = &gs->map->getTile(pos);
-				switch(tinfo->terType)
-				{
-				case ETerrainType::ROCK:
-					break;
-
-				case ETerrainType::WATER:
-					updateNode(pos, ELayer::SAIL, tinfo);
-					if(options.useFlying)
-						updateNode(pos, ELayer::AIR, tinfo);
-					if(options.useWaterWalking)
-						updateNode(pos, ELayer::WATER, tinfo);
-					break;
-
-				default:
-					updateNode(pos, ELayer::LAND, tinfo);
-					if(options.useFlying)
-						updateNode(pos, ELayer::AIR, tinfo);
-					break;
-				}
+				initializeTile(pos);
 			}
 		}
 	}
 }
 
+void CPathfinder::initializeTile(const int3 & pos)
+{
+	auto updateNode = [&](ELayer layer, const TerrainTile * tinfo)
+	{
+		auto node = out.getNode(pos, layer);
+		auto accessibility = evaluateAccessibility(pos, tinfo, layer);
+		node->update(pos, layer, accessibility);
+	};
+
+	const TerrainTile * tinfo = &gs->map->getTile(pos);
+	switch(tinfo->terType)
+	{
+	case ETerrainType::ROCK:
+		break;
+
+	case ETerrainType::WATER:
+		updateNode(ELayer::SAIL, tinfo);
+		if(options.useFlying)
+			updateNode(ELayer::AIR, tinfo);
+		if(options.useWaterWalking)
+			updateNode(ELayer::WATER, tinfo);
+		break;
+
+	default:
+		updateNode(ELayer::LAND, tinfo);
+		if(options.useFlying)
+			updateNode(ELayer::AIR, tinfo);
+		break;
+	}
+}
+
 CGPathNode::EAccessibility CPathfinder::evaluateAccessibility(const int3 & pos, const TerrainTile * tinfo, const ELayer layer) const
 {
-	if(tinfo->terType == ETerrainType::ROCK || !FoW[pos.x][pos.y][pos.z])
+	if(tinfo->terType == ETerrainType::ROCK || !FoW.isVisible(pos))
 		return CGPathNode::BLOCKED;
 
 	switch(layer)
@@ -859,10 +1060,7 @@ TurnInfo::BonusCache::BonusCache(TBonusListPtr bl)
 TurnInfo::TurnInfo(const CGHeroInstance * Hero, const int turn)
 	: hero(Hero), maxMovePointsLand(-1), maxMovePointsWater(-1)
 {
-	std::stringstream cachingStr;
-	cachingStr << "days_" << turn;
-
-	bonuses = hero->getAllBonuses(Selector::days(turn), nullptr, nullptr, cachingStr.str());
+	bonuses = hero->getAllBonuses(Selector::days(turn), nullptr, nullptr, BonusCacheKey().days(turn));
 	bonusCache = make_unique<BonusCache>(bonuses);
 	nativeTerrain = hero->getNativeTerrain();
 }
@@ -1174,6 +1372,69 @@ void CGPath::convert(ui8 mode)
 	}
 }
 
+CPathNodeBucketQueue::CPathNodeBucketQueue()
+	: count(0), currentTurn(0), currentRemains(-1)
+{
+}
+
+void CPathNodeBucketQueue::push(CGPathNode * node)
+{
+	const size_t turn = node->turns;
+	const int remains = node->moveRemains;
+
+	if(buckets.size() <= turn)
+		buckets.resize(turn + 1);
+	auto & turnBuckets = buckets[turn];
+	if(turnBuckets.size() <= static_cast<size_t>(remains))
+		turnBuckets.resize(remains + 1);
+
+	turnBuckets[remains].push_back(node);
+	count++;
+
+	if(turn < currentTurn || (turn == currentTurn && remains > currentRemains))
+	{
+		currentTurn = turn;
+		currentRemains = remains;
+	}
+}
+
+CGPathNode * CPathNodeBucketQueue::pop()
+{
+	assert(!empty());
+	while(currentRemains < 0 || buckets[currentTurn][currentRemains].empty())
+	{
+		if(currentRemains < 0)
+		{
+			currentTurn++;
+			currentRemains = buckets[currentTurn].size();
+		}
+		currentRemains--;
+	}
+
+	auto & bucket = buckets[currentTurn][currentRemains];
+	CGPathNode * node = bucket.back();
+	bucket.pop_back();
+	count--;
+	return node;
+}
+
+bool CPathNodeBucketQueue::empty() const
+{
+	return count == 0;
+}
+
+void CPathNodeBucketQueue::clear()
+{
+	for(auto & turnBuckets : buckets)
+	{
+		for(auto & bucket : turnBuckets)
+			bucket.clear();
+	}
+	count = 0;
+	currentTurn = 0;
+	currentRemains = -1;
+}
+
 CPathsInfo::CPathsInfo(const int3 & Sizes)
 	: sizes(Sizes)
 {
@@ -1237,3 +1498,105 @@ CGPathNode * CPathsInfo::getNode(const int3 & coord, const ELayer layer)
 {
 	return &nodes[coord.x][coord.y][coord.z][layer];
 }
+
+struct CPathfinderService::Pool
+{
+	boost::mutex mx;
+	int3 sizes;
+	size_t capacity;
+	std::vector<std::unique_ptr<CPathsInfo>> buffers;
+
+	Pool(const int3 & Sizes, size_t Capacity)
+		: sizes(Sizes), capacity(Capacity)
+	{
+	}
+
+	static void release(std::weak_ptr<Pool> weakPool, CPathsInfo * paths)
+	{
+		std::unique_ptr<CPathsInfo> owned(paths);
+		auto pool = weakPool.lock();
+		if(!pool)
+			return;
+
+		boost::unique_lock<boost::mutex> lock(pool->mx);
+		if(pool->buffers.size() < pool->capacity && owned->sizes == pool->sizes)
+		{
+			owned->hero = nullptr;
+			pool->buffers.push_back(std::move(owned));
+		}
+	}
+};
+
+CPathfinderService::CPathfinderService(CGameState * Gs, size_t MaxPooledBuffers)
+	: gs(Gs)
+{
+	pool = std::make_shared<Pool>(int3(gs->map->width, gs->map->height, gs->map->twoLevel ? 2 : 1), MaxPooledBuffers);
+}
+
+CPathfinderService::~CPathfinderService()
+{
+}
+
+std::shared_ptr<CPathsInfo> CPathfinderService::acquire()
+{
+	std::unique_ptr<CPathsInfo> paths;
+	{
+		boost::unique_lock<boost::mutex> lock(pool->mx);
+		if(!pool->buffers.empty())
+		{
+			paths = std::move(pool->buffers.back());
+			pool->buffers.pop_back();
+		}
+	}
+	if(!paths)
+		paths = make_unique<CPathsInfo>(pool->sizes);
+
+	std::weak_ptr<Pool> weakPool = pool;
+	return std::shared_ptr<CPathsInfo>(paths.release(), [weakPool](CPathsInfo * p)
+	{
+		Pool::release(weakPool, p);
+	});
+}
+
+std::shared_ptr<CPathsInfo> CPathfinderService::calculatePaths(const CGHeroInstance * hero)
+{
+	return calculatePaths(std::vector<const CGHeroInstance *>(1, hero)).front();
+}
+
+std::vector<std::shared_ptr<CPathsInfo>> CPathfinderService::calculatePaths(const std::vector<const CGHeroInstance *> & heroes)
+{
+	std::vector<std::shared_ptr<CPathsInfo>> ret;
+	std::vector<TJob> jobs;
+	for(auto hero : heroes)
+	{
+		ret.push_back(acquire());
+		jobs.push_back(std::make_pair(hero, ret.back().get()));
+	}
+	calculatePaths(jobs);
+	return ret;
+}
+
+void CPathfinderService::calculatePaths(const std::vector<TJob> & jobs)
+{
+	std::vector<Task> tasks;
+	for(size_t i = 0; i < jobs.size(); i++)
+	{
+		tasks.push_back([this, &jobs, i]()
+		{
+			CPathsInfo & out = *jobs[i].second;
+			boost::unique_lock<boost::mutex> pathLock(out.pathMx);
+			try
+			{
+				CPathfinder pathfinder(out, gs, jobs[i].first);
+				if(!pathfinder.repairPaths())
+					pathfinder.calculatePaths();
+			}
+			catch(...)
+			{
+				out.hero = nullptr;
+				throw;
+			}
+		});
+	}
+	CThreadHelper::runParallel(tasks);
+}
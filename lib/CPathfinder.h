@@ -22,6 +22,7 @@ struct TerrainTile;
 class CPathfinderHelper;
 class CMap;
 class CGWhirlpool;
+class FogOfWarMap;
 
 struct DLL_LINKAGE CGPathNode
 {
@@ -85,6 +86,7 @@ struct DLL_LINKAGE CPathsInfo
 	int3 hpos;
 	int3 sizes;
 	boost::multi_array<CGPathNode, 4> nodes; //[w][h][level][layer]
+	std::unordered_set<int3, ShashInt3> changedTiles; //tiles changed since paths were calculated, if any paths have to be repaired
 
 	CPathsInfo(const int3 & Sizes);
 	~CPathsInfo();
@@ -96,16 +98,30 @@ struct DLL_LINKAGE CPathsInfo
 	CGPathNode * getNode(const int3 & coord, const ELayer layer);
 };
 
-class CPathfinder : private CGameInfoCallback
+/// Monotone bucket queue that orders nodes by turns and then by remaining movement points (most first).
+/// Both are small bounded integers so one bucket per value is cheaper than comparisons in a binary heap.
+/// Nodes pushed with key lower than already popped one are still handled, just without the speedup.
+class DLL_LINKAGE CPathNodeBucketQueue
 {
 public:
-	friend class CPathfinderHelper;
+	CPathNodeBucketQueue();
 
-	CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstance * _hero);
-	void calculatePaths(); //calculates possible paths for hero, uses current hero position and movement left; returns pointer to newly allocated CPath or nullptr if path does not exists
+	void push(CGPathNode * node);
+	CGPathNode * pop(); //returns node with the lowest turns and the highest moveRemains
+	bool empty() const;
+	void clear(); //keeps allocated buckets for next use
 
 private:
-	typedef EPathfindingLayer ELayer;
+	std::vector<std::vector<std::vector<CGPathNode *>>> buckets; //[turns][moveRemains]
+	size_t count;
+	size_t currentTurn;
+	int currentRemains; //highest bucket of currentTurn that may be non-empty, -1 if none
+};
+
+class DLL_LINKAGE CPathfinder : private CGameInfoCallback
+{
+public:
+	friend class CPathfinderHelper;
 
 	struct PathfinderOptions
 	{
@@ -155,12 +171,33 @@ private:
 		///   I find it's reasonable limitation, but it's will make some movements more expensive than in H3.
 		bool originalMovementRules;
 
-		PathfinderOptions();
-	} options;
+		/// Use bucket queue instead of binary heap for open nodes.
+		/// Both engines give same turns and movement points for every node.
+		bool useBucketQueue;
 
+		/// Repair paths after few tiles changed or hero made a step instead of calculating them again.
+		/// Changed tiles are collected by client, see CPathsInfo::changedTiles.
+		bool incremental;
+
+		PathfinderOptions(); //reads options from pathfinder section of settings
+	};
+
+	CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstance * _hero); //options are read from settings
+	CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstance * _hero, const PathfinderOptions & _options);
+	void calculatePaths(); //calculates possible paths for hero, uses current hero position and movement left; returns pointer to newly allocated CPath or nullptr if path does not exists
+
+	/// Updates paths calculated earlier for the same hero instead of calculating them from scratch.
+	/// Only nodes reached through out.changedTiles are reset, plus nodes not reached through new hero position if hero moved along the path.
+	/// Returns false if paths can't be repaired and have to be calculated again.
+	bool repairPaths();
+
+private:
+	typedef EPathfindingLayer ELayer;
+
+	PathfinderOptions options;
 	CPathsInfo & out;
 	const CGHeroInstance * hero;
-	const std::vector<std::vector<std::vector<ui8> > > &FoW;
+	const FogOfWarMap & FoW;
 	std::unique_ptr<CPathfinderHelper> hlp;
 
 	enum EPatrolState {
@@ -183,6 +220,8 @@ private:
 		}
 	};
 	boost::heap::priority_queue<CGPathNode *, boost::heap::compare<NodeComparer> > pq;
+	CPathNodeBucketQueue bucketQueue;
+	bool repairing; //allow better way into already expanded nodes
 
 	std::vector<int3> neighbourTiles;
 	std::vector<int3> neighbours;
@@ -193,6 +232,11 @@ private:
 	const CGObjectInstance * ctObj, * dtObj;
 	CGPathNode::ENodeAction destAction;
 
+	void pushNode(CGPathNode * node);
+	CGPathNode * topAndPopNode();
+	bool isQueueEmpty() const;
+	void processQueue();
+
 	void addNeighbours();
 	void addTeleportExits();
 
@@ -215,6 +259,7 @@ private:
 
 	void initializePatrol();
 	void initializeGraph();
+	void initializeTile(const int3 & pos);
 
 	CGPathNode::EAccessibility evaluateAccessibility(const int3 & pos, const TerrainTile * tinfo, const ELayer layer) const;
 	bool isVisitableObj(const CGObjectInstance * obj, const ELayer layer) const;
@@ -280,3 +325,31 @@ private:
 	std::vector<TurnInfo *> turnsInfo;
 	const CPathfinder::PathfinderOptions & options;
 };
+
+/// Calculates paths for several heroes at once, one pathfinder pass per worker thread.
+/// Caller must keep the game state unchanged (hold CGameState::mutex) while calculation runs.
+class DLL_LINKAGE CPathfinderService
+{
+public:
+	typedef std::pair<const CGHeroInstance *, CPathsInfo *> TJob;
+
+	CPathfinderService(CGameState * Gs, size_t MaxPooledBuffers = 8);
+	~CPathfinderService();
+
+	/// Returns buffer sized for current map; it goes back to the pool when last reference is dropped
+	std::shared_ptr<CPathsInfo> acquire();
+
+	/// Calculates paths from scratch into buffers taken from the pool. Pooled buffers don't track map changes, so they are never repaired.
+	std::shared_ptr<CPathsInfo> calculatePaths(const CGHeroInstance * hero);
+	std::vector<std::shared_ptr<CPathsInfo>> calculatePaths(const std::vector<const CGHeroInstance *> & heroes);
+
+	/// Recalculates paths of each hero into its paired buffer, locking buffer's pathMx for the time of calculation.
+	/// Buffer that already holds paths of the same hero is repaired when possible, which needs pathfinder.incremental setting.
+	void calculatePaths(const std::vector<TJob> & jobs);
+
+private:
+	struct Pool;
+
+	CGameState * gs;
+	std::shared_ptr<Pool> pool;
+};
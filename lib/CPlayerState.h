@@ -10,6 +10,7 @@
 #pragma once
 
 #include "HeroBonus.h"
+#include "FogOfWarMap.h"
 
 class CGHeroInstance;
 class CGTownInstance;
@@ -72,8 +73,7 @@ struct DLL_LINKAGE TeamState : public CBonusSystemNode
 public:
 	TeamID id; //position in gameState::teams
 	std::set<PlayerColor> players; // members of this team
-	//TODO: boost::array, bool if possible
-	std::vector<std::vector<std::vector<ui8> > >  fogOfWarMap; //true - visible, false - hidden
+	FogOfWarMap fogOfWarMap;
 
 	TeamState();
 	TeamState(TeamState && other);
@@ -82,7 +82,16 @@ public:
 	{
 		h & id;
 		h & players;
-		h & fogOfWarMap;
+		if(version >= 778)
+		{
+			h & fogOfWarMap;
+		}
+		else if(!h.saving)
+		{
+			std::vector<std::vector<std::vector<ui8>>> legacyFogOfWarMap;
+			h & legacyFogOfWarMap;
+			fogOfWarMap.loadLegacy(legacyFogOfWarMap);
+		}
 		h & static_cast<CBonusSystemNode&>(*this);
 	}
 
@@ -557,15 +557,14 @@ std::vector<si32> CStack::activeSpells() const
 {
 	std::vector<si32> ret;
 
-	std::stringstream cachingStr;
-	cachingStr << "!type_" << Bonus::NONE << "source_" << Bonus::SPELL_EFFECT;
+	const BonusCacheKey cachingKey = BonusCacheKey::sourceType(Bonus::SPELL_EFFECT).exceptType(Bonus::NONE);
 	CSelector selector = Selector::sourceType(Bonus::SPELL_EFFECT)
 						 .And(CSelector([](const Bonus * b)->bool
 	{
 		return b->type != Bonus::NONE;
 	}));
 
-	TBonusListPtr spellEffects = getBonuses(selector, Selector::all, cachingStr.str());
+	TBonusListPtr spellEffects = getBonuses(selector, Selector::all, cachingKey);
 	for(const std::shared_ptr<Bonus> it : *spellEffects)
 	{
 		if(!vstd::contains(ret, it->sid))  //do not duplicate spells with multiple effects
@@ -766,6 +765,26 @@ bool CStack::canBeHealed() const
 		   && !hasBonusOfType(Bonus::SIEGE_WEAPON);
 }
 
+std::vector<Bonus> CStack::getDefensiveStanceBonuses() const
+{
+	std::vector<Bonus> ret;
+	ret.push_back(Bonus(Bonus::STACK_GETS_TURN, Bonus::PRIMARY_SKILL, Bonus::OTHER, 20, -1, PrimarySkill::DEFENSE, Bonus::PERCENT_TO_ALL));
+	ret.push_back(Bonus(Bonus::STACK_GETS_TURN, Bonus::PRIMARY_SKILL, Bonus::OTHER, valOfBonuses(Bonus::DEFENSIVE_STANCE),
+		-1, PrimarySkill::DEFENSE, Bonus::ADDITIVE_VALUE));
+	return ret;
+}
+
+int CStack::getDefensiveStanceGain() const
+{
+	BonusList defence = *getBonuses(Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::DEFENSE));
+	const int oldDefenceValue = defence.totalValue();
+
+	for(const Bonus & bonus : getDefensiveStanceBonuses())
+		defence.push_back(std::make_shared<Bonus>(bonus));
+
+	return defence.totalValue() - oldDefenceValue;
+}
+
 void CStack::makeGhost()
 {
 	state.erase(EBattleStackState::ALIVE);
@@ -185,6 +185,9 @@ public:
 
 	bool canBeHealed() const; //for first aid tent - only harmed stacks that are not war machines
 
+	std::vector<Bonus> getDefensiveStanceBonuses() const; //given to stack on defend action
+	int getDefensiveStanceGain() const; //by how much defend action increases defense of stack
+
 	ui32 level() const;
 	si32 magicResistance() const override; //include aura of resistance
 	std::vector<si32> activeSpells() const; //returns vector of active spell IDs sorted by time of cast
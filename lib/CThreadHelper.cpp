@@ -24,14 +24,47 @@ CThreadHelper::CThreadHelper(std::vector<std::function<void()> > *Tasks, int Thr
 }
 void CThreadHelper::run()
 {
-	boost::thread_group grupa;
-	std::vector<boost::thread *> thr;
+	boost::thread_group grupa; //owns and deletes created threads
 	for(int i=0;i<threads;i++)
-		thr.push_back(grupa.create_thread(std::bind(&CThreadHelper::processTasks,this)));
+		grupa.create_thread(std::bind(&CThreadHelper::processTasks,this));
 	grupa.join_all();
+}
+void CThreadHelper::runParallel(std::vector<Task> & tasks)
+{
+	std::vector<std::exception_ptr> errors(tasks.size());
+	std::vector<Task> guarded;
+	for(size_t i = 0; i < tasks.size(); i++)
+	{
+		guarded.push_back([&tasks, &errors, i]()
+		{
+			try
+			{
+				tasks[i]();
+			}
+			catch(...)
+			{
+				errors[i] = std::current_exception();
+			}
+		});
+	}
+
+	const size_t threads = std::min<size_t>(tasks.size(), std::max(1u, boost::thread::hardware_concurrency()));
+	if(threads <= 1)
+	{
+		for(auto & task : guarded)
+			task();
+	}
+	else
+	{
+		CThreadHelper helper(&guarded, threads);
+		helper.run();
+	}
 
-	for(auto thread : thr)
-		delete thread;
+	for(auto & error : errors)
+	{
+		if(error)
+			std::rethrow_exception(error);
+	}
 }
 void CThreadHelper::processTasks()
 {
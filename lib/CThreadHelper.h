@@ -24,6 +24,10 @@ class DLL_LINKAGE CThreadHelper
 public:
 	CThreadHelper(std::vector<std::function<void()> > *Tasks, int Threads);
 	void run();
+
+	/// Runs tasks on up to one thread per core, or directly in calling thread if there is only one core or task.
+	/// Returns after all tasks finished, then rethrows first exception thrown by any of them
+	static void runParallel(std::vector<Task> & tasks);
 };
 
 template <typename T> inline void setData(T * data, std::function<T()> func)
@@ -0,0 +1,130 @@
+/*
+ * FogOfWarMap.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "FogOfWarMap.h"
+
+FogOfWarMap::FogOfWarMap()
+	: sizes(0, 0, 0), wordsPerRow(0)
+{
+}
+
+FogOfWarMap::FogOfWarMap(const int3 & sizes)
+	: FogOfWarMap()
+{
+	resize(sizes);
+}
+
+void FogOfWarMap::resize(const int3 & newSizes)
+{
+	sizes = newSizes;
+	wordsPerRow = getWordsPerRow(sizes.x);
+	words.assign(wordsPerRow * std::max(sizes.y, 0) * std::max(sizes.z, 0), 0);
+}
+
+void FogOfWarMap::setVisible(const int3 & pos, bool visible)
+{
+	TWord & word = words[getWordIndex(pos.x, pos.y, pos.z)];
+	const TWord bit = TWord(1) << (pos.x % WORD_BITS);
+	if(visible)
+		word |= bit;
+	else
+		word &= ~bit;
+}
+
+void FogOfWarMap::setSpan(int x1, int x2, int y, int z, bool visible)
+{
+	if(!clipSpan(x1, x2, y, z))
+		return;
+
+	for(int word = x1 / WORD_BITS; word <= x2 / WORD_BITS; word++)
+	{
+		TWord & bits = words[getWordIndex(word * WORD_BITS, y, z)];
+		const TWord mask = getSpanMask(word, x1, x2);
+		if(visible)
+			bits |= mask;
+		else
+			bits &= ~mask;
+	}
+}
+
+void FogOfWarMap::setAll(bool visible)
+{
+	for(int z = 0; z < sizes.z; z++)
+		for(int y = 0; y < sizes.y; y++)
+			setSpan(0, sizes.x - 1, y, z, visible);
+}
+
+void FogOfWarMap::revealRadius(const int3 & center, int radius, bool patrolDistance)
+{
+	if(radius == -1)
+	{
+		setAll(true);
+		return;
+	}
+
+	for(int dy = -radius; dy <= radius; dy++)
+	{
+		const int reach = getRowReach(radius, dy, patrolDistance);
+		if(reach >= 0)
+			setSpan(center.x - reach, center.x + reach, center.y + dy, center.z, true);
+	}
+}
+
+int FogOfWarMap::getRowReach(int radius, int dy, bool patrolDistance)
+{
+	if(radius < 0 || std::abs(dy) > radius)
+		return -1;
+
+	if(patrolDistance)
+		return radius - std::abs(dy);
+
+	//tile is in range if its euclidean distance minus 0.5 is not greater than radius,
+	//for integer offsets that is dx^2 + dy^2 <= radius^2 + radius
+	const si64 limit = si64(radius) * radius + radius - si64(dy) * dy;
+	si64 reach = static_cast<si64>(std::sqrt(static_cast<double>(limit)));
+	while(reach * reach > limit)
+		reach--;
+	while((reach + 1) * (reach + 1) <= limit)
+		reach++;
+	return static_cast<int>(reach);
+}
+
+size_t FogOfWarMap::countVisible() const
+{
+	size_t result = 0;
+	for(TWord word : words)
+	{
+#ifdef _MSC_VER
+		result += __popcnt64(word);
+#else
+		result += __builtin_popcountll(word);
+#endif
+	}
+	return result;
+}
+
+bool FogOfWarMap::operator==(const FogOfWarMap & other) const
+{
+	return sizes == other.sizes && words == other.words;
+}
+
+void FogOfWarMap::loadLegacy(const std::vector<std::vector<std::vector<ui8>>> & legacy)
+{
+	const int width = legacy.size();
+	const int height = width ? legacy.front().size() : 0;
+	const int levels = height ? legacy.front().front().size() : 0;
+
+	resize(int3(width, height, levels));
+	for(int x = 0; x < width; x++)
+		for(int y = 0; y < height; y++)
+			for(int z = 0; z < levels; z++)
+				if(legacy[x][y][z])
+					reveal(int3(x, y, z));
+}
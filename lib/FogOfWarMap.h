@@ -0,0 +1,167 @@
+/*
+ * FogOfWarMap.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "int3.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// Visibility of adventure map tiles for one team, one bit per tile.
+/// Rows (fixed y and z) are stored z-major and every row starts on a word boundary,
+/// so spans of a row can be revealed, scanned and compared a whole word at a time.
+class DLL_LINKAGE FogOfWarMap
+{
+public:
+	typedef ui64 TWord;
+	static const int WORD_BITS = 64;
+
+	FogOfWarMap();
+	explicit FogOfWarMap(const int3 & sizes);
+
+	/// Resizes map to given dimensions (x - width, y - height, z - levels), all tiles become hidden
+	void resize(const int3 & sizes);
+	const int3 & getSizes() const { return sizes; }
+
+	bool isVisible(const int3 & pos) const
+	{
+		return (words[getWordIndex(pos.x, pos.y, pos.z)] >> (pos.x % WORD_BITS)) & 1;
+	}
+
+	void setVisible(const int3 & pos, bool visible);
+	void reveal(const int3 & pos) { setVisible(pos, true); }
+	void hide(const int3 & pos) { setVisible(pos, false); }
+
+	/// Sets visibility of tiles x1..x2 (inclusive) of row y on level z, span is clipped to map
+	void setSpan(int x1, int x2, int y, int z, bool visible);
+	/// Sets visibility of all tiles
+	void setAll(bool visible);
+	/// Reveals all tiles within radius around center on its level, radius -1 reveals entire map.
+	/// Uses the same distance rules as CPrivilagedInfoCallback::getTilesInRange
+	void revealRadius(const int3 & center, int radius, bool patrolDistance = false);
+
+	/// Returns how far from the center (in x) tiles of a row dy rows away from center are within radius,
+	/// or -1 if no tile of that row is in range
+	static int getRowReach(int radius, int dy, bool patrolDistance);
+
+	size_t countVisible() const;
+
+	/// Calls f(int3) for every tile with given visibility
+	template<typename Func>
+	void forEachTile(bool visible, Func f) const
+	{
+		for(int z = 0; z < sizes.z; z++)
+			for(int y = 0; y < sizes.y; y++)
+				forEachInSpan(0, sizes.x - 1, y, z, visible, f);
+	}
+
+	/// Calls f(int3) for every tile of span x1..x2 of row (y, z) with given visibility
+	template<typename Func>
+	void forEachInSpan(int x1, int x2, int y, int z, bool visible, Func f) const
+	{
+		if(!clipSpan(x1, x2, y, z))
+			return;
+
+		const TWord invert = visible ? 0 : ~TWord(0);
+		for(int word = x1 / WORD_BITS; word <= x2 / WORD_BITS; word++)
+		{
+			TWord bits = (words[getWordIndex(word * WORD_BITS, y, z)] ^ invert) & getSpanMask(word, x1, x2);
+			while(bits)
+			{
+				f(int3(word * WORD_BITS + lowestBit(bits), y, z));
+				bits &= bits - 1;
+			}
+		}
+	}
+
+	/// Calls f(int3, bool visibleHere) for every tile which visibility differs between this and other map.
+	/// Both maps must have the same size
+	template<typename Func>
+	void forEachDifference(const FogOfWarMap & other, Func f) const
+	{
+		assert(sizes == other.sizes);
+		for(int z = 0; z < sizes.z; z++)
+		{
+			for(int y = 0; y < sizes.y; y++)
+			{
+				const size_t row = getWordIndex(0, y, z);
+				for(size_t word = 0; word < wordsPerRow; word++)
+				{
+					TWord bits = words[row + word] ^ other.words[row + word];
+					while(bits)
+					{
+						const int x = word * WORD_BITS + lowestBit(bits);
+						f(int3(x, y, z), ((words[row + word] >> (x % WORD_BITS)) & 1) != 0);
+						bits &= bits - 1;
+					}
+				}
+			}
+		}
+	}
+
+	bool operator==(const FogOfWarMap & other) const;
+	bool operator!=(const FogOfWarMap & other) const { return !(*this == other); }
+
+	/// Converts fog of war stored as [x][y][z] array used by old saves
+	void loadLegacy(const std::vector<std::vector<std::vector<ui8>>> & legacy);
+
+	template <typename Handler> void serialize(Handler & h, const int version)
+	{
+		h & sizes;
+		h & words;
+		if(!h.saving)
+			wordsPerRow = getWordsPerRow(sizes.x);
+	}
+
+private:
+	int3 sizes;
+	size_t wordsPerRow;
+	std::vector<TWord> words; //bits beyond map width are always 0
+
+	static size_t getWordsPerRow(int width)
+	{
+		return (std::max(width, 0) + WORD_BITS - 1) / WORD_BITS;
+	}
+
+	size_t getWordIndex(int x, int y, int z) const
+	{
+		return (z * sizes.y + y) * wordsPerRow + x / WORD_BITS;
+	}
+
+	/// Mask of bits of given word which lie inside span x1..x2
+	static TWord getSpanMask(int word, int x1, int x2)
+	{
+		const int first = std::max(x1 - word * WORD_BITS, 0);
+		const int last = std::min(x2 - word * WORD_BITS, WORD_BITS - 1);
+		const TWord upTo = last == WORD_BITS - 1 ? ~TWord(0) : (TWord(1) << (last + 1)) - 1;
+		return upTo & ~((TWord(1) << first) - 1);
+	}
+
+	bool clipSpan(int & x1, int & x2, int y, int z) const
+	{
+		if(y < 0 || y >= sizes.y || z < 0 || z >= sizes.z)
+			return false;
+		x1 = std::max(x1, 0);
+		x2 = std::min(x2, sizes.x - 1);
+		return x1 <= x2;
+	}
+
+	static int lowestBit(TWord bits)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return index;
+#else
+		return __builtin_ctzll(bits);
+#endif
+	}
+};
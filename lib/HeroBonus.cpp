@@ -89,12 +89,14 @@ CBonusProxy::CBonusProxy(const IBonusBearer * Target, CSelector Selector):
 
 TBonusListPtr CBonusProxy::get() const
 {
-	if(CBonusSystemNode::treeChanged != cachedLast || !data)
+	TLockGuard lock(mx);
+	int64_t currentTreeVersion = target->getTreeVersion();
+	if(currentTreeVersion != cachedLast || !data)
 	{
 		//TODO: support limiters
 		data = target->getAllBonuses(selector, nullptr);
 		data->eliminateDuplicates();
-		cachedLast = CBonusSystemNode::treeChanged;
+		cachedLast = currentTreeVersion;
 	}
 	return data;
 }
@@ -104,10 +106,213 @@ const BonusList * CBonusProxy::operator->() const
 	return get().get();
 }
 
-int CBonusSystemNode::treeChanged = 1;
+///BonusCacheKey
+BonusCacheKey::BonusCacheKey():
+	flags(0), bonusSource(0), valType(0), bonusType(0), subtype(0), sourceID(0), info(0)
+{
+}
+
+BonusCacheKey::BonusCacheKey(const std::string & cachingStr):
+	BonusCacheKey(cachingStr.c_str())
+{
+}
+
+BonusCacheKey::BonusCacheKey(const char * cachingStr):
+	BonusCacheKey()
+{
+	if(!cachingStr || !*cachingStr)
+		return;
+
+	//64-bit FNV-1a, collisions between legacy keys are practically impossible
+	ui64 hash = 14695981039346656037ULL;
+	for(const char * c = cachingStr; *c; c++)
+	{
+		hash ^= static_cast<ui8>(*c);
+		hash *= 1099511628211ULL;
+	}
+
+	flags = LEGACY_STRING;
+	sourceID = static_cast<si32>(hash & 0xFFFFFFFF);
+	info = static_cast<si32>(hash >> 32);
+}
+
+BonusCacheKey BonusCacheKey::type(Bonus::BonusType type)
+{
+	BonusCacheKey ret;
+	ret.flags = TYPE;
+	ret.bonusType = type;
+	return ret;
+}
+
+BonusCacheKey BonusCacheKey::typeSubtype(Bonus::BonusType type, TBonusSubtype subtype)
+{
+	BonusCacheKey ret = BonusCacheKey::type(type);
+	ret.flags |= SUBTYPE;
+	ret.subtype = subtype;
+	return ret;
+}
+
+BonusCacheKey BonusCacheKey::typeSubtypeInfo(Bonus::BonusType type, TBonusSubtype subtype, si32 info)
+{
+	BonusCacheKey ret = BonusCacheKey::typeSubtype(type, subtype);
+	ret.flags |= INFO;
+	ret.info = info;
+	return ret;
+}
+
+BonusCacheKey BonusCacheKey::source(Bonus::BonusSource source, ui32 sourceID)
+{
+	BonusCacheKey ret = BonusCacheKey::sourceType(source);
+	ret.flags |= SOURCE_ID;
+	ret.sourceID = sourceID;
+	return ret;
+}
+
+BonusCacheKey BonusCacheKey::sourceType(Bonus::BonusSource source)
+{
+	BonusCacheKey ret;
+	ret.flags = SOURCE;
+	ret.bonusSource = source;
+	return ret;
+}
+
+BonusCacheKey BonusCacheKey::composite(ECompositeQuery query)
+{
+	BonusCacheKey ret;
+	ret.flags = COMPOSITE;
+	ret.bonusType = query;
+	return ret;
+}
+
+BonusCacheKey BonusCacheKey::withSource(Bonus::BonusSource source) const
+{
+	assert(!(flags & (SOURCE | COMPOSITE | LEGACY_STRING)));
+	BonusCacheKey ret = *this;
+	ret.flags |= SOURCE;
+	ret.bonusSource = source;
+	return ret;
+}
+
+BonusCacheKey BonusCacheKey::exceptType(Bonus::BonusType type) const
+{
+	assert(!(flags & (TYPE | COMPOSITE | LEGACY_STRING)));
+	BonusCacheKey ret = *this;
+	ret.flags |= EXCEPT_TYPE;
+	ret.bonusType = type;
+	return ret;
+}
+
+BonusCacheKey BonusCacheKey::valueType(Bonus::ValueType valType) const
+{
+	BonusCacheKey ret = *this;
+	ret.flags |= VALUE_TYPE;
+	ret.valType = valType;
+	return ret;
+}
+
+BonusCacheKey BonusCacheKey::turns(int turns) const
+{
+	assert(!(flags & (INFO | DAYS | LEGACY_STRING)));
+	BonusCacheKey ret = *this;
+	ret.flags |= TURNS;
+	ret.info = turns;
+	return ret;
+}
+
+BonusCacheKey BonusCacheKey::days(int days) const
+{
+	assert(!(flags & (INFO | TURNS | LEGACY_STRING)));
+	BonusCacheKey ret = *this;
+	ret.flags |= DAYS;
+	ret.info = days;
+	return ret;
+}
+
+size_t BonusCacheKey::hash() const
+{
+	ui64 ret = flags | (static_cast<ui64>(bonusSource) << 16) | (static_cast<ui64>(valType) << 24) | (static_cast<ui64>(static_cast<ui32>(bonusType)) << 32);
+	ret ^= (static_cast<ui64>(static_cast<ui32>(subtype)) * 0x9E3779B97F4A7C15ULL);
+	ret ^= (static_cast<ui64>(static_cast<ui32>(sourceID)) * 0xC2B2AE3D27D4EB4FULL);
+	ret ^= (static_cast<ui64>(static_cast<ui32>(info)) * 0x165667B19E3779F9ULL);
+	ret ^= ret >> 29;
+	ret *= 0xBF58476D1CE4E5B9ULL;
+	ret ^= ret >> 32;
+	return static_cast<size_t>(ret);
+}
+
+///BonusQueryCache
+BonusQueryCache::BonusQueryCache():
+	used(0)
+{
+}
+
+size_t BonusQueryCache::findSlot(const BonusCacheKey & key) const
+{
+	const size_t mask = entries.size() - 1;
+	size_t slot = key.hash() & mask;
+
+	//load factor is kept below 1/2, so there is always an empty slot to stop at
+	while(entries[slot].key.isValid() && entries[slot].key != key)
+		slot = (slot + 1) & mask;
+
+	return slot;
+}
+
+TBonusListPtr BonusQueryCache::find(const BonusCacheKey & key) const
+{
+	if(used == 0)
+		return TBonusListPtr();
+
+	return entries[findSlot(key)].value;
+}
+
+void BonusQueryCache::insert(const BonusCacheKey & key, TBonusListPtr value)
+{
+	assert(key.isValid());
+
+	if((used + 1) * 2 > entries.size())
+		grow();
+
+	Entry & entry = entries[findSlot(key)];
+	if(!entry.key.isValid())
+	{
+		entry.key = key;
+		used++;
+	}
+	entry.value = value;
+}
+
+void BonusQueryCache::clear()
+{
+	if(used == 0)
+		return;
+
+	//keep the storage, node will likely ask the same questions again
+	for(Entry & entry : entries)
+	{
+		entry.key = BonusCacheKey();
+		entry.value.reset();
+	}
+	used = 0;
+}
+
+void BonusQueryCache::grow()
+{
+	std::vector<Entry> oldEntries(std::max<size_t>(8, entries.size() * 2));
+	std::swap(entries, oldEntries);
+
+	for(Entry & entry : oldEntries)
+	{
+		if(entry.key.isValid())
+			entries[findSlot(entry.key)] = std::move(entry);
+	}
+}
+
+int64_t CBonusSystemNode::treeChanged = 1;
+int64_t CBonusSystemNode::nodeChangeCounter = 0;
 const bool CBonusSystemNode::cachingEnabled = true;
 
-BonusList::BonusList(bool BelongsToTree) : belongsToTree(BelongsToTree)
+BonusList::BonusList(CBonusSystemNode * Owner) : owner(Owner)
 {
 
 }
@@ -116,28 +321,28 @@ BonusList::BonusList(const BonusList &bonusList)
 {
 	bonuses.resize(bonusList.size());
 	std::copy(bonusList.begin(), bonusList.end(), bonuses.begin());
-	belongsToTree = false;
+	owner = nullptr;
 }
 
 BonusList::BonusList(BonusList&& other):
-	belongsToTree(false)
+	owner(nullptr)
 {
-	std::swap(belongsToTree, other.belongsToTree);
 	std::swap(bonuses, other.bonuses);
+	other.changed();
 }
 
 BonusList& BonusList::operator=(const BonusList &bonusList)
 {
 	bonuses.resize(bonusList.size());
 	std::copy(bonusList.begin(), bonusList.end(), bonuses.begin());
-	belongsToTree = false;
+	changed();
 	return *this;
 }
 
 void BonusList::changed()
 {
-    if(belongsToTree)
-		CBonusSystemNode::treeHasChanged();
+	if(owner)
+		owner->nodeHasChanged();
 }
 
 int BonusList::totalValue() const
@@ -326,59 +531,51 @@ int IBonusBearer::valOfBonuses(Bonus::BonusType type, const CSelector &selector)
 
 int IBonusBearer::valOfBonuses(Bonus::BonusType type, int subtype) const
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << type << "s_" << subtype;
-
 	CSelector s = Selector::type(type);
 	if(subtype != -1)
 		s = s.And(Selector::subtype(subtype));
 
-	return valOfBonuses(s, cachingStr.str());
+	return valOfBonuses(s, subtype != -1 ? BonusCacheKey::typeSubtype(type, subtype) : BonusCacheKey::type(type));
 }
 
-int IBonusBearer::valOfBonuses(const CSelector &selector, const std::string &cachingStr) const
+int IBonusBearer::valOfBonuses(const CSelector &selector, const BonusCacheKey &cachingKey) const
 {
 	CSelector limit = nullptr;
-	TBonusListPtr hlp = getAllBonuses(selector, limit, nullptr, cachingStr);
+	TBonusListPtr hlp = getAllBonuses(selector, limit, nullptr, cachingKey);
 	return hlp->totalValue();
 }
-bool IBonusBearer::hasBonus(const CSelector &selector, const std::string &cachingStr) const
+bool IBonusBearer::hasBonus(const CSelector &selector, const BonusCacheKey &cachingKey) const
 {
-	return getBonuses(selector, cachingStr)->size() > 0;
+	return getBonuses(selector, cachingKey)->size() > 0;
 }
 
-bool IBonusBearer::hasBonus(const CSelector &selector, const CSelector &limit, const std::string &cachingStr) const
+bool IBonusBearer::hasBonus(const CSelector &selector, const CSelector &limit, const BonusCacheKey &cachingKey) const
 {
-	return getBonuses(selector, limit, cachingStr)->size() > 0;
+	return getBonuses(selector, limit, cachingKey)->size() > 0;
 }
 
 bool IBonusBearer::hasBonusOfType(Bonus::BonusType type, int subtype) const
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << type << "s_" << subtype;
-
 	CSelector s = Selector::type(type);
 	if(subtype != -1)
 		s = s.And(Selector::subtype(subtype));
 
-	return hasBonus(s, cachingStr.str());
+	return hasBonus(s, subtype != -1 ? BonusCacheKey::typeSubtype(type, subtype) : BonusCacheKey::type(type));
 }
 
-const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const std::string &cachingStr) const
+const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const BonusCacheKey &cachingKey) const
 {
-	return getAllBonuses(selector, nullptr, nullptr, cachingStr);
+	return getAllBonuses(selector, nullptr, nullptr, cachingKey);
 }
 
-const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const CSelector &limit, const std::string &cachingStr) const
+const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const CSelector &limit, const BonusCacheKey &cachingKey) const
 {
-	return getAllBonuses(selector, limit, nullptr, cachingStr);
+	return getAllBonuses(selector, limit, nullptr, cachingKey);
 }
 
 bool IBonusBearer::hasBonusFrom(Bonus::BonusSource source, ui32 sourceID) const
 {
-	std::stringstream cachingStr;
-	cachingStr << "source_" << source << "id_" << sourceID;
-	return hasBonus(Selector::source(source,sourceID), cachingStr.str());
+	return hasBonus(Selector::source(source,sourceID), BonusCacheKey::source(source, sourceID));
 }
 
 int IBonusBearer::MoraleVal() const
@@ -441,15 +638,13 @@ ui32 IBonusBearer::MaxHealth() const
 
 ui32 IBonusBearer::getMinDamage() const
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << Bonus::CREATURE_DAMAGE << "s_0Otype_" << Bonus::CREATURE_DAMAGE << "s_1";
-	return valOfBonuses(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 1)), cachingStr.str());
+	const BonusCacheKey cachingKey = BonusCacheKey::composite(BonusCacheKey::MIN_DAMAGE);
+	return valOfBonuses(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 1)), cachingKey);
 }
 ui32 IBonusBearer::getMaxDamage() const
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << Bonus::CREATURE_DAMAGE << "s_0Otype_" << Bonus::CREATURE_DAMAGE << "s_2";
-	return valOfBonuses(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 2)), cachingStr.str());
+	const BonusCacheKey cachingKey = BonusCacheKey::composite(BonusCacheKey::MAX_DAMAGE);
+	return valOfBonuses(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 2)), cachingKey);
 }
 
 si32 IBonusBearer::manaLimit() const
@@ -481,26 +676,25 @@ si32 IBonusBearer::magicResistance() const
 ui32 IBonusBearer::Speed(int turn, bool useBind ) const
 {
 	//war machines cannot move
-	if(hasBonus(Selector::type(Bonus::SIEGE_WEAPON).And(Selector::turns(turn))))
+	if(hasBonus(Selector::type(Bonus::SIEGE_WEAPON).And(Selector::turns(turn)), BonusCacheKey::type(Bonus::SIEGE_WEAPON).turns(turn)))
 	{
 		return 0;
 	}
 	//bind effect check - doesn't influence stack initiative
-	if(useBind && hasBonus(Selector::type(Bonus::BIND_EFFECT).And(Selector::turns(turn))))
+	if(useBind && hasBonus(Selector::type(Bonus::BIND_EFFECT).And(Selector::turns(turn)), BonusCacheKey::type(Bonus::BIND_EFFECT).turns(turn)))
 	{
 		return 0;
 	}
 
-	return valOfBonuses(Selector::type(Bonus::STACKS_SPEED).And(Selector::turns(turn)));
+	return valOfBonuses(Selector::type(Bonus::STACKS_SPEED).And(Selector::turns(turn)), BonusCacheKey::type(Bonus::STACKS_SPEED).turns(turn));
 }
 
 bool IBonusBearer::isLiving() const //TODO: theoreticaly there exists "LIVING" bonus in stack experience documentation
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << Bonus::UNDEAD << "s_-1Otype_" << Bonus::NON_LIVING << "s_-11type_" << Bonus::SIEGE_WEAPON; //I don't really get what string labels mean?
+	const BonusCacheKey cachingKey = BonusCacheKey::composite(BonusCacheKey::NOT_LIVING);
 	return !hasBonus(Selector::type(Bonus::UNDEAD)
 					.Or(Selector::type(Bonus::NON_LIVING))
-					.Or(Selector::type(Bonus::SIEGE_WEAPON)), cachingStr.str());
+					.Or(Selector::type(Bonus::SIEGE_WEAPON)), cachingKey);
 }
 
 const std::shared_ptr<Bonus> IBonusBearer::getBonus(const CSelector &selector) const
@@ -568,18 +762,18 @@ void CBonusSystemNode::getAllBonusesRec(BonusList &out) const
 	bonuses.getAllBonuses(out);
 }
 
-const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root, const std::string &cachingStr) const
+const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root, const BonusCacheKey &cachingKey) const
 {
 	bool limitOnUs = (!root || root == this); //caching won't work when we want to limit bonuses against an external node
 	if (CBonusSystemNode::cachingEnabled && limitOnUs)
 	{
-		// Exclusive access for one thread
-		static boost::mutex m;
-		boost::mutex::scoped_lock lock(m);
+		// Exclusive access to cache of this node for one thread
+		TLockGuard lock(cacheMx);
 
-		// If the bonus system tree changes(state of a single node or the relations to each other) then
-		// cache all bonus objects. Selector objects doesn't matter.
-		if (cachedLast != treeChanged)
+		// If this node or any of its ancestors changed (state of a single node or the relations to each other)
+		// then cache all bonus objects. Selector objects doesn't matter.
+		const int64_t treeVersion = getTreeVersion();
+		if (cachedLast != treeVersion)
 		{
 			cachedBonuses.clear();
 			cachedRequests.clear();
@@ -589,18 +783,18 @@ const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, c
 			allBonuses.eliminateDuplicates();
 			limitBonuses(allBonuses, cachedBonuses);
 
-			cachedLast = treeChanged;
+			cachedLast = treeVersion;
 		}
 
-		// If a bonus system request comes with a caching string then look up in the map if there are any
+		// If a bonus system request comes with a caching key then look up in the cache if there are any
 		// pre-calculated bonus results. Limiters can't be cached so they have to be calculated.
-		if (cachingStr != "")
+		if (cachingKey.isValid())
 		{
-			auto it = cachedRequests.find(cachingStr);
-			if(it != cachedRequests.end())
+			auto cached = cachedRequests.find(cachingKey);
+			if(cached)
 			{
 				//Cached list contains bonuses for our query with applied limiters
-				return it->second;
+				return cached;
 			}
 		}
 
@@ -610,8 +804,8 @@ const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, c
 		cachedBonuses.getBonuses(*ret, selector, limit);
 
 		// Save the results in the cache
-		if(cachingStr != "")
-			cachedRequests[cachingStr] = ret;
+		if(cachingKey.isValid())
+			cachedRequests.insert(cachingKey, ret);
 
 		return ret;
 	}
@@ -657,17 +851,20 @@ const TBonusListPtr CBonusSystemNode::getAllBonusesWithoutCaching(const CSelecto
 	return ret;
 }
 
-CBonusSystemNode::CBonusSystemNode() : bonuses(true), exportedBonuses(true), nodeType(UNKNOWN), cachedLast(0)
+CBonusSystemNode::CBonusSystemNode() : bonuses(this), nodeType(UNKNOWN), cachedLast(0), nodeChanged(0)
 {
 }
 
 CBonusSystemNode::CBonusSystemNode(CBonusSystemNode && other):
-	bonuses(std::move(other.bonuses)),
+	bonuses(this),
 	exportedBonuses(std::move(other.exportedBonuses)),
 	nodeType(other.nodeType),
 	description(other.description),
-	cachedLast(0)
+	cachedLast(0),
+	nodeChanged(0)
 {
+	bonuses = other.bonuses;
+	other.bonuses.clear();
 	std::swap(parents, other.parents);
 	std::swap(children, other.children);
 
@@ -685,10 +882,11 @@ CBonusSystemNode::CBonusSystemNode(CBonusSystemNode && other):
 		n->parents.push_back(this);
 	}
 
-	//cache ignored
+	//cache ignored, but our children have to stop trusting theirs
 
 	//cachedBonuses
 	//cachedRequests
+	nodeHasChanged();
 }
 
 CBonusSystemNode::~CBonusSystemNode()
@@ -713,7 +911,7 @@ void CBonusSystemNode::attachTo(CBonusSystemNode *parent)
 		newRedDescendant(parent);
 
 	parent->newChildAttached(this);
-	CBonusSystemNode::treeHasChanged();
+	nodeHasChanged();
 }
 
 void CBonusSystemNode::detachFrom(CBonusSystemNode *parent)
@@ -727,7 +925,7 @@ void CBonusSystemNode::detachFrom(CBonusSystemNode *parent)
 
 	parents -= parent;
 	parent->childDetached(this);
-	CBonusSystemNode::treeHasChanged();
+	nodeHasChanged();
 }
 
 void CBonusSystemNode::popBonuses(const CSelector &s)
@@ -745,13 +943,22 @@ void CBonusSystemNode::updateBonuses(const CSelector &s)
 {
 	BonusList bl;
 	exportedBonuses.getBonuses(bl, s, Selector::all);
+	bool propagatedBonusChanged = false;
 	for(auto b : bl)
 	{
 		b->turnsRemain--;
 		if(b->turnsRemain <= 0)
 			removeBonus(b);
+		else if(b->propagator)
+			propagatedBonusChanged = true;
 	}
 
+	//remaining turns are checked by selectors of cached requests
+	if(propagatedBonusChanged)
+		CBonusSystemNode::treeHasChanged();
+	else if(!bl.empty())
+		nodeHasChanged();
+
 	for(CBonusSystemNode *child : children)
 		child->updateBonuses(s);
 }
@@ -767,14 +974,19 @@ void CBonusSystemNode::addNewBonus(const std::shared_ptr<Bonus>& b)
 	assert(!vstd::contains(exportedBonuses, b));
 	exportedBonuses.push_back(b);
 	exportBonus(b);
-	CBonusSystemNode::treeHasChanged();
 }
 
 void CBonusSystemNode::accumulateBonus(const std::shared_ptr<Bonus>& b)
 {
 	auto bonus = exportedBonuses.getFirst(Selector::typeSubtype(b->type, b->subtype)); //only local bonuses are interesting //TODO: what about value type?
 	if(bonus)
+	{
 		bonus->val += b->val;
+		if(bonus->propagator)
+			CBonusSystemNode::treeHasChanged(); //bonus may be visible on nodes outside of our subtree
+		else
+			nodeHasChanged();
+	}
 	else
 		addNewBonus(std::make_shared<Bonus>(*b)); //duplicate needed, original may get destroyed
 }
@@ -786,7 +998,6 @@ void CBonusSystemNode::removeBonus(const std::shared_ptr<Bonus>& b)
 		unpropagateBonus(b);
 	else
 		bonuses -= b;
-	CBonusSystemNode::treeHasChanged();
 }
 
 bool CBonusSystemNode::actsAsBonusSourceOnly() const
@@ -951,8 +1162,6 @@ void CBonusSystemNode::exportBonus(std::shared_ptr<Bonus> b)
 		propagateBonus(b);
 	else
 		bonuses.push_back(b);
-
-	CBonusSystemNode::treeHasChanged();
 }
 
 void CBonusSystemNode::exportBonuses()
@@ -1043,11 +1252,34 @@ TBonusListPtr CBonusSystemNode::limitBonuses(const BonusList &allBonuses) const
 	return ret;
 }
 
+void CBonusSystemNode::nodeHasChanged()
+{
+	invalidateChildrenNodes(++nodeChangeCounter);
+}
+
+void CBonusSystemNode::invalidateChildrenNodes(int64_t changeStamp)
+{
+	//bonus tree is a DAG - stop when node was already reached through another path
+	if(nodeChanged == changeStamp)
+		return;
+
+	nodeChanged = changeStamp;
+
+	for(CBonusSystemNode * child : children)
+		child->invalidateChildrenNodes(changeStamp);
+}
+
 void CBonusSystemNode::treeHasChanged()
 {
 	treeChanged++;
 }
 
+int64_t CBonusSystemNode::getTreeVersion() const
+{
+	//both counters only grow, so their sum changes whenever any of them does
+	return treeChanged + nodeChanged;
+}
+
 int NBonus::valOf(const CBonusSystemNode *obj, Bonus::BonusType type, int subtype)
 {
 	if(obj)
@@ -73,10 +73,11 @@ public:
 
 	const BonusList * operator->() const;
 private:
-	mutable int cachedLast;
+	mutable int64_t cachedLast;
 	const IBonusBearer * target;
 	CSelector selector;
 	mutable TBonusListPtr data;
+	mutable boost::mutex mx;
 };
 
 #define BONUS_TREE_DESERIALIZATION_FIX if(!h.saving && h.smartPointerSerialization) deserializationFix();
@@ -422,7 +423,7 @@ public:
 
 private:
 	TInternalContainer bonuses;
-	bool belongsToTree;
+	CBonusSystemNode * owner; //node whose bonuses are stored here, its subtree is invalidated on every change
 	void changed();
 
 public:
@@ -432,7 +433,7 @@ public:
 	typedef TInternalContainer::const_iterator const_iterator;
 	typedef TInternalContainer::iterator iterator;
 
-	BonusList(bool BelongsToTree = false);
+	explicit BonusList(CBonusSystemNode * Owner = nullptr);
 	BonusList(const BonusList &bonusList);
 	BonusList(BonusList && other);
 	BonusList& operator=(const BonusList &bonusList);
@@ -532,6 +533,109 @@ inline BonusList::const_iterator range_end(BonusList const &x)
 
 DLL_LINKAGE std::ostream & operator<<(std::ostream &out, const BonusList &bonusList);
 
+/// Compact identifier of a cached bonus request, replaces string caching keys on hot paths.
+/// Requests using equal keys must use equivalent selectors. Default constructed key disables caching.
+class DLL_LINKAGE BonusCacheKey
+{
+public:
+	enum EFlags : ui16
+	{
+		TYPE = 1,
+		SUBTYPE = 2,
+		INFO = 4,
+		SOURCE = 8,
+		SOURCE_ID = 16,
+		VALUE_TYPE = 32,
+		TURNS = 64, //bonus will last given number of turns
+		DAYS = 128, //bonus will last given number of days
+		EXCEPT_TYPE = 256, //bonuses of any type but the given one
+		COMPOSITE = 512, //predefined query from ECompositeQuery, stored as bonus type
+		LEGACY_STRING = 1024 //hash of string caching key
+	};
+
+	enum ECompositeQuery
+	{
+		MIN_DAMAGE,
+		MAX_DAMAGE,
+		NOT_LIVING
+	};
+
+	BonusCacheKey();
+	BonusCacheKey(const std::string & cachingStr); //legacy string keys are hashed into typed ones
+	BonusCacheKey(const char * cachingStr);
+
+	static BonusCacheKey type(Bonus::BonusType type);
+	static BonusCacheKey typeSubtype(Bonus::BonusType type, TBonusSubtype subtype);
+	static BonusCacheKey typeSubtypeInfo(Bonus::BonusType type, TBonusSubtype subtype, si32 info);
+	static BonusCacheKey source(Bonus::BonusSource source, ui32 sourceID);
+	static BonusCacheKey sourceType(Bonus::BonusSource source);
+	static BonusCacheKey composite(ECompositeQuery query);
+
+	BonusCacheKey withSource(Bonus::BonusSource source) const;
+	BonusCacheKey exceptType(Bonus::BonusType type) const;
+	BonusCacheKey valueType(Bonus::ValueType valType) const;
+	BonusCacheKey turns(int turns) const;
+	BonusCacheKey days(int days) const;
+
+	bool isValid() const
+	{
+		return flags != 0;
+	}
+
+	size_t hash() const;
+
+	bool operator==(const BonusCacheKey & other) const
+	{
+		return flags == other.flags && bonusSource == other.bonusSource && valType == other.valType
+			&& bonusType == other.bonusType && subtype == other.subtype
+			&& sourceID == other.sourceID && info == other.info;
+	}
+
+	bool operator!=(const BonusCacheKey & other) const
+	{
+		return !(*this == other);
+	}
+
+private:
+	ui16 flags;
+	ui8 bonusSource;
+	ui8 valType;
+	si32 bonusType;
+	si32 subtype;
+	si32 sourceID;
+	si32 info; //additional info or number of turns/days depending on flags
+};
+
+/// Per-node cache of bonus requests. Open addressing with linear probing over flat storage,
+/// entries are never removed one by one - whole cache is dropped when node changes.
+class DLL_LINKAGE BonusQueryCache
+{
+public:
+	BonusQueryCache();
+
+	TBonusListPtr find(const BonusCacheKey & key) const;
+	void insert(const BonusCacheKey & key, TBonusListPtr value);
+	void clear();
+
+	size_t size() const
+	{
+		return used;
+	}
+
+private:
+	struct Entry
+	{
+		BonusCacheKey key;
+		TBonusListPtr value;
+	};
+
+	std::vector<Entry> entries; //size is always zero or power of two
+	size_t used;
+
+	size_t findSlot(const BonusCacheKey & key) const;
+	void grow();
+};
+
 class DLL_LINKAGE IPropagator
 {
 public:
@@ -584,12 +688,13 @@ public:
 	// * selector is predicate that tests if HeroBonus matches our criteria
 	// * root is node on which call was made (nullptr will be replaced with this)
 	//interface
-	virtual const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const std::string &cachingStr = "") const = 0;
-	int valOfBonuses(const CSelector &selector, const std::string &cachingStr = "") const;
-	bool hasBonus(const CSelector &selector, const std::string &cachingStr = "") const;
-	bool hasBonus(const CSelector &selector, const CSelector &limit, const std::string &cachingStr = "") const;
-	const TBonusListPtr getBonuses(const CSelector &selector, const CSelector &limit, const std::string &cachingStr = "") const;
-	const TBonusListPtr getBonuses(const CSelector &selector, const std::string &cachingStr = "") const;
+	// * cachingKey identifies request for caching purposes, see BonusCacheKey
+	virtual const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const BonusCacheKey &cachingKey = BonusCacheKey()) const = 0;
+	int valOfBonuses(const CSelector &selector, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	bool hasBonus(const CSelector &selector, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	bool hasBonus(const CSelector &selector, const CSelector &limit, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	const TBonusListPtr getBonuses(const CSelector &selector, const CSelector &limit, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	const TBonusListPtr getBonuses(const CSelector &selector, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
 
 	const std::shared_ptr<Bonus> getBonus(const CSelector &selector) const; //returns any bonus visible on node that matches (or nullptr if none matches)
 
@@ -613,6 +718,8 @@ public:
 
 	si32 manaLimit() const; //maximum mana value for this hero (basically 10*knowledge)
 	int getPrimSkillLevel(PrimarySkill::PrimarySkill id) const;
+
+	virtual int64_t getTreeVersion() const = 0; //changes whenever bonuses visible on this bearer may have changed
 };
 
 class DLL_LINKAGE CBonusSystemNode : public IBonusBearer, public boost::noncopyable
@@ -624,8 +731,8 @@ public:
 		TOWN_AND_VISITOR, BATTLE, COMMANDER, GLOBAL_EFFECTS
 	};
 private:
-	BonusList bonuses; //wielded bonuses (local or up-propagated here)
-	BonusList exportedBonuses; //bonuses coming from this node (wielded or propagated away)
+	BonusList bonuses; //wielded bonuses (local or up-propagated here), owned by this node so changes invalidate its subtree
+	BonusList exportedBonuses; //bonuses coming from this node (wielded or propagated away), caches see them only through bonuses
 
 	TNodesVector parents; //parents -> we inherit bonuses from them, we may attach our bonuses to them
 	TNodesVector children;
@@ -635,16 +742,19 @@ private:
 
 	static const bool cachingEnabled;
 	mutable BonusList cachedBonuses;
-	mutable int cachedLast;
-	static int treeChanged;
+	mutable int64_t cachedLast;
+	static int64_t treeChanged; //global epoch, bumped when a change can't be attributed to a single subtree
+	static int64_t nodeChangeCounter; //source of unique stamps for subtree invalidation
+	int64_t nodeChanged; //stamp of the last change of this node or any of its ancestors
 
-	// Setting a value to cachingStr before getting any bonuses caches the result for later requests.
-	// This string needs to be unique, that's why it has to be setted in the following manner:
-	// [property key]_[value] => only for selector
-	mutable std::map<std::string, TBonusListPtr > cachedRequests;
+	// Setting a value to cachingKey before getting any bonuses caches the result for later requests.
+	// Key needs to be unique for given selector, see BonusCacheKey
+	mutable BonusQueryCache cachedRequests;
+	mutable boost::mutex cacheMx; //guards cachedBonuses, cachedLast and cachedRequests
 
 	void getBonusesRec(BonusList &out, const CSelector &selector, const CSelector &limit) const;
 	void getAllBonusesRec(BonusList &out) const;
+	void invalidateChildrenNodes(int64_t changeStamp);
 	const TBonusListPtr getAllBonusesWithoutCaching(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr) const;
 
 public:
@@ -654,7 +764,7 @@ public:
 
 	void limitBonuses(const BonusList &allBonuses, BonusList &out) const; //out will bo populed with bonuses that are not limited here
 	TBonusListPtr limitBonuses(const BonusList &allBonuses) const; //same as above, returns out by val for convienence
-	const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const std::string &cachingStr = "") const override;
+	const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const BonusCacheKey &cachingKey = BonusCacheKey()) const override;
 	void getParents(TCNodes &out) const;  //retrieves list of parent nodes (nodes to inherit bonuses from),
 	const std::shared_ptr<Bonus> getBonusLocalFirst(const CSelector &selector) const;
 
@@ -702,8 +812,13 @@ public:
 	const std::string &getDescription() const;
 	void setDescription(const std::string &description);
 
+	///invalidates cached bonuses of this node and all its descendants
+	void nodeHasChanged();
+	///invalidates cached bonuses of every node, use when change can't be tied to a single node
 	static void treeHasChanged();
 
+	int64_t getTreeVersion() const override;
+
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
 //		h & bonuses;
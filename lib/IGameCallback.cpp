@@ -20,6 +20,7 @@
 #include "serializer/CSerializer.h" // for SAVEGAME_MAGIC
 #include "serializer/BinaryDeserializer.h"
 #include "serializer/BinarySerializer.h"
+#include "serializer/CSaveBuffer.h"
 #include "serializer/CLoadIntegrityValidator.h"
 #include "rmg/CMapGenOptions.h"
 #include "mapping/CCampaignHandler.h"
@@ -64,25 +65,27 @@ void CPrivilagedInfoCallback::getTilesInRange(std::unordered_set<int3, ShashInt3
 	else
 	{
 		const TeamState * team = !player ? nullptr : gs->getPlayerTeam(*player);
-		for (int xd = std::max<int>(pos.x - radious , 0); xd <= std::min<int>(pos.x + radious, gs->map->width - 1); xd++)
+		auto insertTile = [&tiles](const int3 & tile)
 		{
-			for (int yd = std::max<int>(pos.y - radious, 0); yd <= std::min<int>(pos.y + radious, gs->map->height - 1); yd++)
+			tiles.insert(tile);
+		};
+
+		for (int yd = std::max<int>(pos.y - radious, 0); yd <= std::min<int>(pos.y + radious, gs->map->height - 1); yd++)
+		{
+			const int reach = FogOfWarMap::getRowReach(radious, yd - pos.y, patrolDistance);
+			if(reach < 0)
+				continue;
+
+			const int x1 = std::max<int>(pos.x - reach, 0);
+			const int x2 = std::min<int>(pos.x + reach, gs->map->width - 1);
+			if(!player)
+			{
+				for(int xd = x1; xd <= x2; xd++)
+					tiles.insert(int3(xd, yd, pos.z));
+			}
+			else if(mode == 1 || mode == -1)
 			{
-				int3 tilePos(xd,yd,pos.z);
-				double distance;
-				if(patrolDistance)
-					distance = pos.mandist2d(tilePos);
-				else
-					distance = pos.dist2d(tilePos) - 0.5;
-
-				if(distance <= radious)
-				{
-					if(!player
-						|| (mode == 1  && team->fogOfWarMap[xd][yd][pos.z]==0)
-						|| (mode == -1 && team->fogOfWarMap[xd][yd][pos.z]==1)
-					)
-						tiles.insert(int3(xd,yd,pos.z));
-				}
+				team->fogOfWarMap.forEachInSpan(x1, x2, yd, pos.z, mode == -1, insertTile);
 			}
 		}
 	}
@@ -109,17 +112,15 @@ void CPrivilagedInfoCallback::getAllTiles(std::unordered_set<int3, ShashInt3> &t
 	else
 		floors.push_back(level);
 
+	const auto & terrain = gs->map->getTiles();
+	const size_t levelSize = gs->map->width * gs->map->height;
 	for (auto zd : floors)
 	{
-
-		for (int xd = 0; xd < gs->map->width; xd++)
+		for (size_t index = zd * levelSize; index < (zd + 1) * levelSize; index++)
 		{
-			for (int yd = 0; yd < gs->map->height; yd++)
-			{
-				if ((getTile (int3 (xd,yd,zd))->terType == ETerrainType::WATER && water)
-					|| (getTile (int3 (xd,yd,zd))->terType != ETerrainType::WATER && land))
-					tiles.insert(int3(xd,yd,zd));
-			}
+			const bool isWater = terrain[index].terType == ETerrainType::WATER;
+			if ((isWater && water) || (!isWater && land))
+				tiles.insert(gs->map->getTilePos(index));
 		}
 	}
 }
@@ -183,16 +184,20 @@ void CPrivilagedInfoCallback::saveCommonState(Saver &out) const
 	out.serializer & static_cast<CMapHeader&>(*gs->map);
 	logGlobal->info("\tSaving options");
 	out.serializer & gs->scenarioOps;
+	out.startSection();
 	logGlobal->info("\tSaving handlers");
 	out.serializer & *VLC;
+	out.startSection();
 	logGlobal->info("\tSaving gamestate");
 	out.serializer & gs;
+	out.startSection();
 }
 
 // hardly memory usage for `-gdwarf-4` flag
 template DLL_LINKAGE void CPrivilagedInfoCallback::loadCommonState<CLoadIntegrityValidator>(CLoadIntegrityValidator&);
 template DLL_LINKAGE void CPrivilagedInfoCallback::loadCommonState<CLoadFile>(CLoadFile&);
 template DLL_LINKAGE void CPrivilagedInfoCallback::saveCommonState<CSaveFile>(CSaveFile&) const;
+template DLL_LINKAGE void CPrivilagedInfoCallback::saveCommonState<CSaveBuffer>(CSaveBuffer&) const;
 
 TerrainTile * CNonConstInfoCallback::getTile( int3 pos )
 {
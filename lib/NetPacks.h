@@ -31,6 +31,7 @@ class CCampaignState;
 class CArtifact;
 class CSelectionScreen;
 class CGObjectInstance;
+class CGDwelling;
 class CArtifactInstance;
 struct StackLocation;
 struct ArtSlotInfo;
@@ -605,6 +606,8 @@ struct RemoveObject : public CPackForClient
 
 	ObjectInstanceID id;
 
+	std::unordered_set<int3, ShashInt3> affectedTiles; //used locally during applying to client
+
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
 		h & id;
@@ -684,17 +687,32 @@ struct RazeStructures : public CPackForClient
 
 struct SetAvailableCreatures : public CPackForClient
 {
-	SetAvailableCreatures(){}
+	SetAvailableCreatures():full(true), version(0){}
 	void applyCl(CClient *cl);
+	void requestResyncIfMissed(CClient *cl) const;
 	DLL_LINKAGE void applyGs(CGameState *gs);
 
+	/// Turns pack into delta against current state of dwelling: if creature types did not change only changed counts are sent.
+	/// Returns false if pack would not change anything
+	DLL_LINKAGE bool encodeDelta(const CGDwelling * dwelling);
+	/// Returns false if this is a delta not following the version of dwelling (some update was missed) and nothing was changed
+	DLL_LINKAGE bool applyTo(CGDwelling * dwelling) const;
+
 	ObjectInstanceID tid;
-	std::vector<std::pair<ui32, std::vector<CreatureID> > > creatures;
+	std::vector<std::pair<ui32, std::vector<CreatureID> > > creatures; //empty if not full
+	bool full; //if false, only counts in changedCounts are updated
+	std::vector<std::pair<ui8, ui32> > changedCounts; //level => new amount
+	ui32 version; //creatures version of dwelling after applying, 0 if pack was not encoded (version is just incremented)
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
 		h & tid;
-		h & creatures;
+		h & full;
+		if(full)
+			h & creatures;
+		else
+			h & changedCounts;
+		h & this->version;
 	}
 };
 
@@ -1041,9 +1059,9 @@ struct NewTurn : public CPackForClient
 		bool operator<(const Hero&h)const{return id < h.id;}
 	};
 
-	std::set<Hero> heroes; //updates movement and mana points
-	std::map<PlayerColor, TResources> res; //player ID => resource value[res_id]
-	std::map<ObjectInstanceID, SetAvailableCreatures> cres;//creatures to be placed in towns
+	std::set<Hero> heroes; //updates movement and mana points, only heroes which values change
+	std::map<PlayerColor, TResources> res; //player ID => resource value[res_id], only players which resources change
+	std::map<ObjectInstanceID, SetAvailableCreatures> cres;//creatures to be placed in towns, encoded as deltas
 	ui32 day;
 	ui8 specialWeek; //weekType
 	CreatureID creatureid; //for creature weeks
@@ -2315,6 +2333,18 @@ struct DigWithHero : public CPackForServer
 	}
 };
 
+struct RequestAvailableCreatures : public CPackForServer
+{
+	RequestAvailableCreatures(){}
+	ObjectInstanceID tid; //dwelling which state client has lost track of
+
+	bool applyGh(CGameHandler *gh);
+	template <typename Handler> void serialize(Handler &h, const int version)
+	{
+		h & tid;
+	}
+};
+
 struct CastAdvSpell : public CPackForServer
 {
 	CastAdvSpell(){}
@@ -123,6 +123,7 @@ DLL_LINKAGE void SetCommanderProperty::applyGs(CGameState *gs)
 			break;
 		case EXPERIENCE:
 			commander->giveStackExp(amount); //TODO: allow setting exp for stacks via netpacks
+			commander->nodeHasChanged();
 			break;
 	}
 }
@@ -220,10 +221,9 @@ DLL_LINKAGE void FoWChange::applyGs(CGameState *gs)
 {
 	TeamState * team = gs->getPlayerTeam(player);
 	for(int3 t : tiles)
-		team->fogOfWarMap[t.x][t.y][t.z] = mode;
+		team->fogOfWarMap.setVisible(t, mode != 0);
 	if (mode == 0) //do not hide too much
 	{
-		std::unordered_set<int3, ShashInt3> tilesRevealed;
 		for (auto & elem : gs->map->objects)
 		{
 			const CGObjectInstance *o = elem;
@@ -236,13 +236,11 @@ DLL_LINKAGE void FoWChange::applyGs(CGameState *gs)
 				case Obj::TOWN:
 				case Obj::ABANDONED_MINE:
 					if(vstd::contains(team->players, o->tempOwner)) //check owned observators
-						gs->getTilesInRange(tilesRevealed, o->getSightCenter(), o->getSightRadius(), o->tempOwner, 1);
+						team->fogOfWarMap.revealRadius(o->getSightCenter(), o->getSightRadius());
 					break;
 				}
 			}
 		}
-		for(int3 t : tilesRevealed) //probably not the most optimal solution ever
-			team->fogOfWarMap[t.x][t.y][t.z] = 1;
 	}
 }
 
@@ -557,7 +555,7 @@ void TryMoveHero::applyGs(CGameState *gs)
 	}
 
 	for(int3 t : fowRevealed)
-		gs->getPlayerTeam(h->getOwner())->fogOfWarMap[t.x][t.y][t.z] = 1;
+		gs->getPlayerTeam(h->getOwner())->fogOfWarMap.reveal(t);
 }
 
 DLL_LINKAGE void NewStructures::applyGs(CGameState *gs)
@@ -586,11 +584,63 @@ DLL_LINKAGE void RazeStructures::applyGs(CGameState *gs)
 	t->recreateBuildingsBonuses();
 }
 
+DLL_LINKAGE bool SetAvailableCreatures::encodeDelta(const CGDwelling * dwelling)
+{
+	version = dwelling->creaturesVersion + 1;
+	changedCounts.clear();
+	full = creatures.size() != dwelling->creatures.size();
+
+	for(size_t level = 0; level < creatures.size() && !full; level++)
+	{
+		if(creatures[level].second != dwelling->creatures[level].second)
+			full = true;
+		else if(creatures[level].first != dwelling->creatures[level].first)
+			changedCounts.push_back(std::make_pair(static_cast<ui8>(level), creatures[level].first));
+	}
+
+	if(full)
+	{
+		changedCounts.clear();
+		return true;
+	}
+	creatures.clear();
+	return !changedCounts.empty();
+}
+
+DLL_LINKAGE bool SetAvailableCreatures::applyTo(CGDwelling * dwelling) const
+{
+	if(full)
+	{
+		dwelling->creatures = creatures;
+		dwelling->creaturesVersion = version ? version : dwelling->creaturesVersion + 1;
+		return true;
+	}
+
+	if(version != dwelling->creaturesVersion + 1)
+	{
+		logGlobal->warn("Creatures of dwelling %d are at version %d, cannot apply delta for version %d", tid.getNum(), dwelling->creaturesVersion, version);
+		return false;
+	}
+
+	for(auto & change : changedCounts)
+	{
+		if(change.first >= dwelling->creatures.size())
+		{
+			logGlobal->error("Dwelling %d has no creatures of level %d", tid.getNum(), static_cast<int>(change.first));
+			return false;
+		}
+	}
+	for(auto & change : changedCounts)
+		dwelling->creatures[change.first].first = change.second;
+	dwelling->creaturesVersion = version;
+	return true;
+}
+
 DLL_LINKAGE void SetAvailableCreatures::applyGs(CGameState *gs)
 {
 	CGDwelling *dw = dynamic_cast<CGDwelling*>(gs->getObjInstance(tid));
 	assert(dw);
-	dw->creatures = creatures;
+	applyTo(dw);
 }
 
 DLL_LINKAGE void SetHeroesInTown::applyGs(CGameState *gs)
@@ -952,7 +1002,10 @@ DLL_LINKAGE void RebalanceStacks::applyGs(CGameState *gs)
 		}
 	}
 
-	CBonusSystemNode::treeHasChanged();
+	//experience of stacks decides which of their bonuses pass rank limiters
+	src.army->nodeHasChanged();
+	if(dst.army.get() != src.army.get())
+		dst.army->nodeHasChanged();
 }
 
 DLL_LINKAGE void PutArtifact::applyGs(CGameState *gs)
@@ -1304,7 +1357,10 @@ DLL_LINKAGE void BattleTriggerEffect::applyGs(CGameState *gs)
 		auto b = st->getBonusLocalFirst(Selector::source(Bonus::SPELL_EFFECT, SpellID::POISON)
 				.And(Selector::type(Bonus::STACK_HEALTH)));
 		if (b)
+		{
 			b->val = val;
+			st->nodeHasChanged();
+		}
 		break;
 	}
 	case Bonus::ENCHANTER:
@@ -1361,10 +1417,13 @@ void BattleResult::applyGs(CGameState *gs)
 	if(VLC->modh->modules.STACK_EXP)
 	{
 		for(int i = 0; i < 2; i++)
+		{
 			if(exp[i])
+			{
 				gs->curB->battleGetArmyObject(i)->giveStackExp(exp[i]);
-
-		CBonusSystemNode::treeHasChanged();
+				gs->curB->battleGetArmyObject(i)->nodeHasChanged();
+			}
+		}
 	}
 
 	for(int i = 0; i < 2; i++)
@@ -1543,7 +1602,7 @@ void actualizeEffect(CStack * s, const Bonus & ef)
 			stackBonus->turnsRemain = std::max(stackBonus->turnsRemain, ef.turnsRemain);
 		}
 	}
-	CBonusSystemNode::treeHasChanged();
+	s->nodeHasChanged();
 }
 
 void actualizeEffect(CStack * s, const std::vector<Bonus> & ef)
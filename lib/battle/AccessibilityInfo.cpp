@@ -20,18 +20,23 @@ bool AccessibilityInfo::accessible(BattleHex tile, const CStack * stack) const
 bool AccessibilityInfo::accessible(BattleHex tile, bool doubleWide, ui8 side) const
 {
 	// All hexes that stack would cover if standing on tile have to be accessible.
-	for(auto hex : CStack::getHexes(tile, doubleWide, side))
-	{
-		// If the hex is out of range then the tile isn't accessible
-		if(!hex.isValid())
-			return false;
-		// If we're no defender which step on gate and the hex isn't accessible, then the tile
-		// isn't accessible
-		else if(at(hex) != EAccessibility::ACCESSIBLE &&
-				!(at(hex) == EAccessibility::GATE && side == BattleSide::DEFENDER))
-		{
-			return false;
-		}
-	}
+	// Same hexes as CStack::getHexes, checked without allocating them - this is called for every hex by BFS.
+	if(!tileAccessible(tile, side))
+		return false;
+
+	if(doubleWide)
+		return tileAccessible(side == BattleSide::ATTACKER ? tile - 1 : tile + 1, side);
+
 	return true;
 }
+
+bool AccessibilityInfo::tileAccessible(BattleHex hex, ui8 side) const
+{
+	// If the hex is out of range then the tile isn't accessible
+	if(!hex.isValid())
+		return false;
+
+	// If we're no defender which step on gate and the hex isn't accessible, then the tile
+	// isn't accessible
+	return at(hex) == EAccessibility::ACCESSIBLE || (at(hex) == EAccessibility::GATE && side == BattleSide::DEFENDER);
+}
@@ -32,4 +32,7 @@ struct DLL_LINKAGE AccessibilityInfo : TAccessibilityArray
 {
 	bool accessible(BattleHex tile, const CStack * stack) const; //checks for both tiles if stack is double wide
 	bool accessible(BattleHex tile, bool doubleWide, ui8 side) const; //checks for both tiles if stack is double wide
+
+private:
+	bool tileAccessible(BattleHex tile, ui8 side) const;
 };
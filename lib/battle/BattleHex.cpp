@@ -134,6 +134,27 @@ std::vector<BattleHex> BattleHex::neighbouringTiles() const
 	return ret;
 }
 
+namespace
+{
+	typedef std::array<BattleHex::NeighbouringTiles, GameConstants::BFIELD_SIZE> TNeighbouringTilesTable;
+
+	TNeighbouringTilesTable calculateNeighbouringTiles()
+	{
+		TNeighbouringTilesTable ret; //default constructed hexes are INVALID
+		for(si16 hex = 0; hex < GameConstants::BFIELD_SIZE; hex++)
+			boost::copy(BattleHex(hex).neighbouringTiles(), ret[hex].begin());
+		return ret;
+	}
+}
+
+const BattleHex::NeighbouringTiles & BattleHex::precomputedNeighbouringTiles() const
+{
+	static const TNeighbouringTilesTable table = calculateNeighbouringTiles();
+
+	assert(isValid());
+	return table[hex];
+}
+
 signed char BattleHex::mutualPosition(BattleHex hex1, BattleHex hex2)
 {
 	for(EDir dir = EDir(0); dir <= EDir(5); dir = EDir(dir+1))
@@ -57,6 +57,10 @@ struct DLL_LINKAGE BattleHex //TODO: decide if this should be changed to class f
 	BattleHex cloneInDirection(EDir dir, bool hasToBeValid = true) const;
 	BattleHex operator+(EDir dir) const;
 	std::vector<BattleHex> neighbouringTiles() const;
+
+	typedef std::array<BattleHex, 6> NeighbouringTiles;
+	/// Same tiles as neighbouringTiles() taken from precomputed table, unused entries at the end are INVALID. Hex must be valid
+	const NeighbouringTiles & precomputedNeighbouringTiles() const;
 	static signed char mutualPosition(BattleHex hex1, BattleHex hex2);
 	static char getDistance(BattleHex hex1, BattleHex hex2);
 	static void checkAndPush(BattleHex tile, std::vector<BattleHex> & ret);
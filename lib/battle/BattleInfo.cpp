@@ -719,12 +719,23 @@ CStack * BattleInfo::getStack(int stackID, bool onlyAlive)
 BattleInfo::BattleInfo()
 	: round(-1), activeStack(-1), selectedStack(-1), town(nullptr), tile(-1,-1,-1),
 	battlefieldType(BFieldType::NONE), terrainType(ETerrainType::WRONG),
-	tacticsSide(0), tacticDistance(0)
+	tacticsSide(0), tacticDistance(0), stateVersion(0)
 {
 	setBattle(this);
 	setNodeType(BATTLE);
 }
 
+void BattleInfo::beginStateChange()
+{
+	stateVersion = 0;
+}
+
+void BattleInfo::endStateChange()
+{
+	static std::atomic<ui64> lastStateVersion(0);
+	stateVersion = ++lastStateVersion;
+}
+
 CArmedInstance * BattleInfo::battleGetArmyObject(ui8 side) const
 {
 	return const_cast<CArmedInstance*>(CBattleInfoEssentials::battleGetArmyObject(side));
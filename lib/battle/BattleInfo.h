@@ -34,6 +34,12 @@ struct DLL_LINKAGE BattleInfo : public CBonusSystemNode, public CBattleInfoCallb
 	ui8 tacticsSide; //which side is requested to play tactics phase
 	ui8 tacticDistance; //how many hexes we can go forward (1 = only hexes adjacent to margin line)
 
+	/// Identifies current battle state for caches of derived data (e.g. accessibility), unique across all battles.
+	/// 0 while the state is being set up or changed, such state must not be cached. Not serialized
+	ui64 stateVersion;
+	/// Damage ranges calculated for current state version. Not serialized
+	mutable DamageCache damageCache;
+
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
 		h & sides;
@@ -56,6 +62,10 @@ struct DLL_LINKAGE BattleInfo : public CBonusSystemNode, public CBattleInfoCallb
 	BattleInfo();
 	~BattleInfo(){};
 
+	/// Called around every change applied to battle, see stateVersion
+	void beginStateChange();
+	void endStateChange();
+
 	//////////////////////////////////////////////////////////////////////////
 	CStack * getStack(int stackID, bool onlyAlive = true);
 	using CBattleInfoEssentials::battleGetArmyObject;
@@ -11,6 +11,7 @@
 #include "CBattleInfoCallback.h"
 #include "../CStack.h"
 #include "BattleInfo.h"
+#include "DamageFormula.h"
 #include "../NetPacks.h"
 #include "../spells/CSpellHandler.h"
 #include "../mapObjects/CGTownInstance.h"
@@ -32,17 +33,10 @@ static void retreiveTurretDamageRange(const CGTownInstance * town, const CStack
 	outMaxDmg = multiplier * (baseMax + town->getTownLevel() * 3);
 }
 
-static BattleHex lineToWallHex(int line) //returns hex with wall in given line (y coordinate)
-{
-	static const BattleHex lineToHex[] = {12, 29, 45, 62, 78, 95, 112, 130, 147, 165, 182};
-
-	return lineToHex[line];
-}
-
 static bool sameSideOfWall(BattleHex pos1, BattleHex pos2)
 {
-	const int wallInStackLine = lineToWallHex(pos1.getY());
-	const int wallInDestLine = lineToWallHex(pos2.getY());
+	const int wallInStackLine = CBattleInfoCallback::lineToWallHex(pos1.getY());
+	const int wallInDestLine = CBattleInfoCallback::lineToWallHex(pos2.getY());
 
 	const bool stackLeft = pos1 < wallInStackLine;
 	const bool destLeft = pos2 < wallInDestLine;
@@ -94,6 +88,11 @@ static BattleHex WallPartToHex(EWallPart::EWallPart part)
 
 using namespace SiegeStuffThatShouldBeMovedToHandlers;
 
+CBattleInfoCallback::CBattleInfoCallback()
+	: accessibilityCacheVersion(0)
+{
+}
+
 ESpellCastProblem::ESpellCastProblem CBattleInfoCallback::battleCanCastSpell(const ISpellCaster * caster, ECastingMode::ECastingMode mode) const
 {
 	RETURN_IF_NOT_BATTLE(ESpellCastProblem::INVALID);
@@ -148,6 +147,25 @@ si8 CBattleInfoCallback::battleHasWallPenalty(const IBonusBearer * bonusBearer,
 	if (!battleGetSiegeLevel() || bonusBearer->hasBonusOfType(Bonus::NO_WALL_PENALTY))
 		return false;
 
+	const int row = wallLineOfShot(shooterPosition, destHex);
+	if (row >= 0)
+	{
+		const int wallPos = lineToWallHex(row);
+		if (!isWallPartPotentiallyAttackable(battleHexToWallPart(wallPos))) return true;
+	}
+
+	return false;
+}
+
+BattleHex CBattleInfoCallback::lineToWallHex(int line)
+{
+	static const BattleHex lineToHex[] = {12, 29, 45, 62, 78, 95, 112, 130, 147, 165, 182};
+
+	return lineToHex[line];
+}
+
+int CBattleInfoCallback::wallLineOfShot(BattleHex shooterPosition, BattleHex destHex)
+{
 	const int wallInStackLine = lineToWallHex(shooterPosition.getY());
 	const int wallInDestLine = lineToWallHex(destHex.getY());
 
@@ -159,11 +177,10 @@ si8 CBattleInfoCallback::battleHasWallPenalty(const IBonusBearer * bonusBearer,
 		int row = (shooterPosition + destHex) / (2 * GameConstants::BFIELD_WIDTH);
 		if (shooterPosition > destHex && ((destHex % GameConstants::BFIELD_WIDTH - shooterPosition % GameConstants::BFIELD_WIDTH) < 2)) //shooting up high
 			row -= 2;
-		const int wallPos = lineToWallHex(row);
-		if (!isWallPartPotentiallyAttackable(battleHexToWallPart(wallPos))) return true;
+		return std::max(row, -1);
 	}
 
-	return false;
+	return -1;
 }
 
 si8 CBattleInfoCallback::battleCanTeleportTo(const CStack * stack, BattleHex destHex, int telportLevel) const
@@ -516,7 +533,7 @@ bool CBattleInfoCallback::battleCanShoot(const CStack * stack, BattleHex dest) c
 		return false;
 
 	//forgetfulness
-	TBonusListPtr forgetfulList = stack->getBonuses(Selector::type(Bonus::FORGETFULL),"");
+	TBonusListPtr forgetfulList = stack->getBonuses(Selector::type(Bonus::FORGETFULL), BonusCacheKey::type(Bonus::FORGETFULL));
 	if(!forgetfulList->empty())
 	{
 		int forgetful = forgetfulList->valOfBonuses(Selector::type(Bonus::FORGETFULL));
@@ -538,6 +555,32 @@ bool CBattleInfoCallback::battleCanShoot(const CStack * stack, BattleHex dest) c
 }
 
 TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info) const
+{
+	DamageCache * cache = battleDamageCache();
+	const ui64 version = battleStateVersion();
+
+	//hypothetic bonus bearers (eg. used by AI) may differ from stacks without changing tree version, they are not cached
+	if(!cache || !version || info.attackerBonuses != info.attacker || info.defenderBonuses != info.defender)
+		return calculateDmgRangeUncached(info);
+
+	const DamageCache::Key key(info);
+	TDmgRange ret;
+	if(cache->find(version, key, ret))
+		return ret;
+
+	ret = calculateDmgRangeUncached(info);
+	cache->insert(version, key, ret);
+	return ret;
+}
+
+DamageCache::Stats CBattleInfoCallback::battleDamageCacheStats() const
+{
+	DamageCache::Stats ret = {0, 0, 0, 0};
+	RETURN_IF_NOT_BATTLE(ret);
+	return battleDamageCache()->getStats();
+}
+
+TDmgRange CBattleInfoCallback::calculateDmgRangeUncached(const BattleAttackInfo & info) const
 {
 	auto battleBonusValue = [&](const IBonusBearer * bearer, CSelector selector) -> int
 	{
@@ -550,9 +593,11 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 		return bearer->getBonuses(selector, noLimit.Or(limitMatches))->totalValue();
 	};
 
-	double additiveBonus = 1.0, multBonus = 1.0,
-			minDmg = info.attackerBonuses->getMinDamage() * info.attackerHealth.getCount(),//TODO: ONLY_MELEE_FIGHT / ONLY_DISTANCE_FIGHT
-			maxDmg = info.attackerBonuses->getMaxDamage() * info.attackerHealth.getCount();
+	DamageFormula formula;
+	double & minDmg = formula.minDamage;
+	double & maxDmg = formula.maxDamage;
+	minDmg = info.attackerBonuses->getMinDamage() * info.attackerHealth.getCount();//TODO: ONLY_MELEE_FIGHT / ONLY_DISTANCE_FIGHT
+	maxDmg = info.attackerBonuses->getMaxDamage() * info.attackerHealth.getCount();
 
 	const CCreature *attackerType = info.attacker->getCreature(),
 			*defenderType = info.defender->getCreature();
@@ -575,13 +620,10 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 		maxDmg *= retreiveHeroPrimSkill(PrimarySkill::ATTACK) + 1;
 	}
 
-	int attackDefenceDifference = 0;
-
-	double multAttackReduction = (100 - battleBonusValue (info.attackerBonuses, Selector::type(Bonus::GENERAL_ATTACK_REDUCTION))) / 100.0;
-	attackDefenceDifference += battleBonusValue (info.attackerBonuses, Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK)) * multAttackReduction;
-
-	double multDefenceReduction = (100 - battleBonusValue (info.attackerBonuses, Selector::type(Bonus::ENEMY_DEFENCE_REDUCTION))) / 100.0;
-	attackDefenceDifference -= info.defenderBonuses->Defense() * multDefenceReduction;
+	formula.attackReduction = battleBonusValue(info.attackerBonuses, Selector::type(Bonus::GENERAL_ATTACK_REDUCTION));
+	formula.attack = battleBonusValue(info.attackerBonuses, Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK));
+	formula.enemyDefenceReduction = battleBonusValue(info.attackerBonuses, Selector::type(Bonus::ENEMY_DEFENCE_REDUCTION));
+	formula.defense = info.defenderBonuses->Defense();
 
 	if(const std::shared_ptr<Bonus> slayerEffect = info.attackerBonuses->getBonus(Selector::type(Bonus::SLAYER))) //slayer handling //TODO: apply only ONLY_MELEE_FIGHT / DISTANCE_FIGHT?
 	{
@@ -607,78 +649,41 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 		{
 			if(defenderType->idNumber == affectedId)
 			{
-				attackDefenceDifference += SpellID(SpellID::SLAYER).toSpell()->getPower(spLevel);
+				formula.slayerPower = SpellID(SpellID::SLAYER).toSpell()->getPower(spLevel);
 				break;
 			}
 		}
 	}
 
-	//bonus from attack/defense skills
-	if(attackDefenceDifference < 0) //decreasing dmg
-	{
-		const double dec = std::min(0.025 * (-attackDefenceDifference), 0.7);
-		multBonus *= 1.0 - dec;
-	}
-	else //increasing dmg
-	{
-		const double inc = std::min(0.05 * attackDefenceDifference, 4.0);
-		additiveBonus += inc;
-	}
-
 	//applying jousting bonus
 	if(info.attackerBonuses->hasBonusOfType(Bonus::JOUSTING) && !info.defenderBonuses->hasBonusOfType(Bonus::CHARGE_IMMUNITY))
-		additiveBonus += info.chargedFields * 0.05;
+		formula.chargedFields = info.chargedFields;
 
 	//handling secondary abilities and artifacts giving premies to them
 	if(info.shooting)
-		additiveBonus += info.attackerBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARCHERY) / 100.0;
+		formula.skillPremy = info.attackerBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARCHERY);
 	else
-		additiveBonus += info.attackerBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::OFFENCE) / 100.0;
+		formula.skillPremy = info.attackerBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::OFFENCE);
 
-	if(info.defenderBonuses)
-		multBonus *= (std::max(0, 100 - info.defenderBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARMORER))) / 100.0;
+	formula.armorer = info.defenderBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARMORER);
 
 	//handling hate effect
-	additiveBonus += info.attackerBonuses->valOfBonuses(Bonus::HATE, defenderType->idNumber.toEnum()) / 100.;
+	formula.hate = info.attackerBonuses->valOfBonuses(Bonus::HATE, defenderType->idNumber.toEnum());
 
-	//luck bonus
-	if (info.luckyHit)
-	{
-		additiveBonus += 1.0;
-	}
-	//unlucky hit, used only if negative luck is enabled
-	if (info.unluckyHit)
-	{
-		additiveBonus -= 0.5; // FIXME: how bad (and luck in general) should work with following bonuses?
-	}
+	formula.luckyHit = info.luckyHit;
+	formula.unluckyHit = info.unluckyHit;
+	formula.ballistaDoubleDamage = info.ballistaDoubleDamage;
+	formula.deathBlow = info.deathBlow; //Dread Knight and many WoGified creatures
 
-	//ballista double dmg
-	if(info.ballistaDoubleDamage)
-	{
-		additiveBonus += 1.0;
-	}
-
-	if (info.deathBlow) //Dread Knight and many WoGified creatures
-	{
-		additiveBonus += 1.0;
-	}
-
-	//handling spell effects
-	if(!info.shooting) //eg. shield
-	{
-		multBonus *= (100 - info.defenderBonuses->valOfBonuses(Bonus::GENERAL_DAMAGE_REDUCTION, 0)) / 100.0;
-	}
-	else if(info.shooting) //eg. air shield
-	{
-		multBonus *= (100 - info.defenderBonuses->valOfBonuses(Bonus::GENERAL_DAMAGE_REDUCTION, 1)) / 100.0;
-	}
+	//handling spell effects, eg. shield for melee and air shield for shooting
+	formula.damageReduction = info.defenderBonuses->valOfBonuses(Bonus::GENERAL_DAMAGE_REDUCTION, info.shooting ? 1 : 0);
 
 	if(info.shooting)
 	{
 		//todo: set actual percentage in spell bonus configuration instead of just level; requires non trivial backward compatibility handling
 
 		//get list first, total value of 0 also counts
-		TBonusListPtr forgetfulList = info.attackerBonuses->getBonuses(Selector::type(Bonus::FORGETFULL),"");
+		TBonusListPtr forgetfulList = info.attackerBonuses->getBonuses(Selector::type(Bonus::FORGETFULL), BonusCacheKey::type(Bonus::FORGETFULL));
 
 		if(!forgetfulList->empty())
 		{
@@ -686,7 +691,7 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 
 			//none of basic level
 			if(forgetful == 0 || forgetful == 1)
-				multBonus *= 0.5;
+				formula.halvingPenalties++;
 			else
 				logGlobal->warn("Attempt to calculate shooting damage with adv+ FORGETFULL effect");
 		}
@@ -694,13 +699,12 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 
 	TBonusListPtr curseEffects = info.attackerBonuses->getBonuses(Selector::type(Bonus::ALWAYS_MINIMUM_DAMAGE));
 	TBonusListPtr blessEffects = info.attackerBonuses->getBonuses(Selector::type(Bonus::ALWAYS_MAXIMUM_DAMAGE));
-	int curseBlessAdditiveModifier = blessEffects->totalValue() - curseEffects->totalValue();
-	double curseMultiplicativePenalty = curseEffects->size() ? (*std::max_element(curseEffects->begin(), curseEffects->end(), &Bonus::compareByAdditionalInfo<std::shared_ptr<Bonus>>))->additionalInfo : 0;
-
-	if(curseMultiplicativePenalty) //curse handling (partial, the rest is below)
-	{
-		multBonus *= 1.0 - curseMultiplicativePenalty/100;
-	}
+	formula.curseCount = curseEffects->size();
+	formula.curseTotal = curseEffects->totalValue();
+	if(formula.curseCount)
+		formula.curseMaxPenalty = (*std::max_element(curseEffects->begin(), curseEffects->end(), &Bonus::compareByAdditionalInfo<std::shared_ptr<Bonus>>))->additionalInfo;
+	formula.blessCount = blessEffects->size();
+	formula.blessTotal = blessEffects->totalValue();
 
 	auto isAdvancedAirShield = [](const Bonus* bonus)
 	{
@@ -717,53 +721,29 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 	{
 		if (distPenalty || info.defenderBonuses->hasBonus(isAdvancedAirShield))
 		{
-			multBonus *= 0.5;
+			formula.halvingPenalties++;
 		}
 		if (obstaclePenalty)
 		{
-			multBonus *= 0.5; //cumulative
+			formula.halvingPenalties++; //cumulative
 		}
 	}
 	if(!info.shooting && info.attackerBonuses->hasBonusOfType(Bonus::SHOOTER) && !info.attackerBonuses->hasBonusOfType(Bonus::NO_MELEE_PENALTY))
 	{
-		multBonus *= 0.5;
+		formula.halvingPenalties++;
 	}
 
 	// psychic elementals versus mind immune units 50%
 	if(attackerType->idNumber == CreatureID::PSYCHIC_ELEMENTAL
 	&& info.defenderBonuses->hasBonusOfType(Bonus::MIND_IMMUNITY))
 	{
-		multBonus *= 0.5;
+		formula.halvingPenalties++;
 	}
 
 	// TODO attack on petrified unit 50%
 	// blinded unit retaliates
 
-	minDmg *= additiveBonus * multBonus;
-	maxDmg *= additiveBonus * multBonus;
-
-	TDmgRange returnedVal;
-
-	if(curseEffects->size()) //curse handling (rest)
-	{
-		minDmg += curseBlessAdditiveModifier;
-		returnedVal = std::make_pair(int(minDmg), int(minDmg));
-	}
-	else if(blessEffects->size()) //bless handling
-	{
-		maxDmg += curseBlessAdditiveModifier;
-		returnedVal = std::make_pair(int(maxDmg), int(maxDmg));
-	}
-	else
-	{
-		returnedVal = std::make_pair(int(minDmg), int(maxDmg));
-	}
-
-	//damage cannot be less than 1
-	vstd::amax(returnedVal.first, 1);
-	vstd::amax(returnedVal.second, 1);
-
-	return returnedVal;
+	return formula.calculate();
 }
 
 TDmgRange CBattleInfoCallback::battleEstimateDamage(CRandomGenerator & rand, const CStack * attacker, const CStack * defender, TDmgRange * retaliationDmg) const
@@ -847,6 +827,27 @@ std::vector<std::shared_ptr<const CObstacleInstance>> CBattleInfoCallback::getAl
 }
 
 AccessibilityInfo CBattleInfoCallback::getAccesibility() const
+{
+	const ui64 version = battleStateVersion();
+	if(version)
+	{
+		TLockGuard _(accessibilityCacheMx);
+		if(accessibilityCacheVersion == version)
+			return accessibilityCache;
+	}
+
+	AccessibilityInfo ret = calculateAccesibility();
+
+	if(version)
+	{
+		TLockGuard _(accessibilityCacheMx);
+		accessibilityCache = ret;
+		accessibilityCacheVersion = version;
+	}
+	return ret;
+}
+
+AccessibilityInfo CBattleInfoCallback::calculateAccesibility() const
 {
 	AccessibilityInfo ret;
 	ret.fill(EAccessibility::ACCESSIBLE);
@@ -964,34 +965,39 @@ ReachabilityInfo CBattleInfoCallback::makeBFS(const AccessibilityInfo &accessibi
 	if(!params.startPosition.isValid()) //if got call for arrow turrets
 		return ret;
 
-	const std::set<BattleHex> quicksands = getStoppers(params.perspective);
+	const THexMask quicksands = getStoppersMask(params.perspective);
 	//const bool twoHexCreature = params.doubleWide;
 
-	std::queue<BattleHex> hexq; //bfs queue
+	//bfs queue; first found path to hex is the shortest one, so every hex is queued at most once
+	std::array<BattleHex, GameConstants::BFIELD_SIZE> hexq;
+	size_t queueBegin = 0, queueEnd = 0;
 
 	//first element
-	hexq.push(params.startPosition);
+	hexq[queueEnd++] = params.startPosition;
 	ret.distances[params.startPosition] = 0;
 
-	while(!hexq.empty()) //bfs loop
+	while(queueBegin != queueEnd) //bfs loop
 	{
-		const BattleHex curHex = hexq.front();
-		hexq.pop();
+		const BattleHex curHex = hexq[queueBegin++];
 
 		//walking stack can't step past the quicksands
 		//TODO what if second hex of two-hex creature enters quicksand
-		if(curHex != params.startPosition && vstd::contains(quicksands, curHex))
+		if(curHex != params.startPosition && quicksands.test(curHex))
 			continue;
 
 		const int costToNeighbour = ret.distances[curHex] + 1;
-		for(BattleHex neighbour : curHex.neighbouringTiles())
+		for(BattleHex neighbour : curHex.precomputedNeighbouringTiles())
 		{
+			if(!neighbour.isValid())
+				break;
+
 			const bool accessible = accessibility.accessible(neighbour, params.doubleWide, params.side);
 			const int costFoundSoFar = ret.distances[neighbour];
 
 			if(accessible && costToNeighbour < costFoundSoFar)
 			{
-				hexq.push(neighbour);
+				assert(queueEnd < hexq.size());
+				hexq[queueEnd++] = neighbour;
 				ret.distances[neighbour] = costToNeighbour;
 				ret.predecessors[neighbour] = curHex;
 			}
@@ -1022,6 +1028,24 @@ std::set<BattleHex> CBattleInfoCallback::getStoppers(BattlePerspective::BattlePe
 	return ret;
 }
 
+CBattleInfoCallback::THexMask CBattleInfoCallback::getStoppersMask(BattlePerspective::BattlePerspective whichSidePerspective) const
+{
+	THexMask ret;
+	RETURN_IF_NOT_BATTLE(ret);
+
+	for(auto &oi : battleGetAllObstacles(whichSidePerspective))
+	{
+		if(battleIsObstacleVisibleForSide(*oi, whichSidePerspective))
+		{
+			for(BattleHex hex : oi->getStoppingTile())
+				if(hex.isValid())
+					ret.set(hex);
+		}
+	}
+
+	return ret;
+}
+
 std::pair<const CStack *, BattleHex> CBattleInfoCallback::getNearestStack(const CStack * closest, BattleSideOpt side) const
 {
 	auto reachability = getReachability(closest);
@@ -1464,10 +1488,9 @@ SpellID CBattleInfoCallback::getRandomBeneficialSpell(CRandomGenerator & rand, c
 
 	for(const SpellID spellID : allPossibleSpells)
 	{
-		std::stringstream cachingStr;
-		cachingStr << "source_" << Bonus::SPELL_EFFECT << "id_" << spellID.num;
+		const BonusCacheKey cachingKey = BonusCacheKey::source(Bonus::SPELL_EFFECT, spellID);
 
-		if(subject->hasBonus(Selector::source(Bonus::SPELL_EFFECT, spellID), Selector::all, cachingStr.str())
+		if(subject->hasBonus(Selector::source(Bonus::SPELL_EFFECT, spellID), Selector::all, cachingKey)
 		 //TODO: this ability has special limitations
 		|| spellID.toSpell()->canBeCast(this, ECastingMode::CREATURE_ACTIVE_CASTING, subject) != ESpellCastProblem::OK)
 			continue;
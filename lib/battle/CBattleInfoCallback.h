@@ -11,6 +11,7 @@
 #include "CCallbackBase.h"
 #include "ReachabilityInfo.h"
 #include "BattleAttackInfo.h"
+#include "DamageCache.h"
 
 class CGHeroInstance;
 class CStack;
@@ -38,6 +39,8 @@ public:
 	{
 		RANDOM_GENIE, RANDOM_AIMED
 	};
+
+	CBattleInfoCallback();
 	//battle
 	boost::optional<int> battleIsFinished() const; //return none if battle is ongoing; otherwise the victorious side (0/1) or 2 if it is a draw
 
@@ -60,6 +63,7 @@ public:
 	std::set<const CStack*> batteAdjacentCreatures (const CStack * stack) const;
 
 	TDmgRange calculateDmgRange(const BattleAttackInfo & info) const; //charge - number of hexes travelled before attack (for champion's jousting); returns pair <min dmg, max dmg>
+	DamageCache::Stats battleDamageCacheStats() const; //hits and misses of calculateDmgRange results cached in current battle
 
 	//hextowallpart //int battleGetWallUnderHex(BattleHex hex) const; //returns part of destructible wall / gate / keep under given hex or -1 if not found
 	std::pair<ui32, ui32> battleEstimateDamage(CRandomGenerator & rand, const BattleAttackInfo & bai, std::pair<ui32, ui32> * retaliationDmg = nullptr) const; //estimates damage dealt by attacker to defender; it may be not precise especially when stack has randomly working bonuses; returns pair <min dmg, max dmg>
@@ -68,6 +72,8 @@ public:
 	si8 battleHasDistancePenalty(const IBonusBearer * bonusBearer, BattleHex shooterPosition, BattleHex destHex) const;
 	si8 battleHasWallPenalty(const CStack * stack, BattleHex destHex) const; //checks if given stack has wall penalty
 	si8 battleHasWallPenalty(const IBonusBearer * bonusBearer, BattleHex shooterPosition, BattleHex destHex) const; //checks if given stack has wall penalty
+	static BattleHex lineToWallHex(int line); //returns hex with wall in given line (y coordinate)
+	static int wallLineOfShot(BattleHex shooterPosition, BattleHex destHex); //returns line in which shot from outside of walls passes them, -1 if it doesn't
 
 	BattleHex wallPartToBattleHex(EWallPart::EWallPart part) const;
 	EWallPart::EWallPart battleHexToWallPart(BattleHex hex) const; //returns part of destructible wall / gate / keep under given hex or -1 if not found
@@ -108,4 +114,16 @@ protected:
 	ReachabilityInfo makeBFS(const AccessibilityInfo & accessibility, const ReachabilityInfo::Parameters & params) const;
 	ReachabilityInfo makeBFS(const CStack * stack) const; //uses default parameters -> stack position and owner's perspective
 	std::set<BattleHex> getStoppers(BattlePerspective::BattlePerspective whichSidePerspective) const; //get hexes with stopping obstacles (quicksands)
+
+private:
+	typedef std::bitset<GameConstants::BFIELD_SIZE> THexMask;
+
+	THexMask getStoppersMask(BattlePerspective::BattlePerspective whichSidePerspective) const;
+	AccessibilityInfo calculateAccesibility() const;
+	TDmgRange calculateDmgRangeUncached(const BattleAttackInfo & info) const;
+
+	/// accessibility of last seen battle state, shared by all queries until state changes
+	mutable boost::mutex accessibilityCacheMx;
+	mutable ui64 accessibilityCacheVersion;
+	mutable AccessibilityInfo accessibilityCache;
 };
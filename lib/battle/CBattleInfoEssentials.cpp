@@ -335,6 +335,22 @@ EGateState CBattleInfoEssentials::battleGetGateState() const
 	return getBattle()->si.gateState;
 }
 
+ui64 CBattleInfoEssentials::battleStateVersion() const
+{
+	if(!duringBattle())
+		return 0;
+
+	return getBattle()->stateVersion;
+}
+
+DamageCache * CBattleInfoEssentials::battleDamageCache() const
+{
+	if(!duringBattle())
+		return nullptr;
+
+	return &getBattle()->damageCache;
+}
+
 PlayerColor CBattleInfoEssentials::battleGetOwner(const CStack * stack) const
 {
 	RETURN_IF_NOT_BATTLE(PlayerColor::CANNOT_DETERMINE);
@@ -18,6 +18,7 @@ struct CObstacleInstance;
 class IBonusBearer;
 struct InfoAboutHero;
 class CArmedInstance;
+class DamageCache;
 
 typedef std::vector<const CStack*> TStacks;
 typedef std::function<bool(const CStack *)> TStackFilter;
@@ -38,6 +39,7 @@ class DLL_LINKAGE CBattleInfoEssentials : public virtual CCallbackBase
 protected:
 	bool battleDoWeKnowAbout(ui8 side) const;
 	const IBonusBearer * getBattleNode() const;
+	DamageCache * battleDamageCache() const; //nullptr if there is no battle
 public:
 	enum EStackOwnership
 	{
@@ -81,6 +83,9 @@ public:
 	si8 battleGetWallState(int partOfWall) const;
 	EGateState battleGetGateState() const;
 
+	/// changes whenever battle state changes, 0 if current state must not be cached (see BattleInfo::stateVersion)
+	ui64 battleStateVersion() const;
+
 	//helpers
 	///returns all stacks, alive or dead or undead or mechanical :)
 	TStacks battleGetAllStacks(bool includeTurrets = false) const;
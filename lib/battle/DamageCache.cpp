@@ -0,0 +1,105 @@
+/*
+ * DamageCache.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "DamageCache.h"
+#include "BattleAttackInfo.h"
+
+DamageCache::Key::Key(const BattleAttackInfo & info)
+	: attacker(info.attacker->ID), defender(info.defender->ID),
+	attackerPosition(info.attackerPosition), defenderPosition(info.defenderPosition),
+	attackerCount(info.attackerHealth.getCount()), chargedFields(info.chargedFields),
+	flags(info.shooting | info.luckyHit << 1 | info.unluckyHit << 2 | info.deathBlow << 3 | info.ballistaDoubleDamage << 4),
+	attackerVersion(info.attackerBonuses->getTreeVersion()), defenderVersion(info.defenderBonuses->getTreeVersion())
+{
+}
+
+bool DamageCache::Key::operator==(const Key & other) const
+{
+	return attacker == other.attacker
+		&& defender == other.defender
+		&& attackerPosition == other.attackerPosition
+		&& defenderPosition == other.defenderPosition
+		&& attackerCount == other.attackerCount
+		&& chargedFields == other.chargedFields
+		&& flags == other.flags
+		&& attackerVersion == other.attackerVersion
+		&& defenderVersion == other.defenderVersion;
+}
+
+size_t DamageCache::KeyHash::operator()(const Key & key) const
+{
+	size_t ret = 0;
+	boost::hash_combine(ret, key.attacker);
+	boost::hash_combine(ret, key.defender);
+	boost::hash_combine(ret, key.attackerPosition.hex);
+	boost::hash_combine(ret, key.defenderPosition.hex);
+	boost::hash_combine(ret, key.attackerCount);
+	boost::hash_combine(ret, key.chargedFields);
+	boost::hash_combine(ret, key.flags);
+	boost::hash_combine(ret, key.attackerVersion);
+	boost::hash_combine(ret, key.defenderVersion);
+	return ret;
+}
+
+DamageCache::DamageCache()
+	: stateVersion(0), hits(0), misses(0), invalidations(0)
+{
+}
+
+bool DamageCache::find(ui64 stateVersion, const Key & key, TDmgRange & out)
+{
+	assert(stateVersion);
+	TLockGuard lock(mx);
+	setStateVersion(stateVersion);
+	auto it = entries.find(key);
+	if(it == entries.end())
+	{
+		misses++;
+		return false;
+	}
+
+	hits++;
+	out = it->second;
+	return true;
+}
+
+void DamageCache::insert(ui64 stateVersion, const Key & key, const TDmgRange & value)
+{
+	assert(stateVersion);
+	TLockGuard lock(mx);
+	setStateVersion(stateVersion);
+	if(entries.size() >= MAX_ENTRIES)
+		entries.clear();
+	entries[key] = value;
+}
+
+void DamageCache::setStateVersion(ui64 version)
+{
+	if(stateVersion == version)
+		return;
+
+	stateVersion = version;
+	if(!entries.empty())
+	{
+		entries.clear();
+		invalidations++;
+	}
+}
+
+DamageCache::Stats DamageCache::getStats() const
+{
+	TLockGuard lock(mx);
+	Stats ret;
+	ret.hits = hits;
+	ret.misses = misses;
+	ret.invalidations = invalidations;
+	ret.entries = entries.size();
+	return ret;
+}
@@ -0,0 +1,68 @@
+/*
+ * DamageCache.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+#include "BattleHex.h"
+#include "../GameConstants.h"
+
+struct BattleAttackInfo;
+
+/// Results of damage range calculation for one battle state. Entries are dropped as soon as they are accessed
+/// with different state version (see BattleInfo::stateVersion), so any applied pack invalidates them. Key holds
+/// attack parameters which may differ within one state, e.g. in hypothetical attacks. Safe to use from multiple threads.
+class DLL_LINKAGE DamageCache
+{
+public:
+	struct DLL_LINKAGE Key
+	{
+		si32 attacker, defender;
+		BattleHex attackerPosition, defenderPosition;
+		si32 attackerCount;
+		si32 chargedFields;
+		ui8 flags; //shooting, lucky hit, unlucky hit, death blow, ballista double damage
+		int64_t attackerVersion, defenderVersion;
+
+		explicit Key(const BattleAttackInfo & info);
+
+		bool operator==(const Key & other) const;
+	};
+
+	struct Stats
+	{
+		ui64 hits;
+		ui64 misses;
+		ui64 invalidations;
+		size_t entries;
+	};
+
+	/// Cache is cleared when it grows above this number of entries
+	static const size_t MAX_ENTRIES = 65536;
+
+	DamageCache();
+
+	/// stateVersion must not be 0, such states are not cached
+	bool find(ui64 stateVersion, const Key & key, TDmgRange & out);
+	void insert(ui64 stateVersion, const Key & key, const TDmgRange & value);
+
+	Stats getStats() const;
+
+private:
+	struct KeyHash
+	{
+		size_t operator()(const Key & key) const;
+	};
+
+	mutable boost::mutex mx;
+	std::unordered_map<Key, TDmgRange, KeyHash> entries;
+	ui64 stateVersion; //state of battle entries were calculated for
+	ui64 hits, misses;
+	ui64 invalidations;
+
+	void setStateVersion(ui64 version); //mx must be locked
+};
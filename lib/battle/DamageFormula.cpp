@@ -0,0 +1,121 @@
+/*
+ * DamageFormula.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "DamageFormula.h"
+
+DamageFormula::DamageFormula()
+	: minDamage(0), maxDamage(0), attack(0), defense(0), attackReduction(0), enemyDefenceReduction(0), slayerPower(0),
+	chargedFields(0), skillPremy(0), hate(0), luckyHit(false), unluckyHit(false), ballistaDoubleDamage(false), deathBlow(false),
+	armorer(0), damageReduction(0), halvingPenalties(0),
+	curseCount(0), curseTotal(0), curseMaxPenalty(0), blessCount(0), blessTotal(0)
+{
+}
+
+TDmgRange DamageFormula::calculate() const
+{
+	double additiveBonus = 1.0, multBonus = 1.0,
+			minDmg = minDamage,
+			maxDmg = maxDamage;
+
+	int attackDefenceDifference = 0;
+
+	double multAttackReduction = (100 - attackReduction) / 100.0;
+	attackDefenceDifference += attack * multAttackReduction;
+
+	double multDefenceReduction = (100 - enemyDefenceReduction) / 100.0;
+	attackDefenceDifference -= defense * multDefenceReduction;
+
+	attackDefenceDifference += slayerPower;
+
+	//bonus from attack/defense skills
+	if(attackDefenceDifference < 0) //decreasing dmg
+	{
+		const double dec = std::min(0.025 * (-attackDefenceDifference), 0.7);
+		multBonus *= 1.0 - dec;
+	}
+	else //increasing dmg
+	{
+		const double inc = std::min(0.05 * attackDefenceDifference, 4.0);
+		additiveBonus += inc;
+	}
+
+	//applying jousting bonus
+	additiveBonus += chargedFields * 0.05;
+
+	//handling secondary abilities and artifacts giving premies to them
+	additiveBonus += skillPremy / 100.0;
+	multBonus *= (std::max(0, 100 - armorer)) / 100.0;
+
+	//handling hate effect
+	additiveBonus += hate / 100.;
+
+	//luck bonus
+	if(luckyHit)
+	{
+		additiveBonus += 1.0;
+	}
+	//unlucky hit, used only if negative luck is enabled
+	if(unluckyHit)
+	{
+		additiveBonus -= 0.5; // FIXME: how bad (and luck in general) should work with following bonuses?
+	}
+
+	//ballista double dmg
+	if(ballistaDoubleDamage)
+	{
+		additiveBonus += 1.0;
+	}
+
+	if(deathBlow) //Dread Knight and many WoGified creatures
+	{
+		additiveBonus += 1.0;
+	}
+
+	//handling spell effects, eg. shield or air shield
+	multBonus *= (100 - damageReduction) / 100.0;
+
+	const int curseBlessAdditiveModifier = blessTotal - curseTotal;
+	const double curseMultiplicativePenalty = curseCount ? curseMaxPenalty : 0;
+
+	if(curseMultiplicativePenalty) //curse handling (partial, the rest is below)
+	{
+		multBonus *= 1.0 - curseMultiplicativePenalty/100;
+	}
+
+	//halving is exact, so order of these penalties among other multipliers doesn't matter
+	for(int i = 0; i < halvingPenalties; i++)
+		multBonus *= 0.5;
+
+	minDmg *= additiveBonus * multBonus;
+	maxDmg *= additiveBonus * multBonus;
+
+	TDmgRange returnedVal;
+
+	if(curseCount) //curse handling (rest)
+	{
+		minDmg += curseBlessAdditiveModifier;
+		returnedVal = std::make_pair(int(minDmg), int(minDmg));
+	}
+	else if(blessCount) //bless handling
+	{
+		maxDmg += curseBlessAdditiveModifier;
+		returnedVal = std::make_pair(int(maxDmg), int(maxDmg));
+	}
+	else
+	{
+		returnedVal = std::make_pair(int(minDmg), int(maxDmg));
+	}
+
+	//damage cannot be less than 1
+	vstd::amax(returnedVal.first, 1);
+	vstd::amax(returnedVal.second, 1);
+
+	return returnedVal;
+}
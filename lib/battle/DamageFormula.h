@@ -0,0 +1,39 @@
+/*
+ * DamageFormula.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+#include "../GameConstants.h"
+
+/// Damage range of one attack computed from values already aggregated from bonuses of both units.
+/// CBattleInfoCallback::calculateDmgRange fills it from bonus system, battle AI from its own snapshot of battle.
+struct DLL_LINKAGE DamageFormula
+{
+	double minDamage, maxDamage; //of whole attacking stack, before any modifiers
+
+	int attack, defense;
+	int attackReduction; //percent, GENERAL_ATTACK_REDUCTION of attacker
+	int enemyDefenceReduction; //percent, ENEMY_DEFENCE_REDUCTION of attacker
+	int slayerPower; //0 if defender is not affected by slayer
+
+	int chargedFields; //0 if attacker has no jousting or defender is immune to it
+	int skillPremy; //percent, offence or archery
+	int hate; //percent, hate of attacker towards defender
+	bool luckyHit, unluckyHit, ballistaDoubleDamage, deathBlow;
+
+	int armorer; //percent
+	int damageReduction; //percent, GENERAL_DAMAGE_REDUCTION of defender for given kind of attack
+	int halvingPenalties; //forgetfulness, distance or advanced air shield, wall, shooter in melee, psychic elemental against mind immunity
+
+	int curseCount, curseTotal, curseMaxPenalty;
+	int blessCount, blessTotal;
+
+	DamageFormula();
+
+	TDmgRange calculate() const;
+};
@@ -11,6 +11,7 @@
 #include "CArchiveLoader.h"
 
 #include "CFileInputStream.h"
+#include "CMappedFileStream.h"
 #include "CCompressedStream.h"
 
 #include "CBinaryReader.h"
@@ -45,6 +46,15 @@ CArchiveLoader::CArchiveLoader(std::string _mountPoint, boost::filesystem::path
 	else
 		throw std::runtime_error("LOD archive format unknown. Cannot deal with " + archive.string());
 
+	try
+	{
+		mappedArchive = std::make_shared<CMappedFile>(archive);
+	}
+	catch(std::runtime_error & e)
+	{
+		logGlobal->warn("%s. Falling back to regular file reads.", e.what());
+	}
+
 	logGlobal->trace("%sArchive \"%s\" loaded (%d files found).", ext, archive.filename(), entries.size());
 }
 
@@ -148,10 +158,18 @@ std::unique_ptr<CInputStream> CArchiveLoader::load(const ResourceID & resourceNa
 
 	if (entry.compressedSize != 0) //compressed data
 	{
-		auto fileStream = make_unique<CFileInputStream>(archive, entry.offset, entry.compressedSize);
+		std::unique_ptr<CInputStream> fileStream;
+		if(mappedArchive)
+			fileStream = make_unique<CMappedFileStream>(mappedArchive, entry.offset, entry.compressedSize);
+		else
+			fileStream = make_unique<CFileInputStream>(archive, entry.offset, entry.compressedSize);
 
 		return make_unique<CCompressedStream>(std::move(fileStream), false, entry.fullSize);
 	}
+	else if(mappedArchive)
+	{
+		return make_unique<CMappedFileStream>(mappedArchive, entry.offset, entry.fullSize);
+	}
 	else
 	{
 		return make_unique<CFileInputStream>(archive, entry.offset, entry.fullSize);
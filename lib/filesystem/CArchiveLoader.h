@@ -13,6 +13,7 @@
 #include "ResourceID.h"
 
 class CFileInputStream;
+class CMappedFile;
 
 /**
  * A struct which holds information about the archive entry e.g. where it is located in space of the archive container.
@@ -56,6 +57,7 @@ public:
 	CArchiveLoader(std::string mountPoint, boost::filesystem::path archive);
 
 	/// Interface implementation
+	/// Uncompressed entries are returned as zero-copy views on memory mapped archive
 	/// @see ISimpleResourceLoader
 	std::unique_ptr<CInputStream> load(const ResourceID & resourceName) const override;
 	bool existsResource(const ResourceID & resourceName) const override;
@@ -90,6 +92,9 @@ private:
 
 	std::string mountPoint;
 
+	/** Read-only mapping of the whole archive, entries are served as views into it. Null if mapping failed. */
+	std::shared_ptr<const CMappedFile> mappedArchive;
+
 	/** Holds all entries of the archive file. An entry can be accessed via the entry name. **/
 	std::unordered_map<ResourceID, ArchiveEntry> entries;
 };
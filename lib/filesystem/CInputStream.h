@@ -31,6 +31,16 @@ public:
 	 */
 	virtual si64 read(ui8 * data, si64 size) = 0;
 
+	/**
+	 * Gives direct access to the whole content of the stream if it is already in memory.
+	 *
+	 * @return pointer to getSize() bytes that stay valid while the stream exists, nullptr if not supported
+	 */
+	virtual const ui8 * data() const
+	{
+		return nullptr;
+	}
+
 	/**
 	 * @brief for convenience, reads whole stream at once
 	 *
@@ -40,6 +50,13 @@ public:
 	{
 		std::unique_ptr<ui8[]> data(new ui8[getSize()]);
 
+		if(const ui8 * inMemory = this->data())
+		{
+			std::copy(inMemory, inMemory + getSize(), data.get());
+			seek(getSize());
+			return std::make_pair(std::move(data), getSize());
+		}
+
 		seek(0);
 		auto readSize = read(data.get(), getSize());
 		assert(readSize == getSize());
@@ -0,0 +1,97 @@
+/*
+ * CMappedFileStream.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CMappedFileStream.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+struct CMappedFile::Impl
+{
+	boost::interprocess::file_mapping mapping;
+	boost::interprocess::mapped_region region;
+};
+
+CMappedFile::CMappedFile(const boost::filesystem::path & file)
+{
+	using namespace boost::interprocess;
+	try
+	{
+		impl = make_unique<Impl>();
+		impl->mapping = file_mapping(file.string().c_str(), read_only);
+		impl->region = mapped_region(impl->mapping, read_only);
+	}
+	catch(interprocess_exception & e)
+	{
+		throw std::runtime_error("File " + file.string() + " can't be mapped: " + e.what());
+	}
+}
+
+CMappedFile::~CMappedFile() = default;
+
+const ui8 * CMappedFile::getData() const
+{
+	return static_cast<const ui8 *>(impl->region.get_address());
+}
+
+si64 CMappedFile::getSize() const
+{
+	return impl->region.get_size();
+}
+
+CMappedFileStream::CMappedFileStream(std::shared_ptr<const CMappedFile> file_, si64 start, si64 size)
+	: file(std::move(file_)),
+	dataStart(nullptr),
+	dataSize(size),
+	position(0)
+{
+	//view is clipped to the file, same as reads of truncated files via CFileInputStream
+	vstd::abetween(start, 0, file->getSize());
+	if(dataSize == 0 || start + dataSize > file->getSize())
+		dataSize = file->getSize() - start;
+
+	dataStart = file->getData() + start;
+}
+
+si64 CMappedFileStream::read(ui8 * data, si64 size)
+{
+	si64 toRead = std::min(dataSize - position, size);
+	std::copy(dataStart + position, dataStart + position + toRead, data);
+	position += toRead;
+	return toRead;
+}
+
+si64 CMappedFileStream::seek(si64 position_)
+{
+	position = position_;
+	vstd::abetween(position, 0, dataSize);
+	return position;
+}
+
+si64 CMappedFileStream::tell()
+{
+	return position;
+}
+
+si64 CMappedFileStream::skip(si64 delta)
+{
+	si64 origin = position;
+	return seek(position + delta) - origin;
+}
+
+si64 CMappedFileStream::getSize()
+{
+	return dataSize;
+}
+
+const ui8 * CMappedFileStream::data() const
+{
+	return dataStart;
+}
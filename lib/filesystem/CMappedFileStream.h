@@ -0,0 +1,69 @@
+/*
+ * CMappedFileStream.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "CInputStream.h"
+
+/**
+ * Read-only memory mapping of a whole file. Shared by all streams created from it,
+ * mapping stays valid until the last of them is destroyed.
+ */
+class DLL_LINKAGE CMappedFile
+{
+public:
+	/**
+	 * C-tor. Maps the whole file into memory.
+	 *
+	 * @param file Path to the file.
+	 *
+	 * @throws std::runtime_error if the file can't be mapped
+	 */
+	explicit CMappedFile(const boost::filesystem::path & file);
+	~CMappedFile();
+
+	const ui8 * getData() const;
+	si64 getSize() const;
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> impl;
+};
+
+/**
+ * A class which provides a read-only view on a part of memory mapped file.
+ * Data is never copied, consumers may access it directly via data().
+ */
+class DLL_LINKAGE CMappedFileStream : public CInputStream
+{
+public:
+	/**
+	 * C-tor.
+	 *
+	 * @param file Mapped file which holds the data.
+	 * @param start Offset of the view from the beginning of the file.
+	 * @param size Size of the view in bytes, 0 means up to end of the file.
+	 */
+	CMappedFileStream(std::shared_ptr<const CMappedFile> file, si64 start = 0, si64 size = 0);
+
+	si64 read(ui8 * data, si64 size) override;
+	si64 seek(si64 position) override;
+	si64 tell() override;
+	si64 skip(si64 delta) override;
+	si64 getSize() override;
+	const ui8 * data() const override;
+
+private:
+	/** Keeps mapping alive as long as this view exists. */
+	std::shared_ptr<const CMappedFile> file;
+
+	const ui8 * dataStart;
+	si64 dataSize;
+	si64 position;
+};
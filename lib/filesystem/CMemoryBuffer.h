@@ -73,7 +73,9 @@ public:
 	 * @return the length in bytes of the stream.
 	 */
 	si64 getSize() override;
-	
+
+	const ui8 * data() const override {return buffer.data();}
+
 	const TBuffer & getBuffer(){return buffer;}
 
 private:
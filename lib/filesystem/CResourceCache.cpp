@@ -0,0 +1,111 @@
+/*
+ * CResourceCache.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CResourceCache.h"
+
+#include "CInputStream.h"
+#include "ISimpleResourceLoader.h"
+
+CCachedResource::CCachedResource(std::unique_ptr<CInputStream> stream_)
+	: stream(std::move(stream_)),
+	dataStart(nullptr),
+	dataSize(stream->getSize())
+{
+	dataStart = stream->data();
+	if(!dataStart)
+	{
+		auto content = stream->readAll();
+		ownedData = std::move(content.first);
+		dataStart = ownedData.get();
+		stream.reset();
+	}
+}
+
+CCachedResource::~CCachedResource() = default;
+
+CResourceCache::CResourceCache(const ISimpleResourceLoader * source, size_t byteBudget)
+	: source(source),
+	byteBudget(byteBudget)
+{
+}
+
+CResourceCache::TResource CResourceCache::load(const ResourceID & resource)
+{
+	{
+		TLockGuard _(mx);
+		auto found = index.find(resource);
+		if(found != index.end())
+		{
+			stats.hits++;
+			entries.splice(entries.begin(), entries, found->second);
+			return found->second->second;
+		}
+		stats.misses++;
+	}
+
+	// load without holding the lock, concurrent misses of the same resource may load it twice
+	auto loaded = std::make_shared<const CCachedResource>(source->load(resource));
+
+	TLockGuard _(mx);
+	if(loaded->size() > byteBudget)
+		return loaded;
+
+	auto found = index.find(resource);
+	if(found != index.end())
+		return found->second->second;
+
+	entries.emplace_front(resource, loaded);
+	index[resource] = entries.begin();
+	stats.entries++;
+	stats.bytes += loaded->size();
+	evict();
+	return loaded;
+}
+
+void CResourceCache::setByteBudget(size_t byteBudget_)
+{
+	TLockGuard _(mx);
+	byteBudget = byteBudget_;
+	evict();
+}
+
+size_t CResourceCache::getByteBudget() const
+{
+	TLockGuard _(mx);
+	return byteBudget;
+}
+
+void CResourceCache::clear()
+{
+	TLockGuard _(mx);
+	entries.clear();
+	index.clear();
+	stats.entries = 0;
+	stats.bytes = 0;
+}
+
+CResourceCache::Stats CResourceCache::getStats() const
+{
+	TLockGuard _(mx);
+	return stats;
+}
+
+void CResourceCache::evict()
+{
+	while(stats.bytes > byteBudget)
+	{
+		const auto & last = entries.back();
+		stats.bytes -= last.second->size();
+		stats.entries--;
+		stats.evictions++;
+		index.erase(last.first);
+		entries.pop_back();
+	}
+}
@@ -0,0 +1,95 @@
+/*
+ * CResourceCache.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "ResourceID.h"
+
+class CInputStream;
+class ISimpleResourceLoader;
+
+/**
+ * Immutable content of a loaded resource, shared between the cache and all its users.
+ * Streams with in-memory data (e.g. memory mapped archive entries) are kept as is, others are read into own buffer.
+ */
+class DLL_LINKAGE CCachedResource
+{
+public:
+	explicit CCachedResource(std::unique_ptr<CInputStream> stream);
+	~CCachedResource();
+
+	const ui8 * data() const { return dataStart; }
+	size_t size() const { return dataSize; }
+
+private:
+	std::unique_ptr<CInputStream> stream;
+	std::unique_ptr<ui8[]> ownedData;
+
+	const ui8 * dataStart;
+	size_t dataSize;
+};
+
+/**
+ * Thread-safe cache of resource contents with least recently used eviction under a byte budget.
+ */
+class DLL_LINKAGE CResourceCache
+{
+public:
+	typedef std::shared_ptr<const CCachedResource> TResource;
+
+	struct Stats
+	{
+		ui64 hits;
+		ui64 misses;
+		ui64 evictions;
+		size_t entries;
+		size_t bytes;
+
+		Stats() : hits(0), misses(0), evictions(0), entries(0), bytes(0) {}
+	};
+
+	/// 64 Mb is enough to keep all resources of a battle or adventure map screen
+	static const size_t DEFAULT_BYTE_BUDGET = 64 * 1024 * 1024;
+
+	/// source - loader used to fetch resources on cache miss
+	CResourceCache(const ISimpleResourceLoader * source, size_t byteBudget = DEFAULT_BYTE_BUDGET);
+
+	/**
+	 * Returns content of the resource, loading it from source on miss.
+	 * Resources larger than the whole budget are returned but not cached.
+	 *
+	 * @throws std::runtime_error if resource does not exist
+	 */
+	TResource load(const ResourceID & resource);
+
+	/// Changes budget, evicts least recently used resources if needed
+	void setByteBudget(size_t byteBudget);
+	size_t getByteBudget() const;
+
+	/// Drops all cached resources, e.g. after filesystem change. Counters are preserved
+	void clear();
+
+	Stats getStats() const;
+
+private:
+	typedef std::list<std::pair<ResourceID, TResource>> TEntries;
+
+	/// Removes least recently used entries until cache fits into budget, requires locked mutex
+	void evict();
+
+	const ISimpleResourceLoader * source;
+
+	mutable boost::mutex mx;
+	size_t byteBudget;
+	Stats stats;
+
+	/// Most recently used entry is at front
+	TEntries entries;
+	std::unordered_map<ResourceID, TEntries::iterator> index;
+};
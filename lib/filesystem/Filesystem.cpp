@@ -14,6 +14,7 @@
 #include "CFilesystemLoader.h"
 #include "AdapterLoaders.h"
 #include "CZipLoader.h"
+#include "CResourceCache.h"
 
 //For filesystem initialization
 #include "../JsonNode.h"
@@ -22,6 +23,7 @@
 #include "../CStopWatch.h"
 
 std::map<std::string, ISimpleResourceLoader*> CResourceHandler::knownLoaders = std::map<std::string, ISimpleResourceLoader*>();
+std::unique_ptr<CResourceCache> CResourceHandler::cache;
 
 CFilesystemGenerator::CFilesystemGenerator(std::string prefix):
 	filesystem(new CFilesystemList()),
@@ -119,6 +121,7 @@ void CFilesystemGenerator::loadJsonMap(const std::string &mountPoint, const Json
 
 void CResourceHandler::clear()
 {
+	cache.reset();
 	delete knownLoaders["root"];
 }
 
@@ -175,6 +178,7 @@ void CResourceHandler::initialize()
 	//    |-config
 
 	knownLoaders["root"] = new CFilesystemList();
+	cache = make_unique<CResourceCache>(knownLoaders["root"]);
 	knownLoaders["saves"] = new CFilesystemLoader("SAVES/", VCMIDirs::get().userSavePath());
 	knownLoaders["config"] = new CFilesystemLoader("CONFIG/", VCMIDirs::get().userConfigPath());
 
@@ -197,6 +201,13 @@ ISimpleResourceLoader * CResourceHandler::get(std::string identifier)
 	return knownLoaders.at(identifier);
 }
 
+CResourceCache & CResourceHandler::getCache()
+{
+	if(!cache)
+		throw std::runtime_error("Resource cache used before filesystem initialization!");
+	return *cache;
+}
+
 void CResourceHandler::load(const std::string &fsConfigURI)
 {
 	auto fsConfigData = get("initial")->load(ResourceID(fsConfigURI, EResType::TEXT))->readAll();
@@ -214,6 +225,7 @@ void CResourceHandler::addFilesystem(const std::string & parent, const std::stri
 	assert(list);
 	list->addLoader(loader, false);
 	knownLoaders[identifier] = loader;
+	cache->clear();
 }
 
 ISimpleResourceLoader * CResourceHandler::createFileSystem(const std::string & prefix, const JsonNode &fsConfig)
@@ -14,6 +14,7 @@
 #include "ResourceID.h"
 
 class CFilesystemList;
+class CResourceCache;
 class JsonNode;
 
 /// Helper class that allows generation of a ISimpleResourceLoader entry out of Json config(s)
@@ -47,7 +48,7 @@ public:
 /**
  * This class has static methods for a global resource loader access.
  *
- * Class is not thread-safe.
+ * Class is not thread-safe, with exception of shared resource cache.
  */
 class DLL_LINKAGE CResourceHandler
 {
@@ -68,6 +69,13 @@ public:
 	static ISimpleResourceLoader * get();
 	static ISimpleResourceLoader * get(std::string identifier);
 
+	/**
+	 * Gets cache of resources loaded from root loader. Cache is dropped whenever filesystem is changed.
+	 *
+	 * @return Returns cache shared by all users, safe to use from any thread.
+	 */
+	static CResourceCache & getCache();
+
 	/**
 	 * Creates instance of initial resource loader.
 	 * Will not fill filesystem with data
@@ -106,4 +114,6 @@ public:
 private:
 	/** Instance of resource loader */
 	static std::map<std::string, ISimpleResourceLoader*> knownLoaders;
+
+	static std::unique_ptr<CResourceCache> cache;
 };
@@ -750,6 +750,7 @@ void CGHeroInstance::Updatespecialty() //TODO: calculate special value of bonuse
 					}
 				}
 			}
+			hs->nodeHasChanged();
 		}
 	}
 }
@@ -781,7 +782,7 @@ void CGHeroInstance::updateSkill(SecondarySkill which, int val)
 		else
 			addNewBonus(std::make_shared<Bonus>(*b));
 	}
-	CBonusSystemNode::treeHasChanged();
+	nodeHasChanged();
 }
 void CGHeroInstance::setPropertyDer( ui8 what, ui32 val )
 {
@@ -1399,7 +1400,7 @@ void CGHeroInstance::setPrimarySkill(PrimarySkill::PrimarySkill primarySkill, si
 		{
 			skill->val += value;
 		}
-		CBonusSystemNode::treeHasChanged();
+		nodeHasChanged();
 	}
 	else if(primarySkill == PrimarySkill::EXPERIENCE)
 	{
@@ -1470,9 +1471,7 @@ bool CGHeroInstance::hasVisions(const CGObjectInstance * target, const int subty
 {
 	//VISIONS spell support
 
-	const std::string cached = boost::to_string((boost::format("type_%d__subtype_%d") % Bonus::VISIONS % subtype));
-
-	const int visionsMultiplier = valOfBonuses(Selector::typeSubtype(Bonus::VISIONS,subtype), cached);
+	const int visionsMultiplier = valOfBonuses(Selector::typeSubtype(Bonus::VISIONS,subtype), BonusCacheKey::typeSubtype(Bonus::VISIONS, subtype));
 
 	int visionsRange =  visionsMultiplier * getPrimSkillLevel(PrimarySkill::SPELL_POWER);
 
@@ -92,7 +92,8 @@ void CCreGenLeveledCastleInfo::serializeJson(JsonSerializeFormat & handler)
 }
 
 CGDwelling::CGDwelling():
-	CArmedInstance()
+	CArmedInstance(),
+	creaturesVersion(0)
 {
 	info = nullptr;
 }
@@ -268,7 +269,7 @@ void CGDwelling::newTurn(CRandomGenerator & rand) const
 		}
 	}
 
-	if(change)
+	if(change && sac.encodeDelta(this))
 		cb->sendAndApply(&sac);
 
 	updateGuards();
@@ -342,7 +343,7 @@ void CGDwelling::heroAcceptsCreatures( const CGHeroInstance *h) const
 				sac.tid = id;
 				sac.creatures = creatures;
 				sac.creatures[0].first = 0;
-
+				sac.encodeDelta(this);
 
 				InfoWindow iw;
 				iw.player = h->tempOwner;
@@ -375,6 +376,7 @@ void CGDwelling::heroAcceptsCreatures( const CGHeroInstance *h) const
 			sac.creatures[0].first = !h->getArt(ArtifactPosition::MACH1); //ballista
 			sac.creatures[1].first = !h->getArt(ArtifactPosition::MACH3); //first aid tent
 			sac.creatures[2].first = !h->getArt(ArtifactPosition::MACH2); //ammo cart
+			sac.encodeDelta(this);
 			cb->sendAndApply(&sac);
 		}
 
@@ -1058,7 +1060,7 @@ void CGTownInstance::updateMoraleBonusFromArmy()
 	if (garrisonHero)
 	{
 		b->val = 0;
-		CBonusSystemNode::treeHasChanged();
+		nodeHasChanged();
 	}
 	else
 		CArmedInstance::updateMoraleBonusFromArmy();
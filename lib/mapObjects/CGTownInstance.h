@@ -66,6 +66,7 @@ public:
 
 	CSpecObjInfo * info; //random dwelling options; not serialized
 	TCreaturesSet creatures; //creatures[level] -> <vector of alternative ids (base creature and upgrades, creatures amount>
+	ui32 creaturesVersion; //number of SetAvailableCreatures applied, lets clients detect missed delta updates
 
 	CGDwelling();
 	virtual ~CGDwelling();
@@ -90,6 +91,8 @@ public:
 	{
 		h & static_cast<CArmedInstance&>(*this);
 		h & creatures;
+		if(version >= 779)
+			h & creaturesVersion;
 	}
 };
 
@@ -236,8 +236,7 @@ CMapHeader::~CMapHeader()
 }
 
 CMap::CMap()
-	: checksum(0), grailPos(-1, -1, -1), grailRadius(0), terrain(nullptr),
-	guardingCreaturePositions(nullptr)
+	: checksum(0), grailPos(-1, -1, -1), grailRadius(0)
 {
 	allHeroes.resize(allowedHeroes.size());
 	allowedAbilities = VLC->heroh->getDefaultAllowedAbilities();
@@ -247,22 +246,6 @@ CMap::CMap()
 
 CMap::~CMap()
 {
-	if(terrain)
-	{
-		for (int i=0; i<width; i++)
-		{
-			for(int j=0; j<height; j++)
-			{
-				delete [] terrain[i][j];
-				delete [] guardingCreaturePositions[i][j];
-			}
-			delete [] terrain[i];
-			delete [] guardingCreaturePositions[i];
-		}
-		delete [] terrain;
-		delete [] guardingCreaturePositions;
-	}
-
 	for(auto obj : objects)
 		obj.dellNull();
 
@@ -281,7 +264,7 @@ void CMap::removeBlockVisTiles(CGObjectInstance * obj, bool total)
 			int zVal = obj->pos.z;
 			if(xVal>=0 && xVal<width && yVal>=0 && yVal<height)
 			{
-				TerrainTile & curt = terrain[xVal][yVal][zVal];
+				TerrainTile & curt = getTile(int3(xVal, yVal, zVal));
 				if(total || obj->visitableAt(xVal, yVal))
 				{
 					curt.visitableObjects -= obj;
@@ -308,7 +291,7 @@ void CMap::addBlockVisTiles(CGObjectInstance * obj)
 			int zVal = obj->pos.z;
 			if(xVal>=0 && xVal<width && yVal>=0 && yVal<height)
 			{
-				TerrainTile & curt = terrain[xVal][yVal][zVal];
+				TerrainTile & curt = getTile(int3(xVal, yVal, zVal));
 				if( obj->visitableAt(xVal, yVal))
 				{
 					curt.visitableObjects.push_back(obj);
@@ -326,15 +309,8 @@ void CMap::addBlockVisTiles(CGObjectInstance * obj)
 
 void CMap::calculateGuardingGreaturePositions()
 {
-	int levels = twoLevel ? 2 : 1;
-	for (int i=0; i<width; i++)
-	{
-		for(int j=0; j<height; j++)
-		{
-			for (int k = 0; k < levels; k++)
-				guardingCreaturePositions[i][j][k] = guardingCreaturePosition(int3(i,j,k));
-		}
-	}
+	for(size_t i = 0; i < guardingCreaturePositions.size(); i++)
+		guardingCreaturePositions[i] = guardingCreaturePosition(getTilePos(i));
 }
 
 CGHeroInstance * CMap::getHero(int heroID)
@@ -390,13 +366,29 @@ bool CMap::isInTheMap(const int3 & pos) const
 TerrainTile & CMap::getTile(const int3 & tile)
 {
 	assert(isInTheMap(tile));
-	return terrain[tile.x][tile.y][tile.z];
+	return terrain[getTileIndex(tile)];
 }
 
 const TerrainTile & CMap::getTile(const int3 & tile) const
 {
 	assert(isInTheMap(tile));
-	return terrain[tile.x][tile.y][tile.z];
+	return terrain[getTileIndex(tile)];
+}
+
+int3 CMap::getTilePos(size_t index) const
+{
+	const size_t levelSize = static_cast<size_t>(width) * height;
+	return int3(index % width, (index % levelSize) / width, index / levelSize);
+}
+
+std::vector<TerrainTile> & CMap::getTiles()
+{
+	return terrain;
+}
+
+const std::vector<TerrainTile> & CMap::getTiles() const
+{
+	return terrain;
 }
 
 bool CMap::isWaterTile(const int3 &pos) const
@@ -626,19 +618,9 @@ void CMap::addNewObject(CGObjectInstance * obj)
 
 void CMap::initTerrain()
 {
-	int level = twoLevel ? 2 : 1;
-	terrain = new TerrainTile**[width];
-	guardingCreaturePositions = new int3**[width];
-	for (int i = 0; i < width; ++i)
-	{
-		terrain[i] = new TerrainTile*[height];
-		guardingCreaturePositions[i] = new int3*[height];
-		for (int j = 0; j < height; ++j)
-		{
-			terrain[i][j] = new TerrainTile[level];
-			guardingCreaturePositions[i][j] = new int3[level];
-		}
-	}
+	const size_t tilesCount = static_cast<size_t>(width) * height * (twoLevel ? 2 : 1);
+	terrain.assign(tilesCount, TerrainTile());
+	guardingCreaturePositions.assign(tilesCount, int3());
 }
 
 CMapEditManager * CMap::getEditManager()
@@ -354,6 +354,16 @@ public:
 	CMapEditManager * getEditManager();
 	TerrainTile & getTile(const int3 & tile);
 	const TerrainTile & getTile(const int3 & tile) const;
+
+	/// Position of tile in flat tile arrays, these are z-major: each level is contiguous and stored row by row
+	size_t getTileIndex(const int3 & tile) const
+	{
+		return (static_cast<size_t>(tile.z) * height + tile.y) * width + tile.x;
+	}
+	int3 getTilePos(size_t index) const;
+	/// All tiles ordered by getTileIndex, for loops over the whole map
+	std::vector<TerrainTile> & getTiles();
+	const std::vector<TerrainTile> & getTiles() const;
 	bool isCoastalTile(const int3 & pos) const;
 	bool isInTheMap(const int3 & pos) const;
 	bool isWaterTile(const int3 & pos) const;
@@ -408,13 +418,13 @@ public:
 
 	std::unique_ptr<CMapEditManager> editManager;
 
-	int3 ***guardingCreaturePositions;
+	std::vector<int3> guardingCreaturePositions; //indexed by getTileIndex
 
 	std::map<std::string, ConstTransitivePtr<CGObjectInstance> > instanceNames;
 
 private:
-	/// a 3-dimensional array of terrain tiles, access is as follows: x, y, level. where level=1 is underground
-	TerrainTile*** terrain;
+	/// terrain tiles of all levels indexed by getTileIndex, level=1 is underground
+	std::vector<TerrainTile> terrain;
 
 public:
 	template <typename Handler>
@@ -443,35 +453,26 @@ public:
 				{
 					for(int k = 0; k < level; ++k)
 					{
-						h & terrain[i][j][k];
-						h & guardingCreaturePositions[i][j][k];
+						const size_t index = getTileIndex(int3(i, j, k));
+						h & terrain[index];
+						h & guardingCreaturePositions[index];
 					}
 				}
 			}
 		}
 		else
 		{
-			// Load terrain
-			terrain = new TerrainTile**[width];
-			guardingCreaturePositions = new int3**[width];
-			for(int i = 0; i < width; ++i)
-			{
-				terrain[i] = new TerrainTile*[height];
-				guardingCreaturePositions[i] = new int3*[height];
-				for(int j = 0; j < height; ++j)
-				{
-					terrain[i][j] = new TerrainTile[level];
-					guardingCreaturePositions[i][j] = new int3[level];
-				}
-			}
+			// Load terrain, same tile order as before flat storage to keep saves compatible
+			initTerrain();
 			for(int i = 0; i < width ; ++i)
 			{
 				for(int j = 0; j < height ; ++j)
 				{
 					for(int k = 0; k < level; ++k)
 					{
-						h & terrain[i][j][k];
-						h & guardingCreaturePositions[i][j][k];
+						const size_t index = getTileIndex(int3(i, j, k));
+						h & terrain[index];
+						h & guardingCreaturePositions[index];
 					}
 				}
 			}
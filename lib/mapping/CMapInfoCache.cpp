@@ -0,0 +1,154 @@
+/*
+ * CMapInfoCache.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CMapInfoCache.h"
+
+#include "../CCreatureHandler.h"
+#include "../CHeroHandler.h"
+#include "../CThreadHelper.h"
+#include "../StartInfo.h"
+#include "../rmg/CMapGenOptions.h"
+#include "../filesystem/Filesystem.h"
+#include "../serializer/BinaryDeserializer.h"
+#include "../serializer/BinarySerializer.h"
+
+CMapInfoCache::CMapInfoCache(ui32 modsChecksum)
+	: modsChecksum(modsChecksum)
+{
+}
+
+void CMapInfoCache::load(const boost::filesystem::path & cacheFile)
+{
+	if(!boost::filesystem::exists(cacheFile))
+		return;
+
+	const ui32 expectedChecksum = modsChecksum;
+	try
+	{
+		CLoadFile file(cacheFile);
+		file >> *this;
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->warn("Map info cache %s is not valid and will be rebuilt: %s", cacheFile.string(), e.what());
+		entries.clear();
+	}
+
+	if(modsChecksum != expectedChecksum)
+	{
+		logGlobal->debug("Map info cache %s was written with other mods and will be rebuilt", cacheFile.string());
+		modsChecksum = expectedChecksum;
+		entries.clear();
+	}
+}
+
+void CMapInfoCache::save(const boost::filesystem::path & cacheFile) const
+{
+	CSaveFile file(cacheFile);
+	file << *this;
+}
+
+std::vector<CMapInfo> CMapInfoCache::scan(const boost::filesystem::path & cacheFile, ui32 modsChecksum, const std::unordered_set<ResourceID> & files, const TParser & parser)
+{
+	CMapInfoCache cache(modsChecksum);
+	cache.load(cacheFile);
+
+	struct Item
+	{
+		ResourceID resource;
+		std::string path; //empty if file is not on disk (e.g. in archive) and cannot be cached
+		ui64 size;
+		si64 modified;
+		std::shared_ptr<CMapInfo> info;
+	};
+
+	std::vector<Item> items;
+	std::vector<Task> tasks;
+	std::map<std::string, Entry> scanned;
+	items.reserve(files.size());
+
+	for(auto & file : files)
+	{
+		Item item = {file, "", 0, 0, nullptr};
+		auto path = CResourceHandler::get()->getResourceName(file);
+		boost::system::error_code ec;
+		if(path)
+		{
+			item.size = boost::filesystem::file_size(*path, ec);
+			if(!ec)
+				item.modified = boost::filesystem::last_write_time(*path, ec);
+			if(!ec)
+				item.path = path->string();
+		}
+
+		auto entry = cache.entries.find(item.path);
+		if(!item.path.empty() && entry != cache.entries.end() && entry->second.size == item.size && entry->second.modified == item.modified)
+		{
+			item.info = entry->second.info;
+			scanned[item.path] = entry->second;
+		}
+		items.push_back(item);
+	}
+
+	for(auto & item : items)
+	{
+		if(item.info)
+			continue;
+
+		Item * target = &item;
+		tasks.push_back([target, &parser]()
+		{
+			try
+			{
+				auto info = std::make_shared<CMapInfo>();
+				parser(*info, target->resource);
+				target->info = info;
+			}
+			catch(const std::exception & e)
+			{
+				logGlobal->error("Failed to process %s: %s", target->resource.getName(), e.what());
+			}
+		});
+	}
+
+	logGlobal->debug("Scanning %d files, %d of them are not cached", items.size(), tasks.size());
+	CThreadHelper::runParallel(tasks);
+
+	for(auto & item : items)
+	{
+		if(item.info && !item.path.empty() && !vstd::contains(scanned, item.path))
+		{
+			Entry entry = {item.size, item.modified, item.info};
+			scanned[item.path] = entry;
+		}
+	}
+
+	if(!tasks.empty() || scanned.size() != cache.entries.size())
+	{
+		cache.entries = std::move(scanned);
+		try
+		{
+			cache.save(cacheFile);
+		}
+		catch(const std::exception & e)
+		{
+			logGlobal->warn("Failed to write map info cache %s: %s", cacheFile.string(), e.what());
+		}
+	}
+
+	std::vector<CMapInfo> ret;
+	ret.reserve(items.size());
+	for(auto & item : items)
+	{
+		if(item.info)
+			ret.push_back(std::move(*item.info)); //cache is already written, infos can be taken out of it
+	}
+	return ret;
+}
@@ -0,0 +1,56 @@
+/*
+ * CMapInfoCache.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "CMapInfo.h"
+#include "../filesystem/ResourceID.h"
+
+/// Persistent cache of map and savegame headers listed in scenario selection.
+/// Entries are keyed by file path, size and modification time, so unchanged files are never parsed again.
+/// Parsed headers depend on loaded mods (e.g. creatures and factions), so whole cache is valid only with mods it was written with
+class DLL_LINKAGE CMapInfoCache
+{
+public:
+	typedef std::function<void(CMapInfo &, const ResourceID &)> TParser;
+
+	/// Returns infos of all files which could be parsed. Files which are not in cache file or changed are parsed
+	/// in parallel; parser may throw, such files are skipped. Cache file is then updated to hold exactly these files.
+	/// Cache file written with different modsChecksum (see CModHandler::getActiveModsChecksum) is ignored
+	static std::vector<CMapInfo> scan(const boost::filesystem::path & cacheFile, ui32 modsChecksum, const std::unordered_set<ResourceID> & files, const TParser & parser);
+
+	template <typename Handler> void serialize(Handler &h, const int version)
+	{
+		h & modsChecksum;
+		h & entries;
+	}
+
+private:
+	struct Entry
+	{
+		ui64 size;
+		si64 modified;
+		std::shared_ptr<CMapInfo> info;
+
+		template <typename Handler> void serialize(Handler &h, const int version)
+		{
+			h & size;
+			h & modified;
+			h & info;
+		}
+	};
+
+	ui32 modsChecksum;
+	std::map<std::string, Entry> entries; //file path -> entry
+
+	explicit CMapInfoCache(ui32 modsChecksum);
+
+	void load(const boost::filesystem::path & cacheFile);
+	void save(const boost::filesystem::path & cacheFile) const;
+};
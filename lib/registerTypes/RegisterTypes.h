@@ -339,6 +339,7 @@ void registerTypesServerPacks(Serializer &s)
 	s.template registerType<CPackForServer, CastAdvSpell>();
 	s.template registerType<CPackForServer, CastleTeleportHero>();
 	s.template registerType<CPackForServer, CommitPackage>();
+	s.template registerType<CPackForServer, RequestAvailableCreatures>();
 
 	s.template registerType<CPackForServer, SaveGame>();
 	s.template registerType<CPackForServer, PlayerMessage>();
@@ -208,7 +208,6 @@ void CMapGenOptions::setMapTemplate(const CRmgTemplate * value)
 {
 	mapTemplate = value;
 	//TODO validate & adapt options according to template
-	assert(0);
 }
 
 const std::map<std::string, CRmgTemplate *> & CMapGenOptions::getAvailableTemplates() const
@@ -19,10 +19,16 @@
 #include "../filesystem/Filesystem.h"
 #include "CZonePlacer.h"
 #include "../mapObjects/CObjectClassesHandler.h"
+#include "../CThreadHelper.h"
 
 static const int3 dirs4[] = {int3(0,1,0),int3(0,-1,0),int3(-1,0,0),int3(+1,0,0)};
 static const int3 dirsDiagonal[] = { int3(1,1,0),int3(1,-1,0),int3(-1,1,0),int3(-1,-1,0) };
 
+static si64 getMicroseconds()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void CMapGenerator::foreach_neighbour(const int3 &pos, std::function<void(int3& pos)> foo)
 {
 	for(const int3 &dir : int3::getDirs())
@@ -58,7 +64,7 @@ void CMapGenerator::foreachDiagonaltNeighbour(const int3& pos, std::function<voi
 
 CMapGenerator::CMapGenerator() :
 	mapGenOptions(nullptr), randomSeed(0), editManager(nullptr),
-	zonesTotal(0), tiles(nullptr), prisonsRemaining(0),
+	zonesTotal(0), phaseStart(0), prisonsRemaining(0),
     monolithIndex(0)
 {
 }
@@ -66,40 +72,13 @@ CMapGenerator::CMapGenerator() :
 void CMapGenerator::initTiles()
 {
 	map->initTerrain();
-
-	int width = map->width;
-	int height = map->height;
-
-	int level = map->twoLevel ? 2 : 1;
-	tiles = new CTileInfo**[width];
-	for (int i = 0; i < width; ++i)
-	{
-		tiles[i] = new CTileInfo*[height];
-		for (int j = 0; j < height; ++j)
-		{
-			tiles[i][j] = new CTileInfo[level];
-		}
-	}
+	tiles.assign(map->getTiles().size(), CTileInfo());
 
 	zoneColouring.resize(boost::extents[map->twoLevel ? 2 : 1][map->width][map->height]);
 }
 
 CMapGenerator::~CMapGenerator()
 {
-	if (tiles)
-	{
-		int width = mapGenOptions->getWidth();
-		int height = mapGenOptions->getHeight();
-		for (int i=0; i < width; i++)
-		{
-			for(int j=0; j < height; j++)
-			{
-				delete [] tiles[i][j];
-			}
-			delete [] tiles[i];
-		}
-		delete [] tiles;
-	}
 }
 
 void CMapGenerator::initPrisonsRemaining()
@@ -129,6 +108,9 @@ std::unique_ptr<CMap> CMapGenerator::generate(CMapGenOptions * mapGenOptions, in
 
 	assert(mapGenOptions);
 
+	phaseTimings.clear();
+	phaseStart = getMicroseconds();
+
 	rand.setSeed(this->randomSeed);
 	mapGenOptions->finalize(rand);
 
@@ -144,8 +126,10 @@ std::unique_ptr<CMap> CMapGenerator::generate(CMapGenOptions * mapGenOptions, in
 
 		initPrisonsRemaining();
 		initQuestArtsRemaining();
+		finishPhase("init");
 		genZones();
 		map->calculateGuardingGreaturePositions(); //clear map so that all tiles are unguarded
+		finishPhase("zone placement");
 		fillZones();
 		//updated guarded tiles will be calculated in CGameState::initMapObjects()
 	}
@@ -156,6 +140,19 @@ std::unique_ptr<CMap> CMapGenerator::generate(CMapGenOptions * mapGenOptions, in
 	return std::move(map);
 }
 
+const CMapGenerator::TPhaseTimings & CMapGenerator::getPhaseTimings() const
+{
+	return phaseTimings;
+}
+
+void CMapGenerator::finishPhase(const std::string & name)
+{
+	const si64 now = getMicroseconds();
+	phaseTimings.push_back(std::make_pair(name, now - phaseStart));
+	logGlobal->debug("RMG phase %s took %d ms", name, (now - phaseStart) / 1000);
+	phaseStart = now;
+}
+
 std::string CMapGenerator::getMapDescription() const
 {
 	assert(mapGenOptions);
@@ -292,6 +289,10 @@ void CMapGenerator::fillZones()
 
 	logGlobal->info("Started filling zones");
 
+	//work which may run concurrently draws random numbers from zone's own stream, seeded in fixed order
+	for (auto it : zones)
+		it.second->setRandomSeed(rand.nextInt());
+
 	//we need info about all town types to evaluate dwellings and pandoras with creatures properly
 	//place main town in the middle
 	for (auto it : zones)
@@ -315,6 +316,7 @@ void CMapGenerator::fillZones()
 		if (it.second->getType() == ETemplateZoneType::TREASURE)
 			treasureZones.push_back(it.second);
 	}
+	finishPhase("fill zones");
 
 	//set apriopriate free/occupied tiles, including blocked underground rock
 	createObstaclesCommon1();
@@ -322,11 +324,19 @@ void CMapGenerator::fillZones()
 	for (auto it : zones)
 		it.second->createObstacles1(this);
 	createObstaclesCommon2();
+
+	const auto zoneGroups = getIndependentZoneGroups();
+	logGlobal->debug("%d zones split into %d groups of independent zones", zones.size(), zoneGroups.size());
+
 	//place actual obstacles matching zone terrain
-	for (auto it : zones)
+	forEachZoneConcurrently(zoneGroups, [this](CRmgTemplateZone * zone)
 	{
-		it.second->createObstacles2(this);
-	}
+		zone->createObstacles2(this);
+	});
+	//insert objects in zone order, so their ids don't depend on thread scheduling
+	for (auto it : zones)
+		it.second->placeObstacles(this);
+	finishPhase("obstacles");
 
 	#define PRINT_MAP_BEFORE_ROADS false
 	if (PRINT_MAP_BEFORE_ROADS) //enable to debug
@@ -363,10 +373,13 @@ void CMapGenerator::fillZones()
 		out << std::endl;
 	}
 
+	//draw roads after everything else has been placed
+	//roads of zone guards end on tiles of neighbouring zones and are checked against roads of other zones, so zones are connected one by one
 	for (auto it : zones)
-	{
-		it.second->connectRoads(this); //draw roads after everything else has been placed
-	}
+		it.second->connectRoads(this);
+	for (auto it : zones)
+		it.second->drawRoads(this);
+	finishPhase("roads");
 
 	//find place for Grail
 	if (treasureZones.empty())
@@ -381,6 +394,87 @@ void CMapGenerator::fillZones()
 	logGlobal->info("Zones filled successfully");
 }
 
+std::vector<std::vector<CRmgTemplateZone *>> CMapGenerator::getIndependentZoneGroups() const
+{
+	//obstacle placed from a zone tile reaches up to (template size - 1) tiles away: its block map offset points right and down
+	//from that tile, its blocked tiles left and up from its position. Zones at least twice that far apart never touch same tiles
+	int margin = 0;
+	for (auto primaryID : VLC->objtypeh->knownObjects())
+	{
+		for (auto secondaryID : VLC->objtypeh->knownSubObjects(primaryID))
+		{
+			auto handler = VLC->objtypeh->getHandlerFor(primaryID, secondaryID);
+			if (handler->isStaticObject())
+			{
+				for (auto temp : handler->getTemplates())
+					vstd::amax(margin, std::max(temp.getWidth(), temp.getHeight()) - 1);
+			}
+		}
+	}
+
+	std::map<TRmgTemplateZoneId, std::pair<int3, int3>> bounds; //min and max corner
+	for (auto it : zones)
+		bounds[it.first] = std::make_pair(it.second->getPos(), it.second->getPos());
+
+	for (int z = 0; z < (map->twoLevel ? 2 : 1); z++)
+	{
+		for (int x = 0; x < map->width; x++)
+		{
+			for (int y = 0; y < map->height; y++)
+			{
+				auto it = bounds.find(zoneColouring[z][x][y]);
+				if (it == bounds.end())
+					continue;
+				vstd::amin(it->second.first.x, x);
+				vstd::amin(it->second.first.y, y);
+				vstd::amin(it->second.first.z, z);
+				vstd::amax(it->second.second.x, x);
+				vstd::amax(it->second.second.y, y);
+				vstd::amax(it->second.second.z, z);
+			}
+		}
+	}
+
+	auto overlap = [&bounds, margin](TRmgTemplateZoneId a, TRmgTemplateZoneId b) -> bool
+	{
+		const auto & first = bounds.at(a);
+		const auto & second = bounds.at(b);
+		return first.first.x - margin <= second.second.x + margin && second.first.x - margin <= first.second.x + margin
+			&& first.first.y - margin <= second.second.y + margin && second.first.y - margin <= first.second.y + margin
+			&& first.first.z <= second.second.z && second.first.z <= first.second.z;
+	};
+
+	//greedy colouring in zone order keeps grouping deterministic
+	std::vector<std::vector<CRmgTemplateZone *>> groups;
+	for (auto it : zones)
+	{
+		auto group = boost::find_if(groups, [&](const std::vector<CRmgTemplateZone *> & candidate) -> bool
+		{
+			return !vstd::contains_if(candidate, [&](const CRmgTemplateZone * other)
+			{
+				return overlap(it.first, other->getId());
+			});
+		});
+		if (group == groups.end())
+			groups.push_back(std::vector<CRmgTemplateZone *>(1, it.second));
+		else
+			group->push_back(it.second);
+	}
+	return groups;
+}
+
+void CMapGenerator::forEachZoneConcurrently(const std::vector<std::vector<CRmgTemplateZone *>> & groups, const std::function<void(CRmgTemplateZone *)> & action)
+{
+	//zones within a group never touch same tiles, groups are processed one after another
+	for (const auto & group : groups)
+	{
+		std::vector<Task> tasks;
+		for (auto zone : group)
+			tasks.push_back(std::bind(action, zone));
+		CThreadHelper::runParallel(tasks);
+	}
+}
+
 void CMapGenerator::createObstaclesCommon1()
 {
 	if (map->twoLevel) //underground
@@ -592,8 +686,8 @@ void CMapGenerator::createConnections2()
 			{
 				bool continueOuterLoop = false;
 				//find common tiles for both zones
-				auto tileSetA = zoneA->getPossibleTiles(),
-					tileSetB = zoneB->getPossibleTiles();
+				const auto & tileSetA = zoneA->getPossibleTiles();
+				const auto & tileSetB = zoneB->getPossibleTiles();
 
 				std::vector<int3> tilesA(tileSetA.begin(), tileSetA.end()),
 					tilesB(tileSetB.begin(), tileSetB.end());
@@ -716,52 +810,52 @@ bool CMapGenerator::isBlocked(const int3 &tile) const
 {
 	checkIsOnMap(tile);
 
-	return tiles[tile.x][tile.y][tile.z].isBlocked();
+	return tiles[map->getTileIndex(tile)].isBlocked();
 }
 bool CMapGenerator::shouldBeBlocked(const int3 &tile) const
 {
 	checkIsOnMap(tile);
 
-	return tiles[tile.x][tile.y][tile.z].shouldBeBlocked();
+	return tiles[map->getTileIndex(tile)].shouldBeBlocked();
 }
 bool CMapGenerator::isPossible(const int3 &tile) const
 {
 	checkIsOnMap(tile);
 
-	return tiles[tile.x][tile.y][tile.z].isPossible();
+	return tiles[map->getTileIndex(tile)].isPossible();
 }
 bool CMapGenerator::isFree(const int3 &tile) const
 {
 	checkIsOnMap(tile);
 
-	return tiles[tile.x][tile.y][tile.z].isFree();
+	return tiles[map->getTileIndex(tile)].isFree();
 }
 bool CMapGenerator::isUsed(const int3 &tile) const
 {
 	checkIsOnMap(tile);
 
-	return tiles[tile.x][tile.y][tile.z].isUsed();
+	return tiles[map->getTileIndex(tile)].isUsed();
 }
 
 bool CMapGenerator::isRoad(const int3& tile) const
 {
 	checkIsOnMap(tile);
 
-	return tiles[tile.x][tile.y][tile.z].isRoad();
+	return tiles[map->getTileIndex(tile)].isRoad();
 }
 
 void CMapGenerator::setOccupied(const int3 &tile, ETileType::ETileType state)
 {
 	checkIsOnMap(tile);
 
-	tiles[tile.x][tile.y][tile.z].setOccupied(state);
+	tiles[map->getTileIndex(tile)].setOccupied(state);
 }
 
 void CMapGenerator::setRoad(const int3& tile, ERoadType::ERoadType roadType)
 {
 	checkIsOnMap(tile);
 
-	tiles[tile.x][tile.y][tile.z].setRoadType(roadType);
+	tiles[map->getTileIndex(tile)].setRoadType(roadType);
 }
 
 
@@ -769,7 +863,7 @@ CTileInfo CMapGenerator::getTile(const int3& tile) const
 {
 	checkIsOnMap(tile);
 
-	return tiles[tile.x][tile.y][tile.z];
+	return tiles[map->getTileIndex(tile)];
 }
 
 TRmgTemplateZoneId CMapGenerator::getZoneID(const int3& tile) const
@@ -801,14 +895,14 @@ void CMapGenerator::setNearestObjectDistance(int3 &tile, float value)
 {
 	checkIsOnMap(tile);
 
-	tiles[tile.x][tile.y][tile.z].setNearestObjectDistance(value);
+	tiles[map->getTileIndex(tile)].setNearestObjectDistance(value);
 }
 
 float CMapGenerator::getNearestObjectDistance(const int3 &tile) const
 {
 	checkIsOnMap(tile);
 
-	return tiles[tile.x][tile.y][tile.z].getNearestObjectDistance();
+	return tiles[map->getTileIndex(tile)].getNearestObjectDistance();
 }
 
 int CMapGenerator::getNextMonlithIndex()
@@ -54,7 +54,12 @@ public:
 	explicit CMapGenerator();
 	~CMapGenerator(); // required due to std::unique_ptr
 
+	/// Name and wall time in microseconds of each generation phase, in order of execution
+	typedef std::vector<std::pair<std::string, si64>> TPhaseTimings;
+
 	std::unique_ptr<CMap> generate(CMapGenOptions * mapGenOptions, int RandomSeed = std::time(nullptr));
+	/// Timings of the last call to generate
+	const TPhaseTimings & getPhaseTimings() const;
 
 	CMapGenOptions * mapGenOptions;
 	std::unique_ptr<CMap> map;
@@ -105,9 +110,12 @@ private:
 	std::map<TFaction, ui32> zonesPerFaction;
 	ui32 zonesTotal; //zones that have their main town only
 
-	CTileInfo*** tiles;
+	std::vector<CTileInfo> tiles; //indexed by CMap::getTileIndex
 	boost::multi_array<TRmgTemplateZoneId, 3> zoneColouring; //[z][x][y]
 
+	TPhaseTimings phaseTimings;
+	si64 phaseStart;
+
 	int prisonsRemaining;
 	//int questArtsRemaining;
 	int monolithIndex;
@@ -117,6 +125,9 @@ private:
 	/// Generation methods
 	std::string getMapDescription() const;
 
+	/// Records time elapsed since end of previous phase
+	void finishPhase(const std::string & name);
+
 	void initPrisonsRemaining();
 	void initQuestArtsRemaining();
 	void addPlayerInfo();
@@ -124,6 +135,10 @@ private:
 	void initTiles();
 	void genZones();
 	void fillZones();
+	/// Splits zones into groups whose members are far enough apart to place obstacles concurrently
+	std::vector<std::vector<CRmgTemplateZone *>> getIndependentZoneGroups() const;
+	/// Runs action for all zones, zones of the same group run concurrently
+	void forEachZoneConcurrently(const std::vector<std::vector<CRmgTemplateZone *>> & groups, const std::function<void(CRmgTemplateZone *)> & action);
 	void createObstaclesCommon1();
 	void createObstaclesCommon2();
 
@@ -391,7 +391,7 @@ std::set<int3> CRmgTemplateZone::getTileInfo () const
 {
 	return tileinfo;
 }
-std::set<int3> CRmgTemplateZone::getPossibleTiles() const
+const CTileSet & CRmgTemplateZone::getPossibleTiles() const
 {
 	return possibleTiles;
 }
@@ -421,10 +421,13 @@ void CRmgTemplateZone::clearTiles()
 
 void CRmgTemplateZone::initFreeTiles (CMapGenerator* gen)
 {
-	vstd::copy_if (tileinfo, vstd::set_inserter(possibleTiles), [gen](const int3 &tile) -> bool
+	possibleTiles.resize(int3(gen->map->width, gen->map->height, gen->map->twoLevel ? 2 : 1));
+	possibleTilesByDistance.clear();
+	for (auto tile : tileinfo)
 	{
-		return gen->isPossible(tile);
-	});
+		if (gen->isPossible(tile))
+			addPossibleTile(gen, tile);
+	}
 	if (freePaths.empty())
 	{
 		gen->setOccupied(pos, ETileType::FREE);
@@ -914,7 +917,7 @@ bool CRmgTemplateZone::connectPath(CMapGenerator* gen, const int3& src, bool onl
 	for (auto tile : closed) //these tiles are sealed off and can't be connected anymore
 	{
 		gen->setOccupied (tile, ETileType::BLOCKED);
-		vstd::erase_if_present(possibleTiles, tile);
+		removePossibleTile(gen, tile);
 	}
 	return false;
 }
@@ -1308,7 +1311,7 @@ bool CRmgTemplateZone::createTreasurePile(CMapGenerator* gen, int3 &pos, float m
 	else //we did not place eveyrthing successfully
 	{
 		gen->setOccupied(pos, ETileType::BLOCKED); //TODO: refactor stop condition
-		vstd::erase_if_present(possibleTiles, pos);
+		removePossibleTile(gen, pos);
 		return false;
 	}
 }
@@ -1719,9 +1722,12 @@ void CRmgTemplateZone::createTreasures(CMapGenerator* gen)
 		bool stop = false;
 		do {
 			//optimization - don't check tiles which are not allowed
-			vstd::erase_if(possibleTiles, [gen](const int3 &tile) -> bool
+			possibleTiles.eraseIf([this, gen](const int3 &tile) -> bool
 			{
-				return !gen->isPossible(tile);
+				if (gen->isPossible(tile))
+					return false;
+				possibleTilesByDistance.erase(std::make_pair(gen->getNearestObjectDistance(tile), tile));
+				return true;
 			});
 
 
@@ -1763,7 +1769,8 @@ void CRmgTemplateZone::createObstacles1(CMapGenerator * gen)
 void CRmgTemplateZone::createObstacles2(CMapGenerator* gen)
 {
 
-	typedef std::vector<ObjectTemplate> obstacleVector;
+	typedef std::pair<ObjectTemplate, std::vector<int3>> obstacleInfo; //template with its blocked offsets, computed once
+	typedef std::vector<obstacleInfo> obstacleVector;
 	//obstacleVector possibleObstacles;
 
 	std::map <ui8, obstacleVector> obstaclesBySize;
@@ -1781,7 +1788,10 @@ void CRmgTemplateZone::createObstacles2(CMapGenerator* gen)
 				for (auto temp : handler->getTemplates())
 				{
 					if (temp.canBePlacedAt(terrainType) && temp.getBlockMapOffset().valid())
-						obstaclesBySize[temp.getBlockedOffsets().size()].push_back(temp);
+					{
+						auto blockedOffsets = temp.getBlockedOffsets();
+						obstaclesBySize[blockedOffsets.size()].push_back(std::make_pair(temp, std::vector<int3>(blockedOffsets.begin(), blockedOffsets.end())));
+					}
 				}
 			}
 		}
@@ -1795,17 +1805,18 @@ void CRmgTemplateZone::createObstacles2(CMapGenerator* gen)
 		return p1.first > p2.first; //bigger obstacles first
 	});
 
-	auto sel = gen->editManager->getTerrainSelection();
-	sel.clearSelection();
-
+	//map itself is updated later by placeObstacles, in zone order, so object ids don't depend on thread scheduling
 	auto tryToPlaceObstacleHere = [this, gen, &possibleObstacles](int3& tile, int index)-> bool
 	{
-		auto temp = *RandomGeneratorUtil::nextItem(possibleObstacles[index].second, gen->rand);
+		const auto & obstacle = *RandomGeneratorUtil::nextItem(possibleObstacles[index].second, rand);
+		const auto & temp = obstacle.first;
 		int3 obstaclePos = tile + temp.getBlockMapOffset();
-		if (canObstacleBePlacedHere(gen, temp, obstaclePos)) //can be placed here
+		if (canObstacleBePlacedHere(gen, obstacle.second, obstaclePos)) //can be placed here
 		{
 			auto obj = VLC->objtypeh->getHandlerFor(temp.id, temp.subid)->create(temp);
-			placeObject(gen, obj, obstaclePos, false);
+			obj->pos = obstaclePos;
+			occupyObjectTiles(gen, obj, obstaclePos);
+			plannedObstacles.push_back(obj);
 			return true;
 		}
 		return false;
@@ -1815,7 +1826,7 @@ void CRmgTemplateZone::createObstacles2(CMapGenerator* gen)
 	for (auto tile : boost::adaptors::reverse(tileinfo))
 	{
 		//fill tiles that should be blocked with obstacles or are just possible (with some probability)
-		if (gen->shouldBeBlocked(tile) || (gen->isPossible(tile) && gen->rand.nextInt(1,100) < 60))
+		if (gen->shouldBeBlocked(tile) || (gen->isPossible(tile) && rand.nextInt(1,100) < 60))
 		{
 			//start from biggets obstacles
 			for (int i = 0; i < possibleObstacles.size(); i++)
@@ -1835,6 +1846,13 @@ void CRmgTemplateZone::createObstacles2(CMapGenerator* gen)
 	}
 }
 
+void CRmgTemplateZone::placeObstacles(CMapGenerator* gen)
+{
+	for (auto obj : plannedObstacles)
+		checkAndPlaceObject(gen, obj, obj->pos);
+	plannedObstacles.clear();
+}
+
 void CRmgTemplateZone::connectRoads(CMapGenerator* gen)
 {
 	logGlobal->debug("Started building roads");
@@ -1871,8 +1889,6 @@ void CRmgTemplateZone::connectRoads(CMapGenerator* gen)
 		processed.insert(node);
 	}
 
-	drawRoads(gen);
-
 	logGlobal->debug("Finished building roads");
 }
 
@@ -1894,6 +1910,11 @@ void CRmgTemplateZone::drawRoads(CMapGenerator* gen)
 	gen->editManager->drawRoad(ERoadType::COBBLESTONE_ROAD, &gen->rand);
 }
 
+void CRmgTemplateZone::setRandomSeed(int seed)
+{
+	rand.setSeed(seed);
+}
+
 
 bool CRmgTemplateZone::fill(CMapGenerator* gen)
 {
@@ -1923,26 +1944,17 @@ bool CRmgTemplateZone::findPlaceForTreasurePile(CMapGenerator* gen, float min_di
 	bool needsGuard = value > minGuardedValue;
 
 	//logGlobal->info("Min dist for density %f is %d", density, min_dist);
-	for(auto tile : possibleTiles)
+	//tiles are sorted by distance, so first tile which fits is the most distant one
+	for (const auto & candidate : possibleTilesByDistance)
 	{
-		auto dist = gen->getNearestObjectDistance(tile);
+		if (candidate.first < min_dist || candidate.first <= best_distance)
+			break;
 
-		if ((dist >= min_dist) && (dist > best_distance))
+		if (canTreasurePileBePlacedHere(gen, candidate.second, needsGuard))
 		{
-			bool allTilesAvailable = true;
-			gen->foreach_neighbour (tile, [&gen, &allTilesAvailable, needsGuard](int3 neighbour)
-			{
-				if (!(gen->isPossible(neighbour) || gen->shouldBeBlocked(neighbour) || (!needsGuard && gen->isFree(neighbour))))
-				{
-					allTilesAvailable = false; //all present tiles must be already blocked or ready for new objects
-				}
-			});
-			if (allTilesAvailable)
-			{
-				best_distance = dist;
-				pos = tile;
-				result = true;
-			}
+			pos = candidate.second;
+			result = true;
+			break;
 		}
 	}
 	if (result)
@@ -1952,14 +1964,25 @@ bool CRmgTemplateZone::findPlaceForTreasurePile(CMapGenerator* gen, float min_di
 	return result;
 }
 
-bool CRmgTemplateZone::canObstacleBePlacedHere(CMapGenerator* gen, ObjectTemplate &temp, int3 &pos)
+bool CRmgTemplateZone::canTreasurePileBePlacedHere(CMapGenerator* gen, const int3 &tile, bool needsGuard) const
+{
+	for (const int3 &dir : int3::getDirs())
+	{
+		int3 neighbour = tile + dir;
+		if (!gen->map->isInTheMap(neighbour))
+			continue;
+		if (!(gen->isPossible(neighbour) || gen->shouldBeBlocked(neighbour) || (!needsGuard && gen->isFree(neighbour))))
+			return false; //all present tiles must be already blocked or ready for new objects
+	}
+	return true;
+}
+
+bool CRmgTemplateZone::canObstacleBePlacedHere(CMapGenerator* gen, const std::vector<int3> &blockedOffsets, const int3 &pos) const
 {
 	if (!gen->map->isInTheMap(pos)) //blockmap may fit in the map, but botom-right corner does not
 		return false;
 
-	auto tilesBlockedByObject = temp.getBlockedOffsets();
-
-	for (auto blockingTile : tilesBlockedByObject)
+	for (auto blockingTile : blockedOffsets)
 	{
 		int3 t = pos + blockingTile;
 		if (!gen->map->isInTheMap(t) || !(gen->isPossible(t) || gen->shouldBeBlocked(t)))
@@ -2040,16 +2063,12 @@ bool CRmgTemplateZone::findPlaceForObject(CMapGenerator* gen, CGObjectInstance*
 
 	for (auto tile : tileinfo)
 	{
-		//object must be accessible from at least one surounding tile
-		if (!isAccessibleFromAnywhere(gen, obj->appearance, tile))
-			continue;
-
-		auto ti = gen->getTile(tile);
-		auto dist = ti.getNearestObjectDistance();
+		auto dist = gen->getNearestObjectDistance(tile);
 		//avoid borders
 		if (gen->isPossible(tile) && (dist >= min_dist) && (dist > best_distance))
 		{
-			if (areAllTilesAvailable(gen, obj, tile, tilesBlockedByObject))
+			//object must be accessible from at least one surounding tile
+			if (isAccessibleFromAnywhere(gen, obj->appearance, tile) && areAllTilesAvailable(gen, obj, tile, tilesBlockedByObject))
 			{
 				best_distance = dist;
 				pos = tile;
@@ -2094,18 +2113,8 @@ void CRmgTemplateZone::checkAndPlaceObject(CMapGenerator* gen, CGObjectInstance*
 void CRmgTemplateZone::placeObject(CMapGenerator* gen, CGObjectInstance* object, const int3 &pos, bool updateDistance)
 {
 	checkAndPlaceObject (gen, object, pos);
+	occupyObjectTiles(gen, object, pos);
 
-	auto points = object->getBlockedPos();
-	if (object->isVisitable())
-		points.insert(pos + object->getVisitableOffset());
-	points.insert(pos);
-	for(auto p : points)
-	{
-		if (gen->map->isInTheMap(p))
-		{
-			gen->setOccupied(p, ETileType::USED);
-		}
-	}
 	if (updateDistance)
 		updateDistances(gen, pos);
 
@@ -2127,13 +2136,62 @@ void CRmgTemplateZone::placeObject(CMapGenerator* gen, CGObjectInstance* object,
 	}
 }
 
+void CRmgTemplateZone::occupyObjectTiles(CMapGenerator* gen, const CGObjectInstance* object, const int3 &pos)
+{
+	auto points = object->getBlockedPos();
+	if (object->isVisitable())
+		points.insert(pos + object->getVisitableOffset());
+	points.insert(pos);
+	for(auto p : points)
+	{
+		if (gen->map->isInTheMap(p))
+		{
+			gen->setOccupied(p, ETileType::USED);
+		}
+	}
+}
+
 void CRmgTemplateZone::updateDistances(CMapGenerator* gen, const int3 & pos)
 {
-	for (auto tile : possibleTiles) //don't need to mark distance for not possible tiles
+	if (possibleTilesByDistance.empty()) //don't need to mark distance for not possible tiles
+		return;
+
+	std::vector<std::pair<int3, float>> changed;
+	auto checkTile = [gen, &pos, &changed](const int3 & tile)
 	{
 		ui32 d = pos.dist2dSQ(tile); //optimization, only relative distance is interesting
-		gen->setNearestObjectDistance(tile, std::min<float>(d, gen->getNearestObjectDistance(tile)));
+		if (static_cast<float>(d) < gen->getNearestObjectDistance(tile))
+			changed.push_back(std::make_pair(tile, static_cast<float>(d)));
+	};
+
+	//distances only decrease, tiles further than the greatest distance so far can't change
+	const double radius = std::sqrt(possibleTilesByDistance.begin()->first) + 1;
+	if ((2 * radius + 1) * (2 * radius + 1) < possibleTiles.size())
+	{
+		const int r = static_cast<int>(radius);
+		possibleTiles.forEachInRect(pos.x - r, pos.y - r, pos.x + r, pos.y + r, checkTile);
 	}
+	else
+		boost::for_each(possibleTiles, checkTile);
+
+	for (auto & tile : changed)
+	{
+		possibleTilesByDistance.erase(std::make_pair(gen->getNearestObjectDistance(tile.first), tile.first));
+		gen->setNearestObjectDistance(tile.first, tile.second);
+		possibleTilesByDistance.insert(std::make_pair(tile.second, tile.first));
+	}
+}
+
+void CRmgTemplateZone::addPossibleTile(CMapGenerator* gen, const int3 &tile)
+{
+	if (possibleTiles.insert(tile))
+		possibleTilesByDistance.insert(std::make_pair(gen->getNearestObjectDistance(tile), tile));
+}
+
+void CRmgTemplateZone::removePossibleTile(CMapGenerator* gen, const int3 &tile)
+{
+	if (possibleTiles.erase(tile))
+		possibleTilesByDistance.erase(std::make_pair(gen->getNearestObjectDistance(tile), tile));
 }
 
 void CRmgTemplateZone::placeAndGuardObject(CMapGenerator* gen, CGObjectInstance* object, const int3 &pos, si32 str, bool zoneGuard)
@@ -16,6 +16,7 @@
 #include "../int3.h"
 #include "../ResourceSet.h" //for TResource (?)
 #include "../mapObjects/ObjectTemplate.h"
+#include "CTileSet.h"
 #include <boost/heap/priority_queue.hpp> //A*
 
 class CMapGenerator;
@@ -165,7 +166,7 @@ public:
 	void addTile (const int3 &pos);
 	void initFreeTiles (CMapGenerator* gen);
 	std::set<int3> getTileInfo() const;
-	std::set<int3> getPossibleTiles() const;
+	const CTileSet & getPossibleTiles() const;
 	void discardDistantTiles (CMapGenerator* gen, float distance);
 	void clearTiles();
 
@@ -187,7 +188,8 @@ public:
 	bool createRequiredObjects(CMapGenerator* gen);
 	void createTreasures(CMapGenerator* gen);
 	void createObstacles1(CMapGenerator* gen);
-	void createObstacles2(CMapGenerator* gen);
+	void createObstacles2(CMapGenerator* gen); //only chooses obstacles and marks their tiles, safe to run concurrently for independent zones
+	void placeObstacles(CMapGenerator* gen); //inserts obstacles chosen by createObstacles2 into map
 	bool crunchPath(CMapGenerator* gen, const int3 &src, const int3 &dst, bool onlyStraight, std::set<int3>* clearedTiles = nullptr);
 	bool connectPath(CMapGenerator* gen, const int3& src, bool onlyStraight);
 	bool connectWithCenter(CMapGenerator* gen, const int3& src, bool onlyStraight);
@@ -210,7 +212,9 @@ public:
 	bool guardObject(CMapGenerator* gen, CGObjectInstance* object, si32 str, bool zoneGuard = false, bool addToFreePaths = false);
 	void placeAndGuardObject(CMapGenerator* gen, CGObjectInstance* object, const int3 &pos, si32 str, bool zoneGuard = false);
 	void addRoadNode(const int3 & node);
-	void connectRoads(CMapGenerator * gen); //fills "roads" according to "roadNodes"
+	void connectRoads(CMapGenerator * gen); //fills "roads" according to "roadNodes", safe to run concurrently for independent zones
+	void drawRoads(CMapGenerator * gen); //actually updates tiles
+	void setRandomSeed(int seed); //seeds zone's own random stream used by work which may run concurrently
 
 	//A* priority queue
 	typedef std::pair<int3, float> TDistance;
@@ -255,7 +259,16 @@ private:
 	int3 pos;
 	float3 center;
 	std::set<int3> tileinfo; //irregular area assined to zone
-	std::set<int3> possibleTiles; //optimization purposes for treasure generation
+	CTileSet possibleTiles; //optimization purposes for treasure generation
+
+	struct DistanceOrder //greatest distance first, equal distances in tile order
+	{
+		bool operator()(const std::pair<float, int3> & lhs, const std::pair<float, int3> & rhs) const
+		{
+			return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+		}
+	};
+	std::set<std::pair<float, int3>, DistanceOrder> possibleTilesByDistance; //possibleTiles indexed by distance to nearest object
 	std::vector<TRmgTemplateZoneId> connections; //list of adjacent zones
 	std::set<int3> freePaths; //core paths of free tiles that all other objects will be linked to
 
@@ -263,14 +276,21 @@ private:
 	std::set<int3> roads; //all tiles with roads
 	std::set<int3> tilesToConnectLater; //will be connected after paths are fractalized
 
+	std::vector<CGObjectInstance*> plannedObstacles; //created by createObstacles2, not yet inserted into map
+
+	CRandomGenerator rand;
+
 	bool createRoad(CMapGenerator* gen, const int3 &src, const int3 &dst);
-	void drawRoads(CMapGenerator * gen); //actually updates tiles
 
 	bool pointIsIn(int x, int y);
 	void addAllPossibleObjects (CMapGenerator* gen); //add objects, including zone-specific, to possibleObjects
 	bool findPlaceForObject(CMapGenerator* gen, CGObjectInstance* obj, si32 min_dist, int3 &pos);
 	bool findPlaceForTreasurePile(CMapGenerator* gen, float min_dist, int3 &pos, int value);
-	bool canObstacleBePlacedHere(CMapGenerator* gen, ObjectTemplate &temp, int3 &pos);
+	bool canObstacleBePlacedHere(CMapGenerator* gen, const std::vector<int3> &blockedOffsets, const int3 &pos) const;
+	bool canTreasurePileBePlacedHere(CMapGenerator* gen, const int3 &tile, bool needsGuard) const;
+	void addPossibleTile(CMapGenerator* gen, const int3 &tile);
+	void removePossibleTile(CMapGenerator* gen, const int3 &tile);
 	void setTemplateForObject(CMapGenerator* gen, CGObjectInstance* obj);
 	void checkAndPlaceObject(CMapGenerator* gen, CGObjectInstance* object, const int3 &pos);
+	void occupyObjectTiles(CMapGenerator* gen, const CGObjectInstance* object, const int3 &pos); //marks blocked and visitable tiles as used
 };
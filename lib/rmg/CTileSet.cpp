@@ -0,0 +1,92 @@
+/*
+ * CTileSet.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "CTileSet.h"
+
+CTileSet::CTileSet()
+	: sizes(0, 0, 0), count(0)
+{
+}
+
+CTileSet::CTileSet(const int3 & sizes)
+	: CTileSet()
+{
+	resize(sizes);
+}
+
+void CTileSet::resize(const int3 & newSizes)
+{
+	sizes = newSizes;
+	count = 0;
+	words.assign((getCapacity() + WORD_BITS - 1) / WORD_BITS, 0);
+}
+
+bool CTileSet::insert(const int3 & tile)
+{
+	if(!isInside(tile))
+		return false;
+
+	const size_t index = getIndex(tile);
+	TWord & word = words[index / WORD_BITS];
+	const TWord bit = TWord(1) << (index % WORD_BITS);
+	if(word & bit)
+		return false;
+
+	word |= bit;
+	count++;
+	return true;
+}
+
+bool CTileSet::erase(const int3 & tile)
+{
+	if(!isInside(tile))
+		return false;
+
+	const size_t index = getIndex(tile);
+	TWord & word = words[index / WORD_BITS];
+	const TWord bit = TWord(1) << (index % WORD_BITS);
+	if(!(word & bit))
+		return false;
+
+	word &= ~bit;
+	count--;
+	return true;
+}
+
+void CTileSet::clear()
+{
+	boost::fill(words, 0);
+	count = 0;
+}
+
+size_t CTileSet::findNext(size_t index) const
+{
+	const size_t capacity = getCapacity();
+	if(index >= capacity)
+		return capacity;
+
+	size_t word = index / WORD_BITS;
+	TWord bits = words[word] & (~TWord(0) << (index % WORD_BITS));
+	while(!bits)
+	{
+		if(++word >= words.size())
+			return capacity;
+		bits = words[word];
+	}
+
+#ifdef _MSC_VER
+	unsigned long bit;
+	_BitScanForward64(&bit, bits);
+#else
+	const int bit = __builtin_ctzll(bits);
+#endif
+	return word * WORD_BITS + bit;
+}
@@ -0,0 +1,152 @@
+/*
+ * CTileSet.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#pragma once
+
+#include "../int3.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// Set of map tiles stored as a dense bitset over the whole map.
+/// Iterates in the same order as std::set<int3> (z, then y, then x).
+class DLL_LINKAGE CTileSet
+{
+public:
+	class const_iterator
+	{
+	public:
+		typedef std::input_iterator_tag iterator_category;
+		typedef int3 value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const int3 * pointer;
+		typedef int3 reference;
+
+		const_iterator() : owner(nullptr), index(0) {}
+		const_iterator(const CTileSet * owner, size_t index) : owner(owner), index(index) {}
+
+		int3 operator*() const { return owner->getTilePos(index); }
+		const_iterator & operator++()
+		{
+			index = owner->findNext(index + 1);
+			return *this;
+		}
+		const_iterator operator++(int)
+		{
+			const_iterator ret = *this;
+			++(*this);
+			return ret;
+		}
+		bool operator==(const const_iterator & other) const { return index == other.index; }
+		bool operator!=(const const_iterator & other) const { return index != other.index; }
+
+	private:
+		const CTileSet * owner;
+		size_t index;
+	};
+	typedef const_iterator iterator;
+
+	CTileSet();
+	/// Sizes are map width, height and number of levels
+	explicit CTileSet(const int3 & sizes);
+
+	/// Removes all tiles and sets dimensions of the map
+	void resize(const int3 & sizes);
+	const int3 & getSizes() const { return sizes; }
+
+	bool contains(const int3 & tile) const
+	{
+		return isInside(tile) && testBit(getIndex(tile));
+	}
+	/// Returns true if tile was not present before
+	bool insert(const int3 & tile);
+	/// Returns true if tile was present before
+	bool erase(const int3 & tile);
+	void clear();
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	const_iterator begin() const { return const_iterator(this, findNext(0)); }
+	const_iterator end() const { return const_iterator(this, getCapacity()); }
+
+	/// Calls f(int3) for all tiles within rectangle (inclusive, clipped to map) on all levels
+	template<typename Func>
+	void forEachInRect(int x1, int y1, int x2, int y2, Func f) const
+	{
+		x1 = std::max(x1, 0);
+		y1 = std::max(y1, 0);
+		x2 = std::min(x2, sizes.x - 1);
+		y2 = std::min(y2, sizes.y - 1);
+		for(int z = 0; z < sizes.z; z++)
+		{
+			for(int y = y1; y <= y2; y++)
+			{
+				for(int x = x1; x <= x2; x++)
+				{
+					const int3 tile(x, y, z);
+					if(testBit(getIndex(tile)))
+						f(tile);
+				}
+			}
+		}
+	}
+
+	/// Removes all tiles matching predicate
+	template<typename Pred>
+	void eraseIf(Pred pred)
+	{
+		for(size_t index = findNext(0); index < getCapacity(); index = findNext(index + 1))
+		{
+			if(pred(getTilePos(index)))
+			{
+				words[index / WORD_BITS] &= ~(TWord(1) << (index % WORD_BITS));
+				count--;
+			}
+		}
+	}
+
+private:
+	typedef ui64 TWord;
+	static const size_t WORD_BITS = 64;
+
+	int3 sizes;
+	size_t count;
+	std::vector<TWord> words;
+
+	size_t getCapacity() const
+	{
+		return static_cast<size_t>(sizes.x) * sizes.y * sizes.z;
+	}
+
+	bool isInside(const int3 & tile) const
+	{
+		return tile.x >= 0 && tile.y >= 0 && tile.z >= 0 && tile.x < sizes.x && tile.y < sizes.y && tile.z < sizes.z;
+	}
+
+	size_t getIndex(const int3 & tile) const
+	{
+		return (static_cast<size_t>(tile.z) * sizes.y + tile.y) * sizes.x + tile.x;
+	}
+
+	int3 getTilePos(size_t index) const
+	{
+		return int3(index % sizes.x, (index / sizes.x) % sizes.y, index / (static_cast<size_t>(sizes.x) * sizes.y));
+	}
+
+	bool testBit(size_t index) const
+	{
+		return (words[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+	}
+
+	/// Index of first tile at or after given index, capacity if none
+	size_t findNext(size_t index) const;
+};
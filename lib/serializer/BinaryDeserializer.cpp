@@ -9,6 +9,8 @@
  */
 #include "StdInc.h"
 #include "BinaryDeserializer.h"
+
+#include "CompressedSave.h"
 #include "../filesystem/FileStream.h"
 
 #include "../registerTypes/RegisterTypes.h"
@@ -28,7 +30,10 @@ CLoadFile::~CLoadFile()
 
 int CLoadFile::read(void * data, unsigned size)
 {
-	sfile->read((char*)data,size);
+	if(compressed)
+		compressed->read(data, size);
+	else
+		sfile->read((char*)data,size);
 	return size;
 }
 
@@ -49,6 +54,11 @@ void CLoadFile::openNextFile(const boost::filesystem::path & fname, int minimalV
 		//we can read
 		char buffer[4];
 		sfile->read(buffer, 4);
+		if(!std::memcmp(buffer, CompressedSave::MAGIC.c_str(), 4))
+		{
+			compressed = make_unique<CCompressedSaveReader>(*sfile);
+			read(buffer, 4);
+		}
 		if(std::memcmp(buffer,"VCMI",4))
 			THROW_FORMAT("Error: not a VCMI file(%s)!", fName);
 
@@ -83,12 +93,15 @@ void CLoadFile::openNextFile(const boost::filesystem::path & fname, int minimalV
 void CLoadFile::reportState(vstd::CLoggerBase * out)
 {
 	out->debug("CLoadFile");
-	if(!!sfile && *sfile)
+	if(compressed)
+		out->debug("\tOpened %s Position: %d (compressed)", fName, compressed->tell());
+	else if(!!sfile && *sfile)
 		out->debug("\tOpened %s Position: %d", fName, sfile->tellg());
 }
 
 void CLoadFile::clear()
 {
+	compressed = nullptr;
 	sfile = nullptr;
 	fName.clear();
 	serializer.fileVersion = 0;
@@ -16,6 +16,7 @@
 
 class CStackInstance;
 class FileStream;
+class CCompressedSaveReader;
 
 class DLL_LINKAGE CLoaderBase
 {
@@ -515,6 +516,7 @@ public:
 
 	std::string fName;
 	std::unique_ptr<FileStream> sfile;
+	std::unique_ptr<CCompressedSaveReader> compressed; //set if file is compressed save container
 
 	CLoadFile(const boost::filesystem::path & fname, int minimalVersion = SERIALIZATION_VERSION); //throws!
 	~CLoadFile();
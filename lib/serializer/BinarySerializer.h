@@ -363,6 +363,7 @@ public:
 	void reportState(vstd::CLoggerBase * out) override;
 
 	void putMagicBytes(const std::string &text);
+	void startSection() {} //flat file has no sections
 
 	template<class T>
 	CSaveFile & operator<<(const T &t)
@@ -0,0 +1,105 @@
+/*
+ * CSaveBuffer.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CSaveBuffer.h"
+
+#include "CompressedSave.h"
+#include "../CThreadHelper.h"
+#include "../filesystem/FileStream.h"
+#include "../registerTypes/RegisterTypes.h"
+
+extern template void registerTypes<BinarySerializer>(BinarySerializer & s);
+
+CSaveBuffer::CSaveBuffer()
+	: serializer(this)
+{
+	registerTypes(serializer);
+	write("VCMI", 4); //magic identifier, same as CSaveFile, compressed container has its own
+	serializer & SERIALIZATION_VERSION;
+}
+
+int CSaveBuffer::write(const void * data, unsigned size)
+{
+	auto bytes = static_cast<const ui8 *>(data);
+	buffer.insert(buffer.end(), bytes, bytes + size);
+	return size;
+}
+
+void CSaveBuffer::reportState(vstd::CLoggerBase * out)
+{
+	out->debug("CSaveBuffer");
+	out->debug("\tSize: %d", buffer.size());
+}
+
+void CSaveBuffer::putMagicBytes(const std::string &text)
+{
+	write(text.c_str(), text.length());
+}
+
+void CSaveBuffer::startSection()
+{
+	sectionStarts.push_back(buffer.size());
+}
+
+void CSaveBuffer::writeToFile(const boost::filesystem::path &fname) const
+{
+	boost::filesystem::path tempName = fname;
+	tempName += ".tmp";
+
+	{
+		FileStream file(tempName, std::ios::out | std::ios::binary);
+		if(!file)
+			THROW_FORMAT("Error: cannot open to write %s!", tempName);
+
+		CompressedSave::write(file, buffer, sectionStarts);
+		file.flush();
+		if(!file)
+			THROW_FORMAT("Error: failed to write %s!", tempName);
+	}
+	boost::filesystem::rename(tempName, fname);
+}
+
+CBackgroundSaveWriter::~CBackgroundSaveWriter()
+{
+	wait();
+}
+
+void CBackgroundSaveWriter::write(std::unique_ptr<CSaveBuffer> save, const boost::filesystem::path &fname, const TFailureHandler &onFailure)
+{
+	wait();
+
+	std::shared_ptr<CSaveBuffer> data(std::move(save));
+	thread = make_unique<boost::thread>([data, fname, onFailure]()
+	{
+		setThreadName("CBackgroundSaveWriter::write");
+		try
+		{
+			auto start = std::chrono::steady_clock::now();
+			data->writeToFile(fname);
+			auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+			logGlobal->info("Compressed and written %d bytes to %s in %d ms", data->buffer.size(), fname.string(), duration.count());
+		}
+		catch(std::exception &e)
+		{
+			logGlobal->error("Failed to write %s: %s", fname.string(), e.what());
+			if(onFailure)
+				onFailure(e.what());
+		}
+	});
+}
+
+void CBackgroundSaveWriter::wait()
+{
+	if(thread)
+	{
+		thread->join();
+		thread.reset();
+	}
+}
@@ -0,0 +1,58 @@
+/*
+ * CSaveBuffer.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "BinarySerializer.h"
+
+/// Serializes savegame into memory, so compressing and writing it can happen later on another thread
+class DLL_LINKAGE CSaveBuffer : public IBinaryWriter
+{
+public:
+	BinarySerializer serializer;
+	std::vector<ui8> buffer;
+	std::vector<size_t> sectionStarts;
+
+	CSaveBuffer();
+	int write(const void * data, unsigned size) override;
+	void reportState(vstd::CLoggerBase * out) override;
+
+	void putMagicBytes(const std::string &text);
+	/// Following data are compressed separately from preceding ones
+	void startSection();
+
+	/// Writes buffer as compressed save container (see CompressedSave.h) to temporary file and renames it to fname,
+	/// so fname is never left half-written. throws!
+	void writeToFile(const boost::filesystem::path &fname) const;
+
+	template<class T>
+	CSaveBuffer & operator<<(const T &t)
+	{
+		serializer & t;
+		return * this;
+	}
+};
+
+/// Writes serialized saves to disk on background thread, one at a time
+class DLL_LINKAGE CBackgroundSaveWriter
+{
+public:
+	/// Receives description of error, called on writer thread
+	typedef std::function<void(const std::string &)> TFailureHandler;
+
+	~CBackgroundSaveWriter(); //waits for pending write
+
+	/// Starts writing save to fname, waits for previous write first. onFailure is called if save could not be written
+	void write(std::unique_ptr<CSaveBuffer> save, const boost::filesystem::path &fname, const TFailureHandler &onFailure = TFailureHandler());
+	/// Blocks until pending write is finished
+	void wait();
+
+private:
+	std::unique_ptr<boost::thread> thread;
+};
@@ -0,0 +1,194 @@
+/*
+ * CompressedSave.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CompressedSave.h"
+
+#include "../CThreadHelper.h"
+
+#include <zlib.h>
+
+namespace
+{
+	void decompress(const std::vector<ui8> & compressed, std::vector<ui8> & raw, ui32 rawSize)
+	{
+		raw.resize(rawSize);
+		uLongf size = rawSize;
+		if(uncompress(raw.data(), &size, compressed.data(), compressed.size()) != Z_OK || size != rawSize)
+			throw std::runtime_error("Corrupted savegame chunk!");
+	}
+
+	void readOrThrow(std::istream & in, void * data, size_t size)
+	{
+		in.read(static_cast<char *>(data), size);
+		if(!in)
+			throw std::runtime_error("Savegame is truncated!");
+	}
+
+	/// Index values are stored as little endian ui32 regardless of platform
+	void writeUInt32(std::ostream & out, ui32 value)
+	{
+		const ui8 bytes[4] = {static_cast<ui8>(value), static_cast<ui8>(value >> 8), static_cast<ui8>(value >> 16), static_cast<ui8>(value >> 24)};
+		out.write(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+	}
+
+	ui32 readUInt32(std::istream & in)
+	{
+		ui8 bytes[4];
+		readOrThrow(in, bytes, sizeof(bytes));
+		return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<ui32>(bytes[3]) << 24;
+	}
+
+	/// Number of bytes between current position and end of stream
+	ui64 remainingSize(std::istream & in)
+	{
+		const auto position = in.tellg();
+		in.seekg(0, std::ios::end);
+		const auto end = in.tellg();
+		in.seekg(position);
+		if(position < 0 || end < position || !in)
+			throw std::runtime_error("Cannot determine size of savegame!");
+		return static_cast<ui64>(end - position);
+	}
+}
+
+void CompressedSave::write(std::ostream & out, const std::vector<ui8> & data, std::vector<size_t> sectionStarts)
+{
+	sectionStarts.push_back(data.size());
+	boost::sort(sectionStarts);
+
+	std::vector<std::pair<size_t, size_t>> ranges; //offset, size
+	size_t offset = 0;
+	for(size_t sectionEnd : sectionStarts)
+	{
+		sectionEnd = std::min(sectionEnd, data.size());
+		while(offset < sectionEnd)
+		{
+			const size_t size = std::min(sectionEnd - offset, MAX_CHUNK_SIZE);
+			ranges.push_back(std::make_pair(offset, size));
+			offset += size;
+		}
+	}
+
+	std::vector<std::vector<ui8>> compressed(ranges.size());
+	std::vector<Task> tasks;
+	for(size_t i = 0; i < ranges.size(); i++)
+	{
+		tasks.push_back([&, i]()
+		{
+			uLongf size = compressBound(ranges[i].second);
+			compressed[i].resize(size);
+			if(compress2(compressed[i].data(), &size, data.data() + ranges[i].first, ranges[i].second, Z_DEFAULT_COMPRESSION) != Z_OK)
+				throw std::runtime_error("Failed to compress savegame chunk!");
+			compressed[i].resize(size);
+		});
+	}
+	CThreadHelper::runParallel(tasks);
+
+	out.write(MAGIC.c_str(), MAGIC.size());
+	writeUInt32(out, ranges.size());
+	for(size_t i = 0; i < ranges.size(); i++)
+	{
+		writeUInt32(out, compressed[i].size());
+		writeUInt32(out, ranges[i].second);
+	}
+	for(auto & chunk : compressed)
+		out.write(reinterpret_cast<const char *>(chunk.data()), chunk.size());
+}
+
+CCompressedSaveReader::CCompressedSaveReader(std::istream & in)
+	: in(in), current(0), position(0), consumed(0)
+{
+	//index and chunk sizes come from disk, they are checked against file size before anything is allocated
+	ui64 remaining = remainingSize(in);
+	const ui32 count = readUInt32(in);
+	remaining -= sizeof(count);
+
+	const ui64 indexSize = static_cast<ui64>(count) * sizeof(ui32) * 2;
+	if(indexSize > remaining)
+		throw std::runtime_error("Corrupted savegame index!");
+	remaining -= indexSize;
+
+	chunks.resize(count);
+	ui64 compressedTotal = 0;
+	for(auto & chunk : chunks)
+	{
+		chunk.compressedSize = readUInt32(in);
+		chunk.rawSize = readUInt32(in);
+		chunk.loaded = false;
+
+		compressedTotal += chunk.compressedSize;
+		if(chunk.rawSize > CompressedSave::MAX_CHUNK_SIZE || compressedTotal > remaining)
+			throw std::runtime_error("Corrupted savegame index!");
+	}
+}
+
+void CCompressedSaveReader::read(void * data, unsigned size)
+{
+	auto out = static_cast<ui8 *>(data);
+	while(size)
+	{
+		if(current >= chunks.size())
+			throw std::runtime_error("Cannot read past the end of savegame!");
+
+		Chunk & chunk = chunks[current];
+		if(!chunk.loaded)
+		{
+			if(current == 0)
+			{
+				std::vector<ui8> compressed(chunk.compressedSize);
+				readOrThrow(in, compressed.data(), compressed.size());
+				decompress(compressed, chunk.raw, chunk.rawSize);
+				chunk.loaded = true;
+			}
+			else
+				loadRemainingChunks();
+		}
+
+		const size_t count = std::min<size_t>(size, chunk.raw.size() - position);
+		std::memcpy(out, chunk.raw.data() + position, count);
+		out += count;
+		size -= count;
+		position += count;
+
+		if(position == chunk.raw.size())
+		{
+			consumed += chunk.raw.size();
+			std::vector<ui8>().swap(chunk.raw); //release memory of read chunks
+			current++;
+			position = 0;
+		}
+	}
+}
+
+size_t CCompressedSaveReader::tell() const
+{
+	return consumed + position;
+}
+
+void CCompressedSaveReader::loadRemainingChunks()
+{
+	std::vector<std::vector<ui8>> compressed(chunks.size());
+	for(size_t i = current; i < chunks.size(); i++)
+	{
+		compressed[i].resize(chunks[i].compressedSize);
+		readOrThrow(in, compressed[i].data(), compressed[i].size());
+	}
+
+	std::vector<Task> tasks;
+	for(size_t i = current; i < chunks.size(); i++)
+	{
+		tasks.push_back([&, i]()
+		{
+			decompress(compressed[i], chunks[i].raw, chunks[i].rawSize);
+			chunks[i].loaded = true;
+		});
+	}
+	CThreadHelper::runParallel(tasks);
+}
@@ -0,0 +1,51 @@
+/*
+ * CompressedSave.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+/// Savegame container. Serialized stream is cut into chunks at section starts and every MAX_CHUNK_SIZE bytes,
+/// each chunk is compressed on its own. Layout: magic, chunk count, (compressed size, raw size) of every chunk, chunks.
+/// Count and sizes are little endian ui32, so saves can be moved between platforms.
+/// First section holds only map header and start options, so listing saves decompresses just the first chunk.
+namespace CompressedSave
+{
+	const std::string MAGIC = "VCMZ";
+	const size_t MAX_CHUNK_SIZE = 1 << 20;
+
+	/// Writes data as container, chunks are compressed in parallel. throws!
+	DLL_LINKAGE void write(std::ostream & out, const std::vector<ui8> & data, std::vector<size_t> sectionStarts);
+}
+
+/// Reads serialized stream back from container, stream must be positioned right after magic.
+/// Chunks are decompressed when reached, once first chunk is read all remaining chunks are decompressed in parallel
+class DLL_LINKAGE CCompressedSaveReader
+{
+public:
+	explicit CCompressedSaveReader(std::istream & in); //throws!
+
+	void read(void * data, unsigned size); //throws!
+	size_t tell() const; //position in decompressed stream
+
+private:
+	struct Chunk
+	{
+		ui32 compressedSize;
+		ui32 rawSize;
+		bool loaded;
+		std::vector<ui8> raw;
+	};
+
+	std::istream & in;
+	std::vector<Chunk> chunks;
+	size_t current; //chunk being read
+	size_t position; //position within current chunk
+	size_t consumed; //raw size of chunks before current one
+
+	void loadRemainingChunks();
+};
@@ -13,8 +13,10 @@
 #include "../registerTypes/RegisterTypes.h"
 #include "../mapping/CMap.h"
 #include "../CGameState.h"
+#include "../CConfigHandler.h"
 
 #include <boost/asio.hpp>
+#include <zlib.h>
 
 using namespace boost;
 using namespace boost::asio::ip;
@@ -29,6 +31,24 @@ using namespace boost::asio::ip;
 #define LIL_ENDIAN
 #endif
 
+static const size_t FRAME_HEADER_SIZE = 4; //payload size, little endian
+static const ui32 MAX_FRAME_SIZE = 1 << 30;
+static const ui32 COMPRESSED_FRAME_FLAG = 1u << 31; //payload starts with uncompressed size followed by zlib stream
+
+static void writeUInt32(ui8 * out, ui32 value)
+{
+	for(size_t i = 0; i < 4; i++)
+		out[i] = (value >> (8 * i)) & 0xff;
+}
+
+static ui32 readUInt32(const ui8 * in)
+{
+	ui32 value = 0;
+	for(size_t i = 0; i < 4; i++)
+		value |= ui32(in[i]) << (8 * i);
+	return value;
+}
+
 
 void CConnection::init()
 {
@@ -45,10 +65,21 @@ void CConnection::init()
 	myEndianess = false;
 #endif
 	connected = true;
+	frameStart = 0;
+	frameOpen = false;
+	batchDepth = 0;
+	inputPosition = 0;
+	compressionThreshold = 0;
 	std::string pom;
 	//we got connection
-	oser & std::string("Aiya!\n") & name & myEndianess; //identify ourselves
-	iser & pom & pom & contactEndianess;
+	const ui32 wantedCompression = std::max<si64>(settings["server"]["compressionThreshold"].Integer(), 0);
+	bool contactSupportsCompression = false;
+	oser & std::string("Aiya!\n") & name & myEndianess & (wantedCompression > 0); //identify ourselves
+	finishFrame();
+	iser & pom & pom & contactEndianess & contactSupportsCompression;
+	//peer can decompress our frames only if it knows about compression
+	if(contactSupportsCompression)
+		compressionThreshold = wantedCompression;
 	logNetwork->info("Established connection with %s", pom);
 	wmx = new boost::mutex();
 	rmx = new boost::mutex();
@@ -135,12 +166,36 @@ CConnection::CConnection(TAcceptor * acceptor, boost::asio::io_service *Io_servi
 	init();
 }
 int CConnection::write(const void * data, unsigned size)
+{
+	if(!frameOpen)
+	{
+		frameStart = outputBuffer.size();
+		outputBuffer.resize(frameStart + FRAME_HEADER_SIZE);
+		frameOpen = true;
+	}
+	const ui8 * bytes = static_cast<const ui8 *>(data);
+	outputBuffer.insert(outputBuffer.end(), bytes, bytes + size);
+	return size;
+}
+
+int CConnection::read(void * data, unsigned size)
 {
 	try
 	{
-		int ret;
-		ret = asio::write(*socket,asio::const_buffers_1(asio::const_buffer(data,size)));
-		return ret;
+		ui8 * bytes = static_cast<ui8 *>(data);
+		unsigned left = size;
+		while(left)
+		{
+			if(inputPosition == inputBuffer.size())
+				readFrame();
+
+			const unsigned chunk = std::min<size_t>(left, inputBuffer.size() - inputPosition);
+			std::copy_n(inputBuffer.begin() + inputPosition, chunk, bytes);
+			inputPosition += chunk;
+			bytes += chunk;
+			left -= chunk;
+		}
+		return size;
 	}
 	catch(...)
 	{
@@ -149,20 +204,189 @@ int CConnection::write(const void * data, unsigned size)
 		throw;
 	}
 }
-int CConnection::read(void * data, unsigned size)
+
+void CConnection::finishFrame()
 {
+	if(frameOpen)
+	{
+		const size_t payloadStart = frameStart + FRAME_HEADER_SIZE;
+		const ui32 payloadSize = outputBuffer.size() - payloadStart;
+		ui32 header = payloadSize;
+
+		sent.frames++;
+		sent.rawBytes += payloadSize;
+
+		if(compressionThreshold && payloadSize >= compressionThreshold)
+		{
+			uLongf compressedSize = compressBound(payloadSize);
+			compressedOutput.resize(4 + compressedSize);
+			writeUInt32(compressedOutput.data(), payloadSize);
+			//fastest level, most of the gain comes from long runs of zeroes and repeated ids
+			const int result = compress2(compressedOutput.data() + 4, &compressedSize, outputBuffer.data() + payloadStart, payloadSize, Z_BEST_SPEED);
+			if(result == Z_OK && 4 + compressedSize < payloadSize)
+			{
+				outputBuffer.resize(payloadStart);
+				outputBuffer.insert(outputBuffer.end(), compressedOutput.begin(), compressedOutput.begin() + 4 + compressedSize);
+				header = (4 + compressedSize) | COMPRESSED_FRAME_FLAG;
+				sent.compressedFrames++;
+			}
+		}
+
+		writeUInt32(outputBuffer.data() + frameStart, header);
+		sent.wireBytes += outputBuffer.size() - frameStart;
+		frameOpen = false;
+	}
+	if(!batchDepth)
+		flush();
+}
+
+void CConnection::flush()
+{
+	assert(!frameOpen);
+	if(outputBuffer.empty())
+		return;
+
 	try
 	{
-		int ret = asio::read(*socket,asio::mutable_buffers_1(asio::mutable_buffer(data,size)));
-		return ret;
+		asio::write(*socket, asio::buffer(outputBuffer));
+		outputBuffer.clear();
 	}
 	catch(...)
 	{
 		//connection has been lost
 		connected = false;
+		outputBuffer.clear();
 		throw;
 	}
 }
+
+void CConnection::readFrame()
+{
+	asio::read(*socket, asio::buffer(inputHeader, FRAME_HEADER_SIZE));
+
+	bool compressed;
+	const ui32 payloadSize = parseFrameHeader(compressed);
+	std::vector<ui8> & payload = compressed ? compressedInput : inputBuffer;
+	payload.resize(payloadSize);
+	if(payloadSize)
+		asio::read(*socket, asio::buffer(payload.data(), payloadSize));
+
+	decodeFrame(compressed);
+}
+
+void CConnection::asyncReadFrame(std::function<void(const boost::system::error_code &)> handler)
+{
+	assert(inputPosition == inputBuffer.size()); //previous frame must be fully deserialized
+
+	asio::async_read(*socket, asio::buffer(inputHeader, FRAME_HEADER_SIZE), [this, handler](const boost::system::error_code & headerError, size_t)
+	{
+		bool compressed = false;
+		ui32 payloadSize = 0;
+		boost::system::error_code error = headerError;
+		if(!error)
+		{
+			try
+			{
+				payloadSize = parseFrameHeader(compressed);
+			}
+			catch(std::exception & e)
+			{
+				logNetwork->error(e.what());
+				error = asio::error::invalid_argument;
+			}
+		}
+		if(error)
+		{
+			//connection has been lost
+			connected = false;
+			handler(error);
+			return;
+		}
+
+		std::vector<ui8> & payload = compressed ? compressedInput : inputBuffer;
+		payload.resize(payloadSize);
+		asio::async_read(*socket, asio::buffer(payload), [this, handler, compressed](const boost::system::error_code & payloadError, size_t)
+		{
+			boost::system::error_code error = payloadError;
+			if(!error)
+			{
+				try
+				{
+					decodeFrame(compressed);
+				}
+				catch(std::exception & e)
+				{
+					logNetwork->error(e.what());
+					error = asio::error::invalid_argument;
+				}
+			}
+			if(error)
+				connected = false;
+			handler(error);
+		});
+	});
+}
+
+ui32 CConnection::parseFrameHeader(bool & compressed) const
+{
+	compressed = readUInt32(inputHeader) & COMPRESSED_FRAME_FLAG;
+	const ui32 payloadSize = readUInt32(inputHeader) & ~COMPRESSED_FRAME_FLAG;
+	if(payloadSize > MAX_FRAME_SIZE || (compressed && payloadSize < 4))
+		throw std::runtime_error(boost::str(boost::format("Received frame of invalid size %d") % payloadSize));
+	return payloadSize;
+}
+
+void CConnection::decodeFrame(bool compressed)
+{
+	inputPosition = 0;
+	received.frames++;
+
+	if(!compressed)
+	{
+		received.wireBytes += FRAME_HEADER_SIZE + inputBuffer.size();
+		received.rawBytes += inputBuffer.size();
+		return;
+	}
+
+	const size_t payloadSize = compressedInput.size();
+	received.wireBytes += FRAME_HEADER_SIZE + payloadSize;
+
+	const ui32 rawSize = readUInt32(compressedInput.data());
+	if(rawSize > MAX_FRAME_SIZE)
+		throw std::runtime_error(boost::str(boost::format("Received compressed frame of invalid size %d") % rawSize));
+
+	inputBuffer.resize(rawSize);
+	uLongf decompressedSize = rawSize;
+	const int result = uncompress(inputBuffer.data(), &decompressedSize, compressedInput.data() + 4, payloadSize - 4);
+	if(result != Z_OK || decompressedSize != rawSize)
+		throw std::runtime_error(boost::str(boost::format("Failed to decompress network frame, zlib error %d") % result));
+
+	received.compressedFrames++;
+	received.rawBytes += rawSize;
+}
+
+CConnection::Batch::Batch(CConnection & connection)
+	: connection(connection)
+{
+	boost::unique_lock<boost::mutex> lock(*connection.wmx);
+	connection.batchDepth++;
+}
+
+CConnection::Batch::~Batch()
+{
+	boost::unique_lock<boost::mutex> lock(*connection.wmx);
+	if(--connection.batchDepth || !connection.isOpen())
+		return;
+
+	try
+	{
+		connection.flush();
+	}
+	catch(std::exception & e)
+	{
+		logNetwork->error("Failed to send batched packs to %s: %s", connection.name, e.what());
+	}
+}
 CConnection::~CConnection(void)
 {
 	if(handler)
@@ -212,6 +436,14 @@ void CConnection::reportState(vstd::CLoggerBase * out)
 		out->debug("\tWe have an open and valid socket");
 		out->debug("\t %d bytes awaiting", socket->available());
 	}
+	out->debug("\t %d bytes buffered for sending, %d received bytes not deserialized yet", outputBuffer.size(), inputBuffer.size() - inputPosition);
+	out->debug("\tCompression threshold: %d bytes (0 - disabled)", compressionThreshold);
+	out->debug("\tSent %d frames (%d compressed), %d bytes serialized, %d bytes on wire", sent.frames, sent.compressedFrames, sent.rawBytes, sent.wireBytes);
+	out->debug("\tReceived %d frames (%d compressed), %d bytes on wire, %d bytes deserialized", received.frames, received.compressedFrames, received.wireBytes, received.rawBytes);
+	if(batchDepth)
+	{
+		out->debug("\tBatch of depth %d is active", batchDepth);
+	}
 }
 
 CPack * CConnection::retreivePack()
@@ -229,6 +461,7 @@ void CConnection::sendPackToServer(const CPack &pack, PlayerColor player, ui32 r
 	boost::unique_lock<boost::mutex> lock(*wmx);
 	logNetwork->trace("Sending to server a pack of type %s", typeid(pack).name());
 	oser & player & requestID & &pack; //packs has to be sent as polymorphic pointers!
+	finishFrame();
 }
 
 void CConnection::disableStackSendingByID()
@@ -40,6 +40,8 @@ typedef boost::asio::basic_socket_acceptor<boost::asio::ip::tcp, boost::asio::so
 
 /// Main class for network communication
 /// Allows establishing connection and bidirectional read-write
+/// Every object written with operator<< is serialized into memory and sent as one length-prefixed frame,
+/// receiving side reads whole frames and deserializes them from memory
 class DLL_LINKAGE CConnection
 	: public IBinaryReader, public IBinaryWriter
 {
@@ -50,7 +52,49 @@ class DLL_LINKAGE CConnection
 
 	int write(const void * data, unsigned size) override;
 	int read(void * data, unsigned size) override;
+
+	/// Ends frame being written, sends all complete frames unless batch is active
+	void finishFrame();
+	/// Sends all complete frames with one socket write
+	void flush();
+	/// Reads next frame into input buffer
+	void readFrame();
+	/// Validates header of frame being received, returns payload size
+	ui32 parseFrameHeader(bool & compressed) const;
+	/// Moves received payload into input buffer, decompressing it if needed
+	void decodeFrame(bool compressed);
+
+	std::vector<ui8> outputBuffer; //complete frames waiting to be sent, followed by the frame being written
+	size_t frameStart; //offset of the header of frame being written
+	bool frameOpen;
+	int batchDepth;
+
+	ui8 inputHeader[4]; //header of frame being received
+	std::vector<ui8> inputBuffer; //payload of last received frame
+	size_t inputPosition;
+
+	/// Frames with payload of at least this size are compressed, 0 if compression was not negotiated
+	ui32 compressionThreshold;
+	/// Scratch buffers of compressed payloads. Sending and receiving may run on different threads, so each has its own
+	std::vector<ui8> compressedOutput, compressedInput;
+
+	/// Traffic statistics, "raw" is size of serialized data, "wire" is size sent over network including headers
+	struct TrafficStats
+	{
+		ui64 frames, compressedFrames, rawBytes, wireBytes;
+		TrafficStats() : frames(0), compressedFrames(0), rawBytes(0), wireBytes(0) {}
+	};
+	TrafficStats sent, received;
 public:
+	/// Frames written to connection during lifetime of batch are sent together when the batch ends
+	class DLL_LINKAGE Batch : public boost::noncopyable
+	{
+		CConnection & connection;
+	public:
+		explicit Batch(CConnection & connection);
+		~Batch();
+	};
+
 	BinaryDeserializer iser;
 	BinarySerializer oser;
 
@@ -77,6 +121,10 @@ public:
 	CConnection &operator&(const T&);
 	virtual ~CConnection(void);
 
+	/// Starts reading next frame without blocking, handler is called from io_service thread once whole frame is received.
+	/// Afterwards objects sent in that frame can be deserialized without waiting for network
+	void asyncReadFrame(std::function<void(const boost::system::error_code &)> handler);
+
 	CPack *retreivePack(); //gets from server next pack (allocates it with new)
 	void sendPackToServer(const CPack &pack, PlayerColor player, ui32 requestID);
 
@@ -103,6 +151,7 @@ public:
 	CConnection & operator<<(const T &t)
 	{
 		oser & t;
+		finishFrame();
 		return * this;
 	}
 };
@@ -9,6 +9,8 @@
  */
 #include "StdInc.h"
 
+#include <boost/asio.hpp>
+
 #include "../lib/filesystem/Filesystem.h"
 #include "../lib/filesystem/FileInfo.h"
 #include "../lib/int3.h"
@@ -42,6 +44,7 @@
 #include "../lib/registerTypes/RegisterTypes.h"
 #include "../lib/serializer/CTypeList.h"
 #include "../lib/serializer/Connection.h"
+#include "../lib/serializer/CSaveBuffer.h"
 
 #ifndef _MSC_VER
 #include <boost/thread/xtime.hpp>
@@ -508,7 +511,6 @@ void CGameHandler::changePrimSkill(const CGHeroInstance * hero, PrimarySkill::Pr
 			scp.which = SetCommanderProperty::EXPERIENCE;
 			scp.amount = val;
 			sendAndApply (&scp);
-			CBonusSystemNode::treeHasChanged();
 		}
 
 		expGiven(hero);
@@ -1015,114 +1017,140 @@ void CGameHandler::applyBattleEffects(BattleAttack &bat, const CStack *att, cons
 		bat.bsa.push_back(bsa2);
 	}
 }
-void CGameHandler::handleConnection(std::set<PlayerColor> players, CConnection &c)
+void CGameHandler::handleDisconnection(CConnection & c, const std::string & reason)
 {
-	setThreadName("CGameHandler::handleConnection");
-
-	auto handleDisconnection = [&](const std::exception & e)
+	boost::unique_lock<boost::mutex> lock(*c.wmx);
+	assert(!c.connected); //make sure that connection has been marked as broken
+	if(!vstd::contains(conns, &c))
+		return; //both sending and receiving may notice lost connection
+	logGlobal->error(reason);
+	conns -= &c;
+	for(auto playerConn : connections)
 	{
-		boost::unique_lock<boost::mutex> lock(*c.wmx);
-		assert(!c.connected); //make sure that connection has been marked as broken
-		logGlobal->error(e.what());
-		conns -= &c;
-		for(auto playerConn : connections)
+		if(!serverShuttingDown && playerConn.second == &c)
 		{
-			if(!serverShuttingDown && playerConn.second == &c)
-			{
-				PlayerCheated pc;
-				pc.player = playerConn.first;
-				pc.losingCheatCode = true;
-				sendAndApply(&pc);
-				checkVictoryLossConditionsForPlayer(playerConn.first);
-			}
+			PlayerCheated pc;
+			pc.player = playerConn.first;
+			pc.losingCheatCode = true;
+			sendAndApply(&pc);
+			checkVictoryLossConditionsForPlayer(playerConn.first);
 		}
-	};
+	}
+}
 
-	try
+void CGameHandler::listenToConnection(CConnection & c, const TApplyQueue & applyQueue)
+{
+	c.asyncReadFrame([this, &c, applyQueue](const boost::system::error_code & error)
 	{
-		while(1)//server should never shut connection first //was: while(!end2)
+		if(error || !c.connected)
 		{
-			CPack *pack = nullptr;
-			PlayerColor player = PlayerColor::NEUTRAL;
-			si32 requestID = -999;
-			int packType = 0;
+			c.connected = false;
+			const std::string reason = error ? error.message() : "connection has been closed";
+			applyQueue([this, &c, reason]()
+			{
+				handleDisconnection(c, reason);
+			});
+			return;
+		}
 
+		CPack *pack = nullptr;
+		PlayerColor player = PlayerColor::NEUTRAL;
+		si32 requestID = -999;
+		try
+		{
+			boost::unique_lock<boost::mutex> lock(*c.rmx);
+			c >> player >> requestID >> pack; //get the package
+		}
+		catch(std::exception & e)
+		{
+			c.connected = false;
+			const std::string reason = e.what();
+			applyQueue([this, &c, reason]()
 			{
-				boost::unique_lock<boost::mutex> lock(*c.rmx);
-				if(!c.connected)
-					throw clientDisconnectedException();
-				c >> player >> requestID >> pack; //get the package
+				handleDisconnection(c, reason);
+			});
+			return;
+		}
 
-				if (!pack)
-				{
-					logGlobal->error("Received a null package marked as request %d from player %d", requestID, player);
-				}
-				else
-				{
-					packType = typeList.getTypeID(pack); //get the id of type
+		//packs are applied one at a time in order of arrival, meanwhile we can already wait for next one
+		applyQueue([this, &c, player, requestID, pack]()
+		{
+			handlePack(c, player, requestID, pack);
+		});
+		listenToConnection(c, applyQueue);
+	});
+}
 
-					logGlobal->trace("Received client message (request %d by player %d (%s)) of type with ID=%d (%s).\n",
-									 requestID, player, player.getStr(), packType, typeid(*pack).name());
-				}
-			}
+void CGameHandler::handlePack(CConnection & c, PlayerColor player, si32 requestID, CPack * pack)
+{
+	int packType = 0;
+	if (!pack)
+	{
+		logGlobal->error("Received a null package marked as request %d from player %d", requestID, player);
+	}
+	else
+	{
+		packType = typeList.getTypeID(pack); //get the id of type
 
-			//prepare struct informing that action was applied
-			auto sendPackageResponse = [&](bool succesfullyApplied)
-			{
-				//dont reply to disconnected client
-				//TODO: this must be implemented as option of CPackForServer
-				if(dynamic_cast<LeaveGame *>(pack) || dynamic_cast<CloseServer *>(pack))
-					return;
+		logGlobal->trace("Received client message (request %d by player %d (%s)) of type with ID=%d (%s).\n",
+						 requestID, player, player.getStr(), packType, typeid(*pack).name());
+	}
 
-				PackageApplied applied;
-				applied.player = player;
-				applied.result = succesfullyApplied;
-				applied.packType = packType;
-				applied.requestID = requestID;
-				boost::unique_lock<boost::mutex> lock(*c.wmx);
-				c << &applied;
-			};
-			CBaseForGHApply *apply = applier->getApplier(packType); //and appropriate applier object
-			if(isBlockedByQueries(pack, player))
-			{
-				sendPackageResponse(false);
-			}
-			else if (apply)
-			{
-				const bool result = apply->applyOnGH(this, &c, pack, player);
-				if (result)
-					logGlobal->trace("Message %s successfully applied!", typeid(*pack).name());
-				else
-					complain((boost::format("Got false in applying %s... that request must have been fishy!")
-						% typeid(*pack).name()).str());
+	//prepare struct informing that action was applied
+	auto sendPackageResponse = [&](bool succesfullyApplied)
+	{
+		//dont reply to disconnected client
+		//TODO: this must be implemented as option of CPackForServer
+		if(dynamic_cast<LeaveGame *>(pack) || dynamic_cast<CloseServer *>(pack))
+			return;
 
-				sendPackageResponse(true);
-			}
+		PackageApplied applied;
+		applied.player = player;
+		applied.result = succesfullyApplied;
+		applied.packType = packType;
+		applied.requestID = requestID;
+		boost::unique_lock<boost::mutex> lock(*c.wmx);
+		c << &applied;
+	};
+
+	try
+	{
+		CBaseForGHApply *apply = applier->getApplier(packType); //and appropriate applier object
+		if(isBlockedByQueries(pack, player))
+		{
+			sendPackageResponse(false);
+		}
+		else if (apply)
+		{
+			const bool result = apply->applyOnGH(this, &c, pack, player);
+			if (result)
+				logGlobal->trace("Message %s successfully applied!", typeid(*pack).name());
 			else
-			{
-				logGlobal->error("Message cannot be applied, cannot find applier (unregistered type)!");
-				sendPackageResponse(false);
-			}
+				complain((boost::format("Got false in applying %s... that request must have been fishy!")
+					% typeid(*pack).name()).str());
 
-			vstd::clear_pointer(pack);
+			sendPackageResponse(true);
+		}
+		else
+		{
+			logGlobal->error("Message cannot be applied, cannot find applier (unregistered type)!");
+			sendPackageResponse(false);
 		}
 	}
-	catch(boost::system::system_error &e) //for boost errors just log, not crash - probably client shut down connection
-	{
-		handleDisconnection(e);
-	}
-	catch(clientDisconnectedException & e)
+	catch(boost::system::system_error & e) //for boost errors just log, not crash - probably client shut down connection
 	{
-		handleDisconnection(e);
+		c.connected = false;
+		handleDisconnection(c, e.what());
 	}
 	catch(...)
 	{
+		vstd::clear_pointer(pack);
 		serverShuttingDown = true;
 		handleException();
 		throw;
 	}
 
-	logGlobal->error("Ended handling connection");
+	vstd::clear_pointer(pack);
 }
 
 int CGameHandler::moveStack(int stack, BattleHex dest)
@@ -1400,6 +1428,7 @@ CGameHandler::CGameHandler(void)
 	visitObjectAfterVictory = false;
 
 	spellEnv = new ServerSpellCastEnvironment(this);
+	saveWriter = make_unique<CBackgroundSaveWriter>();
 }
 
 CGameHandler::~CGameHandler(void)
@@ -1480,6 +1509,12 @@ void CGameHandler::setPortalDwelling(const CGTownInstance * town, bool forced=fa
 void CGameHandler::newTurn()
 {
 	logGlobal->trace("Turn %d", gs->day+1);
+
+	//all packs of the new turn reach each client with one write
+	std::vector<std::unique_ptr<CConnection::Batch>> batches;
+	for(auto c : conns)
+		batches.push_back(make_unique<CConnection::Batch>(*c));
+
 	NewTurn n;
 	n.specialWeek = NewTurn::NO_ACTION;
 	n.creatureid = CreatureID::NONE;
@@ -1630,7 +1665,8 @@ void CGameHandler::newTurn()
 			hth.move = h->maxMovePoints(gs->map->getTile(h->getPosition(false)).terType != ETerrainType::WATER, ti.get());
 			hth.mana = h->getManaNewTurn();
 
-			n.heroes.insert(hth);
+			if (hth.move != h->movement || hth.mana != h->mana)
+				n.heroes.insert(hth);
 
 			if (!firstTurn) //not first day
 			{
@@ -1708,12 +1744,10 @@ void CGameHandler::newTurn()
 				fw.mode = 1;
 				fw.player = player;
 				// find all hidden tiles
-				const auto & fow = getPlayerTeam(player)->fogOfWarMap;
-				for (size_t i=0; i<fow.size(); i++)
-					for (size_t j=0; j<fow.at(i).size(); j++)
-						for (size_t k=0; k<fow.at(i).at(j).size(); k++)
-							if (!fow.at(i).at(j).at(k))
-								fw.tiles.insert(int3(i,j,k));
+				getPlayerTeam(player)->fogOfWarMap.forEachTile(false, [&fw](const int3 & tile)
+				{
+					fw.tiles.insert(tile);
+				});
 
 				sendAndApply (&fw);
 			}
@@ -1736,6 +1770,16 @@ void CGameHandler::newTurn()
 		pickAllowedArtsSet(saa.arts, getRandomGenerator());
 		sendAndApply(&saa);
 	}
+
+	//send only what actually changes
+	vstd::erase_if(n.res, [&](const std::pair<const PlayerColor, TResources> & playerRes)
+	{
+		return playerRes.second == getPlayer(playerRes.first)->resources;
+	});
+	vstd::erase_if(n.cres, [&](std::pair<const ObjectInstanceID, SetAvailableCreatures> & townCreatures)
+	{
+		return !townCreatures.second.encodeDelta(getTown(townCreatures.first));
+	});
 	sendAndApply(&n);
 
 	if (newWeek)
@@ -1837,15 +1881,23 @@ void CGameHandler::run(bool resume)
 		cc->disableSmartPointerSerialization();
 	}
 
-	for (auto & elem : conns)
+	//all connections are served by one network thread, packs are applied in order of arrival
+	boost::asio::io_service noConnectionsIo;
+	boost::asio::io_service & io = conns.empty() ? noConnectionsIo : *(*conns.begin())->io_service;
+	boost::asio::io_service::strand applyStrand(io);
+	applyQueue = [&applyStrand](const std::function<void()> & task)
 	{
-		std::set<PlayerColor> pom;
-		for (auto j = connections.cbegin(); j!=connections.cend();j++)
-			if (j->second == elem)
-				pom.insert(j->first);
+		applyStrand.post(task);
+	};
+	for (auto & elem : conns)
+		listenToConnection(*elem, applyQueue);
 
-		boost::thread(std::bind(&CGameHandler::handleConnection,this,pom,std::ref(*elem)));
-	}
+	io.reset();
+	boost::thread networkThread([&io]()
+	{
+		setThreadName("CGameHandler::network");
+		io.run();
+	});
 
 	auto playerTurnOrder = generatePlayerTurnOrder();
 
@@ -1908,8 +1960,29 @@ void CGameHandler::run(bool resume)
 		if (!activePlayer)
 			serverShuttingDown = true;
 	}
-	while(conns.size() && (*conns.begin())->isOpen())
-		boost::this_thread::sleep(boost::posix_time::milliseconds(5)); //give time client to close socket
+	//failure of pending save is reported through strand, which has to stay alive until then
+	saveWriter->wait();
+
+	//network thread ends once clients close their sockets, give them some time before closing remaining ones
+	const boost::chrono::milliseconds CLIENT_CLOSE_TIMEOUT(2000);
+	const bool networkFinished = networkThread.try_join_for(CLIENT_CLOSE_TIMEOUT);
+
+	//closing on the strand keeps disconnection handlers away from conns; pending reads finish with error
+	applyStrand.post([this]()
+	{
+		for(auto c : conns)
+		{
+			boost::unique_lock<boost::mutex> lock(*c->wmx);
+			c->close();
+		}
+	});
+	if(!networkFinished)
+		networkThread.join();
+
+	//network thread might have finished before closing task was posted, io_service is reused by server
+	io.reset();
+	io.poll();
+	applyQueue = nullptr;
 }
 
 std::list<PlayerColor> CGameHandler::generatePlayerTurnOrder() const
@@ -2635,6 +2708,14 @@ void CGameHandler::sendAndApply(NewStructures * info)
 	checkVictoryLossConditionsForPlayer(getTown(info->tid)->tempOwner);
 }
 
+void CGameHandler::sendAndApply(SetAvailableCreatures * info)
+{
+	auto dwelling = dynamic_cast<const CGDwelling *>(getObj(info->tid));
+	assert(dwelling);
+	info->encodeDelta(dwelling);
+	sendAndApply(static_cast<CPackForClient*>(info));
+}
+
 void CGameHandler::save(const std::string & filename)
 {
 	logGlobal->info("Saving to %s", filename);
@@ -2650,17 +2731,32 @@ void CGameHandler::save(const std::string & filename)
 
 	try
 	{
-		{
-			CSaveFile save(*CResourceHandler::get("local")->getResourceName(ResourceID(stem.to_string(), EResType::SERVER_SAVEGAME)));
-			saveCommonState(save);
-			logGlobal->info("Saving server state");
-			save << *this;
-		}
-		logGlobal->info("Game has been successfully saved!");
+		auto start = std::chrono::steady_clock::now();
+		auto save = make_unique<CSaveBuffer>();
+		saveCommonState(*save);
+		logGlobal->info("Saving server state");
+		*save << *this;
+
+		auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+		logGlobal->info("Game has been serialized in %d ms, writing it in background", duration.count());
+		//failure is reported from writer thread, message is sent from strand so it does not race with disconnections
+		const TApplyQueue queue = applyQueue;
+		saveWriter->write(std::move(save), *CResourceHandler::get("local")->getResourceName(ResourceID(stem.to_string(), EResType::SERVER_SAVEGAME)),
+			[this, filename, queue](const std::string & error)
+		{
+			const std::string message = "Failed to save game " + filename + ": " + error;
+			queue([this, message]()
+			{
+				SystemMessage sm(message);
+				sendToAllClients(&sm);
+			});
+		});
 	}
 	catch(std::exception &e)
 	{
 		logGlobal->error("Failed to save game: %s", e.what());
+		SystemMessage sm("Failed to save game " + filename + ": " + e.what());
+		sendToAllClients(&sm);
 	}
 }
 
@@ -2668,6 +2764,7 @@ void CGameHandler::close()
 {
 	logGlobal->info("We have been requested to close.");
 	serverShuttingDown = true;
+	saveWriter->wait();
 
 	for (auto & elem : conns)
 	{
@@ -3833,16 +3930,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 		{
 			//defensive stance
 			SetStackEffect sse;
-			Bonus bonus1(Bonus::STACK_GETS_TURN, Bonus::PRIMARY_SKILL, Bonus::OTHER, 20, -1, PrimarySkill::DEFENSE, Bonus::PERCENT_TO_ALL);
-			Bonus bonus2(Bonus::STACK_GETS_TURN, Bonus::PRIMARY_SKILL, Bonus::OTHER, stack->valOfBonuses(Bonus::DEFENSIVE_STANCE),
-				 -1, PrimarySkill::DEFENSE, Bonus::ADDITIVE_VALUE);
-			BonusList defence = *stack->getBonuses(Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::DEFENSE));
-			int oldDefenceValue = defence.totalValue();
-
-			defence.push_back(std::make_shared<Bonus>(bonus1));
-			defence.push_back(std::make_shared<Bonus>(bonus2));
-
-			int difference = defence.totalValue() - oldDefenceValue;
+			int difference = stack->getDefensiveStanceGain();
 
 			MetaString text;
 			stack->addText(text, MetaString::GENERAL_TXT, 120);
@@ -3851,8 +3939,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 
 			sse.battleLog.push_back(text);
 
-			sse.effect.push_back(bonus1);
-			sse.effect.push_back(bonus2);
+			sse.effect = stack->getDefensiveStanceBonuses();
 
 			sse.stacks.push_back(ba.stackNumber);
 			sendAndApply(&sse);
@@ -4308,7 +4395,7 @@ bool CGameHandler::makeBattleAction(BattleAction &ba)
 	if(ba.actionType == Battle::DAEMON_SUMMONING || ba.actionType == Battle::WAIT || ba.actionType == Battle::DEFEND
 			|| ba.actionType == Battle::SHOOT || ba.actionType == Battle::MONSTER_SPELL)
 		handleDamageFromObstacle(stack);
-	if(ba.stackNumber == gs->curB->activeStack || battleResult.get()) //active stack has moved or battle has finished
+	if(ba.stackNumber == gs->curB->activeStack || battleResult.get() || ba.actionType == Battle::END_TACTIC_PHASE) //active stack has moved, battle or tactic phase has finished
 		battleMadeAction.setn(true);
 	return ok;
 }
@@ -5167,6 +5254,20 @@ void CGameHandler::getVictoryLossMessage(PlayerColor player, const EVictoryLossC
 	out.components.push_back(Component(Component::FLAG, player.getNum(), 0, 0));
 }
 
+bool CGameHandler::resendAvailableCreatures(ObjectInstanceID dwellingId)
+{
+	auto dwelling = dynamic_cast<const CGDwelling *>(getObj(dwellingId));
+	if (!dwelling)
+		COMPLAIN_RET("Cannot resend creatures of object which is not a dwelling!");
+
+	SetAvailableCreatures sac;
+	sac.tid = dwellingId;
+	sac.creatures = dwelling->creatures;
+	sac.version = dwelling->creaturesVersion + 1;
+	sendAndApply(static_cast<CPackForClient*>(&sac));
+	return true;
+}
+
 bool CGameHandler::dig(const CGHeroInstance *h)
 {
 	for (auto i = gs->map->objects.cbegin(); i != gs->map->objects.cend(); i++) //unflag objs
@@ -5638,9 +5739,12 @@ void CGameHandler::runBattle()
 	//TODO: pre-tactic stuff, call scripts etc.
 
 	//tactic round
+	if (gs->curB->tacticDistance)
+		askTacticPhaseActions();
 	{
+		boost::unique_lock<boost::mutex> lock(battleMadeAction.mx);
 		while (gs->curB->tacticDistance && !battleResult.get())
-			boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+			battleMadeAction.cond.wait(lock);
 	}
 
 	//initial stacks appearance triggers, e.g. built-in bonus spells
@@ -5906,8 +6010,10 @@ void CGameHandler::runBattle()
 							return !next->alive();//active stack is dead
 						};
 
+						battleMadeAction.set(false);
+						askStackAction(next);
+
 						boost::unique_lock<boost::mutex> lock(battleMadeAction.mx);
-						battleMadeAction.data = false;
 						while (!actionWasMade())
 						{
 							battleMadeAction.cond.wait(lock);
@@ -6064,6 +6170,22 @@ void CGameHandler::setBattleResult(BattleResult::EResult resultType, int victori
 	battleResult.data = br;
 }
 
+std::unique_ptr<BattleResult> CGameHandler::takeBattleResult()
+{
+	boost::unique_lock<boost::mutex> guard(battleResult.mx);
+	std::unique_ptr<BattleResult> ret(battleResult.data);
+	battleResult.data = nullptr;
+	return ret;
+}
+
+void CGameHandler::askTacticPhaseActions()
+{
+}
+
+void CGameHandler::askStackAction(const CStack * stack)
+{
+}
+
 void CGameHandler::commitPackage(CPackForClient *pack)
 {
 	sendAndApply(pack);
@@ -6216,15 +6338,13 @@ void CGameHandler::handleCheatCode(std::string & cheat, PlayerColor player, cons
 		fc.mode = (cheat == "vcmieagles" ? 1 : 0);
 		fc.player = player;
 		const auto & fowMap = gs->getPlayerTeam(player)->fogOfWarMap;
-		auto hlp_tab = new int3[gs->map->width * gs->map->height * (gs->map->twoLevel ? 2 : 1)];
-		int lastUnc = 0;
-		for (int i = 0; i < gs->map->width; i++)
-			for (int j = 0; j < gs->map->height; j++)
-				for (int k = 0; k < (gs->map->twoLevel ? 2 : 1); k++)
-					if (!fowMap.at(i).at(j).at(k) || !fc.mode)
-						hlp_tab[lastUnc++] = int3(i, j, k);
-		fc.tiles.insert(hlp_tab, hlp_tab + lastUnc);
-		delete [] hlp_tab;
+		auto insertTile = [&fc](const int3 & tile)
+		{
+			fc.tiles.insert(tile);
+		};
+		fowMap.forEachTile(false, insertTile);
+		if(!fc.mode)
+			fowMap.forEachTile(true, insertTile);
 		sendAndApply(&fc);
 	}
 	else
@@ -6258,6 +6378,9 @@ bool CGameHandler::isBlockedByQueries(const CPack *pack, PlayerColor player)
 	if (!strcmp(typeid(*pack).name(), typeid(PlayerMessage).name()))
 		return false;
 
+	if (!strcmp(typeid(*pack).name(), typeid(RequestAvailableCreatures).name()))
+		return false;
+
 	auto query = queries.topQuery(player);
 	if (query && query->blocksPack(pack))
 	{
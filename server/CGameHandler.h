@@ -29,6 +29,7 @@ class CGHeroInstance;
 class IMarket;
 
 class SpellCastEnvironment;
+class CBackgroundSaveWriter;
 
 struct PlayerStatus
 {
@@ -90,6 +91,7 @@ public:
 	Queries queries;
 
 	SpellCastEnvironment * spellEnv;
+	std::unique_ptr<CBackgroundSaveWriter> saveWriter; //writes serialized saves to disk without blocking the game
 
 	bool isValidObject(const CGObjectInstance *obj) const;
 	bool isBlockedByQueries(const CPack *pack, PlayerColor player);
@@ -101,12 +103,13 @@ public:
 	////used only in endBattle - don't touch elsewhere
 	bool visitObjectAfterVictory;
 	//
-	void endBattle(int3 tile, const CGHeroInstance *hero1, const CGHeroInstance *hero2); //ends battle
+	virtual void endBattle(int3 tile, const CGHeroInstance *hero1, const CGHeroInstance *hero2); //ends battle
 	void prepareAttack(BattleAttack &bat, const CStack *att, const CStack *def, int distance, int targetHex); //distance - number of hexes travelled before attacking
 	void applyBattleEffects(BattleAttack &bat, const CStack *att, const CStack *def, int distance, bool secondary); //damage, drain life & fire shield
 	void checkBattleStateChanges();
 	void setupBattle(int3 tile, const CArmedInstance *armies[2], const CGHeroInstance *heroes[2], bool creatureBank, const CGTownInstance *town);
 	void setBattleResult(BattleResult::EResult resultType, int victoriusSide);
+	std::unique_ptr<BattleResult> takeBattleResult(); //removes result of finished battle, caller becomes its owner
 
 	CGameHandler(void);
 	~CGameHandler(void);
@@ -186,7 +189,13 @@ public:
 	void commitPackage(CPackForClient *pack) override;
 
 	void init(StartInfo *si);
-	void handleConnection(std::set<PlayerColor> players, CConnection &c);
+	/// Queues task to be run after all previously queued ones
+	typedef std::function<void(const std::function<void()> &)> TApplyQueue;
+	TApplyQueue applyQueue; //set while game runs, only tasks run through it may touch conns
+	/// Waits for packs from client without blocking, received packs are applied through the queue one at a time
+	void listenToConnection(CConnection & c, const TApplyQueue & applyQueue);
+	void handlePack(CConnection & c, PlayerColor player, si32 requestID, CPack * pack);
+	void handleDisconnection(CConnection & c, const std::string & reason);
 	PlayerColor getPlayerAt(CConnection *c) const;
 
 	void playerMessage(PlayerColor player, const std::string &message, ObjectInstanceID currObj);
@@ -231,6 +240,7 @@ public:
 	void objectVisitEnded(const CObjectVisitQuery &query);
 	void engageIntoBattle( PlayerColor player );
 	bool dig(const CGHeroInstance *h);
+	bool resendAvailableCreatures(ObjectInstanceID dwellingId); //sends full state of dwelling to clients which missed some update
 	void moveArmy(const CArmedInstance *src, const CArmedInstance *dst, bool allowMerging);
 
 	template <typename Handler> void serialize(Handler &h, const int version)
@@ -252,6 +262,7 @@ public:
 	void sendAndApply(CGarrisonOperationPack * info);
 	void sendAndApply(SetResources * info);
 	void sendAndApply(NewStructures * info);
+	void sendAndApply(SetAvailableCreatures * info); //sends only changed creature counts if possible
 
 	struct FinishingBattleHelper
 	{
@@ -294,6 +305,12 @@ public:
 
 	CRandomGenerator & getRandomGenerator();
 
+protected:
+	/// Called when tactic phase starts and when stack becomes active. Clients are asked for actions by BattleStart
+	/// and BattleSetActiveStack packs, so server does nothing here. In-process players may act right away
+	virtual void askTacticPhaseActions();
+	virtual void askStackAction(const CStack * stack);
+
 private:
 	std::list<PlayerColor> generatePlayerTurnOrder() const;
 	void makeStackDoNothing(const CStack * next);
@@ -42,8 +42,6 @@
 #include "../lib/CConfigHandler.h"
 #include "../lib/ScopeGuard.h"
 
-#include "../lib/UnlockGuard.h"
-
 #if defined(__GNUC__) && !defined (__MINGW32__) && !defined(VCMI_ANDROID)
 #include <execinfo.h>
 #endif
@@ -62,58 +60,73 @@ static void vaccept(boost::asio::ip::tcp::acceptor *ac, boost::asio::ip::tcp::so
 
 
 CPregameServer::CPregameServer(CConnection * Host, TAcceptor * Acceptor)
-	: host(Host), listeningThreads(0), acceptor(Acceptor), upcomingConnection(nullptr),
+	: host(Host), listeningConnections(0), acceptPending(false), acceptor(Acceptor), upcomingConnection(nullptr),
 	  curmap(nullptr), curStartInfo(nullptr), state(RUNNING)
 {
 	initConnection(host);
 }
 
-void CPregameServer::handleConnection(CConnection *cpc)
+void CPregameServer::startListening(CConnection * pc)
 {
-	setThreadName("CPregameServer::handleConnection");
-	try
+	listeningConnections++;
+	pc->asyncReadFrame([this, pc](const boost::system::error_code & error)
 	{
-		while(!cpc->receivedStop)
+		listeningConnections--;
+		if(error)
 		{
-			CPackForSelectionScreen *cpfs = nullptr;
-			*cpc >> cpfs;
+			connectionLost(pc, error.message());
+			return;
+		}
 
-			logNetwork->info("Got package to announce %s from %s", typeid(*cpfs).name(), cpc->toString());
+		CPackForSelectionScreen *cpfs = nullptr;
+		try
+		{
+			*pc >> cpfs;
+		}
+		catch(const std::exception & e)
+		{
+			connectionLost(pc, e.what());
+			return;
+		}
+		handlePack(pc, cpfs);
 
-			boost::unique_lock<boost::recursive_mutex> queueLock(mx);
-			bool quitting = dynamic_ptr_cast<QuitMenuWithoutStarting>(cpfs),
-				startingGame = dynamic_ptr_cast<StartWithCurrentSettings>(cpfs);
-			if(quitting || startingGame) //host leaves main menu or wants to start game -> we end
-			{
-				cpc->receivedStop = true;
-				if(!cpc->sendStop)
-					sendPack(cpc, *cpfs);
+		if(!pc->receivedStop)
+			startListening(pc);
+	});
+}
 
-				if(cpc == host)
-					toAnnounce.push_back(cpfs);
-			}
-			else
-				toAnnounce.push_back(cpfs);
+void CPregameServer::handlePack(CConnection * cpc, CPackForSelectionScreen * cpfs)
+{
+	logNetwork->info("Got package to announce %s from %s", typeid(*cpfs).name(), cpc->toString());
 
-			if(startingGame)
-			{
-				//wait for sending thread to announce start
-				auto unlock = vstd::makeUnlockGuard(mx);
-				while(state == RUNNING) boost::this_thread::sleep(boost::posix_time::milliseconds(50));
-			}
-			else if(quitting) // Server must be stopped if host is leaving from lobby to avoid crash
-			{
-				serverShuttingDown = true;
-			}
-		}
+	boost::unique_lock<boost::recursive_mutex> queueLock(mx);
+	bool quitting = dynamic_ptr_cast<QuitMenuWithoutStarting>(cpfs),
+		startingGame = dynamic_ptr_cast<StartWithCurrentSettings>(cpfs);
+	if(quitting || startingGame) //host leaves main menu or wants to start game -> we end
+	{
+		cpc->receivedStop = true;
+		if(!cpc->sendStop)
+			sendPack(cpc, *cpfs);
+
+		if(cpc == host)
+			toAnnounce.push_back(cpfs);
+		else
+			delete cpfs;
 	}
-	catch (const std::exception& e)
+	else
+		toAnnounce.push_back(cpfs);
+
+	if(quitting) // Server must be stopped if host is leaving from lobby to avoid crash
 	{
-		boost::unique_lock<boost::recursive_mutex> queueLock(mx);
-		logNetwork->error("%s dies... \nWhat happened: %s", cpc->toString(), e.what());
+		serverShuttingDown = true;
 	}
+}
 
+void CPregameServer::connectionLost(CConnection * cpc, const std::string & reason)
+{
 	boost::unique_lock<boost::recursive_mutex> queueLock(mx);
+	logNetwork->error("%s dies... \nWhat happened: %s", cpc->toString(), reason);
+
 	if(state != ENDING_AND_STARTING_GAME)
 	{
 		connections -= cpc;
@@ -132,56 +145,42 @@ void CPregameServer::handleConnection(CConnection *cpc)
 		}
 	}
 
-	logNetwork->info("Thread listening for %s ended", cpc->toString());
-	listeningThreads--;
-	vstd::clear_pointer(cpc->handler);
+	logNetwork->info("Stopped listening for %s", cpc->toString());
 }
 
-void CPregameServer::run()
+void CPregameServer::processQueue()
 {
-	startListeningThread(host);
-	start_async_accept();
-
-	while(state == RUNNING)
+	boost::unique_lock<boost::recursive_mutex> myLock(mx);
+	while(!toAnnounce.empty())
 	{
-		{
-			boost::unique_lock<boost::recursive_mutex> myLock(mx);
-			while(!toAnnounce.empty())
-			{
-				processPack(toAnnounce.front());
-				toAnnounce.pop_front();
-			}
+		processPack(toAnnounce.front());
+		toAnnounce.pop_front();
+	}
 
-// 			//we end sending thread if we ordered all our connections to stop
-// 			ending = true;
-// 			for(CPregameConnection *pc : connections)
-// 				if(!pc->sendStop)
-// 					ending = false;
+	if(state != RUNNING && acceptor->is_open())
+	{
+		logNetwork->info("Stopping listening for connections...");
+		acceptor->close();
+	}
+}
 
-			if(state != RUNNING)
-			{
-				logNetwork->info("Stopping listening for connections...");
-				acceptor->close();
-			}
+void CPregameServer::run()
+{
+	auto & io = acceptor->get_io_service();
+	io.reset();
 
-			if(acceptor)
-			{
-				acceptor->get_io_service().reset();
-				acceptor->get_io_service().poll();
-			}
-		} //frees lock
+	startListening(host);
+	start_async_accept();
 
-		boost::this_thread::sleep(boost::posix_time::milliseconds(50));
-	}
+	//handle network events one by one as they come, packs are announced right after being received
+	//when game is starting, wait until all clients confirmed the start, so their connections are free for game handler
+	while((state == RUNNING || listeningConnections || acceptPending) && io.run_one())
+		processQueue();
 
 	logNetwork->info("Thread handling connections ended");
 
 	if(state == ENDING_AND_STARTING_GAME)
-	{
-		logNetwork->info("Waiting for listening thread to finish...");
-		while(listeningThreads) boost::this_thread::sleep(boost::posix_time::milliseconds(50));
 		logNetwork->info("Preparing new game");
-	}
 }
 
 CPregameServer::~CPregameServer()
@@ -199,6 +198,7 @@ CPregameServer::~CPregameServer()
 
 void CPregameServer::connectionAccepted(const boost::system::error_code& ec)
 {
+	acceptPending = false;
 	if(ec)
 	{
 		logNetwork->info("Something wrong during accepting: %s", ec.message());
@@ -213,7 +213,7 @@ void CPregameServer::connectionAccepted(const boost::system::error_code& ec)
 		initConnection(pc);
 		upcomingConnection = nullptr;
 
-		startListeningThread(pc);
+		startListening(pc);
 
 		*pc << (ui8)pc->connectionID << curmap;
 
@@ -238,6 +238,7 @@ void CPregameServer::start_async_accept()
 	assert(acceptor);
 
 	upcomingConnection = new TSocket(acceptor->get_io_service());
+	acceptPending = true;
 	acceptor->async_accept(*upcomingConnection, std::bind(&CPregameServer::connectionAccepted, this, _1));
 }
 
@@ -310,16 +311,11 @@ void CPregameServer::processPack(CPackForSelectionScreen * pack)
 void CPregameServer::initConnection(CConnection *c)
 {
 	*c >> c->name;
+	c->enterPregameConnectionMode();
 	connections.insert(c);
 	logNetwork->info("Pregame connection with player %s established!", c->name);
 }
 
-void CPregameServer::startListeningThread(CConnection * pc)
-{
-	listeningThreads++;
-	pc->enterPregameConnectionMode();
-	pc->handler = new boost::thread(&CPregameServer::handleConnection, this, pc);
-}
 
 CVCMIServer::CVCMIServer()
 	: port(3030), io(new boost::asio::io_service()), firstConnection(nullptr), shared(nullptr)
@@ -66,11 +66,14 @@ public:
 };
 
 struct StartInfo;
+/// Lobby server. Accepting connections, reading packs and announcing them to clients
+/// is done asynchronously by the acceptor's io_service, run by the thread which called run()
 class CPregameServer
 {
 public:
 	CConnection *host;
-	int listeningThreads;
+	int listeningConnections; //connections waiting for next pack
+	bool acceptPending;
 	std::set<CConnection *> connections;
 	std::list<CPackForSelectionScreen*> toAnnounce;
 	boost::recursive_mutex mx;
@@ -87,7 +90,9 @@ public:
 	void run();
 
 	void processPack(CPackForSelectionScreen * pack);
-	void handleConnection(CConnection *cpc);
+	void processQueue();
+	void handlePack(CConnection * cpc, CPackForSelectionScreen * cpfs);
+	void connectionLost(CConnection * cpc, const std::string & reason);
 	void connectionAccepted(const boost::system::error_code& ec);
 	void initConnection(CConnection *c);
 
@@ -100,7 +105,8 @@ public:
 	void announcePack(const CPackForSelectionScreen &pack);
 
 	void sendPack(CConnection * pc, const CPackForSelectionScreen & pack);
-	void startListeningThread(CConnection * pc);
+	/// Waits for next pack from connection without blocking
+	void startListening(CConnection * pc);
 };
 
 extern boost::program_options::variables_map cmdLineOptions;
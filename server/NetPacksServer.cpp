@@ -50,7 +50,7 @@ CGameState* CPackForServer::GS(CGameHandler *gh)
 bool SaveGame::applyGh( CGameHandler *gh )
 {
 	gh->save(fname);
-	logGlobal->info("Game has been saved as %s", fname);
+	logGlobal->info("Game is being saved as %s", fname);
 	return true;
 }
 
@@ -276,6 +276,11 @@ bool DigWithHero::applyGh( CGameHandler *gh )
 	return gh->dig(gh->getHero(id));
 }
 
+bool RequestAvailableCreatures::applyGh(CGameHandler *gh)
+{
+	return gh->resendAvailableCreatures(tid);
+}
+
 bool CastAdvSpell::applyGh(CGameHandler * gh)
 {
 	ERROR_IF_NOT_OWNS(hid);
@@ -0,0 +1,78 @@
+/*
+ * CMappedFileStreamTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../lib/filesystem/CMappedFileStream.h"
+
+struct CMappedFileStreamTest : testing::Test
+{
+	boost::filesystem::path path;
+	std::shared_ptr<const CMappedFile> file;
+
+	void SetUp() override
+	{
+		path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("vcmi-mapped-%%%%%%%%.bin");
+		boost::filesystem::ofstream out(path, std::ios::binary);
+		for(int i = 0; i < 100; i++)
+			out.put(static_cast<char>(i));
+		out.close();
+
+		file = std::make_shared<CMappedFile>(path);
+	}
+
+	void TearDown() override
+	{
+		file.reset();
+		boost::filesystem::remove(path);
+	}
+};
+
+TEST_F(CMappedFileStreamTest, viewReadsInPlace)
+{
+	CMappedFileStream subject(file, 10, 20);
+	EXPECT_EQ(20, subject.getSize());
+	ASSERT_NE(nullptr, subject.data());
+	EXPECT_EQ(file->getData() + 10, subject.data());
+	EXPECT_EQ(10, subject.data()[0]);
+
+	ui8 buffer[30] = {0};
+	EXPECT_EQ(5, subject.read(buffer, 5));
+	EXPECT_EQ(14, buffer[4]);
+	EXPECT_EQ(5, subject.tell());
+
+	EXPECT_EQ(10, subject.skip(10));
+	EXPECT_EQ(5, subject.read(buffer, 30));
+	EXPECT_EQ(25, buffer[0]);
+	EXPECT_EQ(0, subject.read(buffer, 30));
+
+	EXPECT_EQ(20, subject.seek(100));
+	EXPECT_EQ(0, subject.seek(-1));
+}
+
+TEST_F(CMappedFileStreamTest, viewIsClippedToFile)
+{
+	CMappedFileStream whole(file);
+	EXPECT_EQ(100, whole.getSize());
+
+	CMappedFileStream tail(file, 90, 50);
+	EXPECT_EQ(10, tail.getSize());
+
+	auto copy = tail.readAll();
+	EXPECT_EQ(10, copy.second);
+	EXPECT_EQ(99, copy.first[9]);
+	EXPECT_EQ(10, tail.tell());
+}
+
+TEST_F(CMappedFileStreamTest, viewKeepsMappingAlive)
+{
+	auto subject = make_unique<CMappedFileStream>(file, 50, 1);
+	file.reset();
+	EXPECT_EQ(50, subject->data()[0]);
+}
@@ -0,0 +1,162 @@
+/*
+ * CResourceCacheTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../lib/filesystem/CResourceCache.h"
+#include "../lib/filesystem/CMemoryBuffer.h"
+#include "../lib/filesystem/CMemoryStream.h"
+#include "../lib/filesystem/ISimpleResourceLoader.h"
+
+namespace
+{
+	/// Serves resources named by their size, "RAW/..." resources are streams without in-memory access
+	class SizedResourceLoader : public ISimpleResourceLoader
+	{
+	public:
+		std::vector<ui8> content;
+		mutable std::atomic<int> loads;
+
+		SizedResourceLoader() : content(1000), loads(0)
+		{
+			for(size_t i = 0; i < content.size(); i++)
+				content[i] = i % 256;
+		}
+
+		std::unique_ptr<CInputStream> load(const ResourceID & resourceName) const override
+		{
+			loads++;
+			std::string name = resourceName.getName();
+			bool raw = boost::starts_with(name, "RAW/");
+			size_t size = boost::lexical_cast<size_t>(raw ? name.substr(4) : name);
+
+			if(raw)
+				return make_unique<CMemoryStream>(content.data(), size);
+
+			auto buffer = make_unique<CMemoryBuffer>();
+			buffer->write(content.data(), size);
+			return std::move(buffer);
+		}
+
+		bool existsResource(const ResourceID & resourceName) const override { return true; }
+		std::string getMountPoint() const override { return ""; }
+		void updateFilteredFiles(std::function<bool(const std::string &)> filter) const override {}
+		std::unordered_set<ResourceID> getFilteredFiles(std::function<bool(const ResourceID &)> filter) const override
+		{
+			return std::unordered_set<ResourceID>();
+		}
+	};
+
+	ResourceID sized(size_t size)
+	{
+		return ResourceID(boost::lexical_cast<std::string>(size), EResType::OTHER);
+	}
+}
+
+TEST(CResourceCacheTest, hitsShareBuffer)
+{
+	SizedResourceLoader loader;
+	CResourceCache cache(&loader, 1000);
+
+	auto first = cache.load(sized(100));
+	auto second = cache.load(sized(100));
+	auto raw = cache.load(ResourceID("RAW/50", EResType::OTHER));
+
+	EXPECT_EQ(first, second);
+	EXPECT_EQ(100, first->size());
+	EXPECT_EQ(99, first->data()[99]);
+	EXPECT_EQ(50, raw->size());
+	EXPECT_NE(loader.content.data(), raw->data());
+	EXPECT_EQ(49, raw->data()[49]);
+	EXPECT_EQ(2, loader.loads);
+
+	auto stats = cache.getStats();
+	EXPECT_EQ(1, stats.hits);
+	EXPECT_EQ(2, stats.misses);
+	EXPECT_EQ(0, stats.evictions);
+	EXPECT_EQ(2, stats.entries);
+	EXPECT_EQ(150, stats.bytes);
+}
+
+TEST(CResourceCacheTest, evictsLeastRecentlyUsed)
+{
+	SizedResourceLoader loader;
+	CResourceCache cache(&loader, 700);
+
+	cache.load(sized(200));
+	auto evicted = cache.load(sized(201));
+	cache.load(sized(202));
+	cache.load(sized(200));
+	cache.load(sized(203));
+
+	auto stats = cache.getStats();
+	EXPECT_EQ(1, stats.evictions);
+	EXPECT_EQ(3, stats.entries);
+	EXPECT_EQ(605, stats.bytes);
+
+	cache.load(sized(200));
+	cache.load(sized(202));
+	cache.load(sized(203));
+	EXPECT_EQ(4, loader.loads);
+
+	// evicted buffer stays valid for its users
+	EXPECT_EQ(201, evicted->size());
+	EXPECT_EQ(200, evicted->data()[200]);
+	EXPECT_NE(evicted, cache.load(sized(201)));
+	EXPECT_EQ(5, loader.loads);
+}
+
+TEST(CResourceCacheTest, budgetLimitsCache)
+{
+	SizedResourceLoader loader;
+	CResourceCache cache(&loader, 300);
+
+	auto oversized = cache.load(sized(301));
+	EXPECT_EQ(301, oversized->size());
+	EXPECT_EQ(0, cache.getStats().entries);
+
+	cache.load(sized(150));
+	cache.load(sized(100));
+	cache.setByteBudget(120);
+
+	auto stats = cache.getStats();
+	EXPECT_EQ(1, stats.entries);
+	EXPECT_EQ(100, stats.bytes);
+	EXPECT_EQ(1, stats.evictions);
+
+	cache.clear();
+	EXPECT_EQ(0, cache.getStats().entries);
+	EXPECT_EQ(0, cache.getStats().bytes);
+	EXPECT_EQ(3, cache.getStats().misses);
+}
+
+TEST(CResourceCacheTest, concurrentLoads)
+{
+	SizedResourceLoader loader;
+	CResourceCache cache(&loader, 5000);
+
+	boost::thread_group threads;
+	for(int t = 0; t < 4; t++)
+	{
+		threads.create_thread([&cache, t]()
+		{
+			for(int i = 0; i < 1000; i++)
+			{
+				auto resource = cache.load(sized((i * 7 + t) % 100));
+				EXPECT_EQ((i * 7 + t) % 100, resource->size());
+			}
+		});
+	}
+	threads.join_all();
+
+	auto stats = cache.getStats();
+	EXPECT_EQ(4000, stats.hits + stats.misses);
+	EXPECT_EQ(100, stats.entries);
+	EXPECT_EQ(99 * 100 / 2, stats.bytes);
+}
@@ -0,0 +1,56 @@
+/*
+ * CThreadHelperTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../lib/CThreadHelper.h"
+
+TEST(CThreadHelperTest, runsEveryTaskOnceWithSeveralThreads)
+{
+	std::vector<std::atomic<int>> calls(100);
+	std::vector<Task> tasks;
+	for(auto & counter : calls)
+	{
+		counter = 0;
+		tasks.push_back([&counter](){ counter++; });
+	}
+
+	for(int threads = 2; threads <= 4; threads++)
+	{
+		CThreadHelper helper(&tasks, threads);
+		helper.run();
+	}
+
+	for(auto & counter : calls)
+		EXPECT_EQ(counter, 3);
+}
+
+TEST(CThreadHelperTest, runParallelFinishesAllTasksBeforeRethrowing)
+{
+	std::atomic<int> finished(0);
+	std::vector<Task> tasks;
+	for(int i = 0; i < 16; i++)
+	{
+		tasks.push_back([&finished, i]()
+		{
+			if(i == 5)
+				throw std::runtime_error("task failed");
+			finished++;
+		});
+	}
+
+	EXPECT_THROW(CThreadHelper::runParallel(tasks), std::runtime_error);
+	EXPECT_EQ(finished, 15);
+}
+
+TEST(CThreadHelperTest, runParallelAcceptsNoTasks)
+{
+	std::vector<Task> tasks;
+	EXPECT_NO_THROW(CThreadHelper::runParallel(tasks));
+}
@@ -10,6 +10,7 @@
 
 #include "StdInc.h"
 #include "../lib/battle/BattleHex.h"
+#include "../lib/GameConstants.h"
 
 TEST(BattleHexTest, getNeighbouringTiles){
 	BattleHex mainHex;
@@ -42,6 +43,23 @@ TEST(BattleHexTest, getNeighbouringTiles){
 	EXPECT_EQ(neighbouringTiles.at(5), 92);
 }
 
+TEST(BattleHexTest, precomputedNeighbouringTiles)
+{
+	for(si16 hex = 0; hex < GameConstants::BFIELD_SIZE; hex++)
+	{
+		auto expected = BattleHex(hex).neighbouringTiles();
+		const auto & precomputed = BattleHex(hex).precomputedNeighbouringTiles();
+
+		for(size_t i = 0; i < precomputed.size(); i++)
+		{
+			if(i < expected.size())
+				EXPECT_EQ(expected[i], precomputed[i]) << "hex " << hex;
+			else
+				EXPECT_FALSE(precomputed[i].isValid()) << "hex " << hex;
+		}
+	}
+}
+
 TEST(BattleHexTest, getDistance){
 	BattleHex firstHex(0,0), secondHex(16,0);
 	EXPECT_EQ((int)firstHex.getDistance(firstHex,secondHex), 16);
@@ -0,0 +1,81 @@
+/*
+ * BattleSearchTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "BattleTestFixture.h"
+
+#include "../../AI/BattleAI/BattleSearch.h"
+#include "../../lib/battle/BattleInfo.h"
+
+namespace
+{
+	bool sameAction(const SnapshotAction & a, const SnapshotAction & b)
+	{
+		return a.type == b.type && a.unit == b.unit && a.target == b.target && a.destination == b.destination && a.chargedFields == b.chargedFields;
+	}
+}
+
+/// Field battle of armies set up by test
+typedef BattleTestFixture BattleSearchTest;
+
+TEST_F(BattleSearchTest, returnsPossibleActionOfActiveUnit)
+{
+	startBattle({{CreatureID::CAVALIER, 5}, {CreatureID::LICHES, 8}}, {{CreatureID::SKELETON, 40}, {CreatureID::IRON_GOLEM, 10}});
+
+	const BattleSnapshot snapshot(*gs.curB);
+	ASSERT_LE(0, snapshot.activeUnit());
+
+	for(ui8 side = 0; side < 2; side++)
+	{
+		BattleSearch search(side, 200);
+		const auto action = search.findBestAction(snapshot);
+		ASSERT_TRUE(action.is_initialized());
+		EXPECT_EQ(snapshot.activeUnit(), action->unit);
+
+		const auto possible = snapshot.getPossibleActions();
+		EXPECT_TRUE(vstd::contains_if(possible, [&](const SnapshotAction & a){ return sameAction(a, *action); }));
+		EXPECT_LE(1, search.getReachedDepth());
+		EXPECT_LT(0, search.getVisitedNodes());
+	}
+}
+
+TEST_F(BattleSearchTest, finishesBattleWhenPossible)
+{
+	startBattle({{CreatureID::LICHES, 20}}, {{CreatureID::SKELETON, 1}});
+
+	const BattleSnapshot snapshot(*gs.curB);
+	ASSERT_EQ(0, snapshot.info(snapshot.activeUnit()).side);
+
+	BattleSearch search(0, 200);
+	const auto action = search.findBestAction(snapshot);
+	ASSERT_TRUE(action.is_initialized());
+	EXPECT_EQ(SnapshotAction::SHOOT, action->type);
+
+	BattleSnapshot next = snapshot;
+	next.apply(*action);
+	ASSERT_TRUE(next.isFinished().is_initialized());
+	EXPECT_EQ(0, next.isFinished().get());
+}
+
+TEST_F(BattleSearchTest, shootsMoreValuableStack)
+{
+	//both stacks are slower than liches and die from one shot
+	startBattle({{CreatureID::LICHES, 30}}, {{CreatureID::SKELETON, 1}, {CreatureID::IRON_GOLEM, 1}});
+
+	const BattleSnapshot snapshot(*gs.curB);
+	ASSERT_EQ(0, snapshot.info(snapshot.activeUnit()).side);
+
+	BattleSearch search(0, 500);
+	const auto action = search.findBestAction(snapshot);
+	ASSERT_TRUE(action.is_initialized());
+	ASSERT_EQ(SnapshotAction::SHOOT, action->type);
+	EXPECT_EQ(CreatureID::IRON_GOLEM, snapshot.info(action->target).creature);
+}
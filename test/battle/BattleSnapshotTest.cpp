@@ -0,0 +1,192 @@
+/*
+ * BattleSnapshotTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "BattleTestFixture.h"
+
+#include "../../AI/BattleAI/BattleSnapshot.h"
+#include "../../lib/CStack.h"
+#include "../../lib/NetPacks.h"
+#include "../../lib/battle/BattleInfo.h"
+#include "../../lib/battle/BattleAttackInfo.h"
+
+/// Siege of castle with fort, creatures with jousting, ranged attack, wall and distance penalties and mind immunity on both sides
+struct BattleSnapshotTest : BattleTestFixture
+{
+	void SetUp() override
+	{
+		startBattle(
+			{{CreatureID::CAVALIER, 5}, {CreatureID::LICHES, 8}, {CreatureID::PSYCHIC_ELEMENTAL, 3}, {CreatureID::CHAOS_HYDRA, 2}, {CreatureID::CHAMPION, 2}},
+			{{CreatureID::SKELETON, 60}, {CreatureID::LICHES, 10}, {CreatureID::IRON_GOLEM, 12}, {CreatureID::BONE_DRAGON, 4}, {CreatureID::WIGHTS, 15}},
+			castleWithFort());
+	}
+
+	/// Same attack as resolved by server, without luck and death blow
+	TDmgRange libRange(const CStack * attacker, const CStack * defender, bool shooting, int chargedFields) const
+	{
+		BattleAttackInfo info(attacker, defender, shooting);
+		info.chargedFields = chargedFields;
+		return gs.curB->calculateDmgRange(info);
+	}
+
+	void expectSameDamage(const BattleSnapshot & snapshot) const
+	{
+		for(ui8 attacker = 0; attacker < snapshot.unitCount(); attacker++)
+		{
+			for(ui8 defender = 0; defender < snapshot.unitCount(); defender++)
+			{
+				const CStack * attackerStack = snapshot.info(attacker).stack;
+				const CStack * defenderStack = snapshot.info(defender).stack;
+				if(attackerStack->side == defenderStack->side)
+					continue;
+
+				for(int chargedFields : {0, 3})
+				{
+					EXPECT_EQ(libRange(attackerStack, defenderStack, false, chargedFields), snapshot.estimateDamage(attacker, defender, false, chargedFields))
+						<< attackerStack->nodeName() << " attacking " << defenderStack->nodeName() << ", charged fields " << chargedFields;
+				}
+
+				if(snapshot.info(attacker).shooter)
+				{
+					EXPECT_EQ(libRange(attackerStack, defenderStack, true, 0), snapshot.estimateDamage(attacker, defender, true, 0))
+						<< attackerStack->nodeName() << " shooting " << defenderStack->nodeName();
+				}
+			}
+		}
+	}
+};
+
+TEST_F(BattleSnapshotTest, damageEstimateMatchesCalculateDmgRange)
+{
+	BattleSnapshot snapshot(*gs.curB);
+	ASSERT_EQ(10, snapshot.unitCount());
+	expectSameDamage(snapshot);
+}
+
+TEST_F(BattleSnapshotTest, damageEstimateMatchesCalculateDmgRangeWithSpellEffects)
+{
+	const CStack * liches = findStack(0, CreatureID::LICHES);
+	const CStack * golems = findStack(1, CreatureID::IRON_GOLEM);
+	ASSERT_TRUE(liches && golems);
+
+	SetStackEffect bless;
+	bless.stacks.push_back(liches->ID);
+	bless.effect.push_back(Bonus(Bonus::N_TURNS, Bonus::ALWAYS_MAXIMUM_DAMAGE, Bonus::SPELL_EFFECT, 1, SpellID::BLESS, -1));
+	gs.apply(&bless);
+
+	SetStackEffect shield;
+	shield.stacks.push_back(golems->ID);
+	shield.effect.push_back(Bonus(Bonus::N_TURNS, Bonus::GENERAL_DAMAGE_REDUCTION, Bonus::SPELL_EFFECT, 30, SpellID::SHIELD, 0));
+	shield.effect.push_back(Bonus(Bonus::N_TURNS, Bonus::GENERAL_DAMAGE_REDUCTION, Bonus::SPELL_EFFECT, 50, SpellID::AIR_SHIELD, 1));
+	gs.apply(&shield);
+
+	expectSameDamage(BattleSnapshot(*gs.curB));
+}
+
+TEST_F(BattleSnapshotTest, defensiveStanceMatchesServer)
+{
+	const CStack * golems = findStack(1, CreatureID::IRON_GOLEM);
+	ASSERT_TRUE(golems);
+
+	BattleSnapshot snapshot(*gs.curB);
+	const int golemsIndex = snapshot.indexOf(golems);
+	ASSERT_LE(0, golemsIndex);
+	snapshot.apply(SnapshotAction::makeDefend(golemsIndex));
+	ASSERT_TRUE(snapshot.unit(golemsIndex).defending);
+
+	SetStackEffect defend;
+	defend.stacks.push_back(golems->ID);
+	defend.effect = golems->getDefensiveStanceBonuses();
+	gs.apply(&defend);
+
+	for(ui8 attacker = 0; attacker < snapshot.unitCount(); attacker++)
+	{
+		if(snapshot.info(attacker).side != 0)
+			continue;
+		EXPECT_EQ(libRange(snapshot.info(attacker).stack, golems, false, 0), snapshot.estimateDamage(attacker, golemsIndex, false, 0))
+			<< snapshot.info(attacker).stack->nodeName();
+	}
+}
+
+TEST_F(BattleSnapshotTest, waitingUnitActsAfterOthers)
+{
+	BattleSnapshot snapshot(*gs.curB);
+	const int first = snapshot.activeUnit();
+	ASSERT_LE(0, first);
+
+	snapshot.apply(SnapshotAction::makeWait(first));
+	EXPECT_TRUE(snapshot.unit(first).waited);
+	EXPECT_NE(first, snapshot.activeUnit());
+
+	//everybody else acts before waiting unit
+	while(snapshot.activeUnit() != first)
+	{
+		ASSERT_LE(0, snapshot.activeUnit());
+		snapshot.apply(SnapshotAction::makeDefend(snapshot.activeUnit()));
+	}
+	EXPECT_EQ(0, snapshot.getRound());
+}
+
+TEST_F(BattleSnapshotTest, meleeAttackIsRetaliated)
+{
+	BattleSnapshot snapshot(*gs.curB);
+	const int champions = snapshot.indexOf(findStack(0, CreatureID::CHAMPION));
+	const int skeletons = snapshot.indexOf(findStack(1, CreatureID::SKELETON));
+	ASSERT_LE(0, champions);
+	ASSERT_LE(0, skeletons);
+
+	const TDmgRange dealt = snapshot.estimateDamage(champions, skeletons, false, 2);
+	const si64 skeletonsHealth = snapshot.availableHealth(skeletons);
+	const si64 championsHealth = snapshot.availableHealth(champions);
+	const si32 retaliations = snapshot.unit(skeletons).retaliations;
+
+	snapshot.apply(SnapshotAction::makeMeleeAttack(champions, skeletons, BattleHex::INVALID, 2));
+
+	EXPECT_EQ(skeletonsHealth - (dealt.first + dealt.second) / 2, snapshot.availableHealth(skeletons));
+	ASSERT_TRUE(snapshot.alive(skeletons));
+	EXPECT_GT(championsHealth, snapshot.availableHealth(champions));
+	EXPECT_EQ(retaliations - 1, snapshot.unit(skeletons).retaliations);
+	EXPECT_TRUE(snapshot.unit(champions).acted);
+}
+
+TEST_F(BattleSnapshotTest, shotUsesAmmunitionAndIsNotRetaliated)
+{
+	BattleSnapshot snapshot(*gs.curB);
+	const int liches = snapshot.indexOf(findStack(0, CreatureID::LICHES));
+	const int skeletons = snapshot.indexOf(findStack(1, CreatureID::SKELETON));
+	ASSERT_LE(0, liches);
+	ASSERT_LE(0, skeletons);
+	ASSERT_TRUE(snapshot.canShoot(liches, skeletons));
+
+	const TDmgRange dealt = snapshot.estimateDamage(liches, skeletons, true, 0);
+	const si64 skeletonsHealth = snapshot.availableHealth(skeletons);
+	const si64 lichesHealth = snapshot.availableHealth(liches);
+	const si32 shots = snapshot.unit(liches).shots;
+
+	snapshot.apply(SnapshotAction::makeShotAttack(liches, skeletons));
+
+	EXPECT_EQ(skeletonsHealth - (dealt.first + dealt.second) / 2, snapshot.availableHealth(skeletons));
+	EXPECT_EQ(lichesHealth, snapshot.availableHealth(liches));
+	EXPECT_EQ(shots - 1, snapshot.unit(liches).shots);
+}
+
+TEST_F(BattleSnapshotTest, copiesAreIndependent)
+{
+	BattleSnapshot snapshot(*gs.curB);
+	const int liches = snapshot.indexOf(findStack(0, CreatureID::LICHES));
+	const int skeletons = snapshot.indexOf(findStack(1, CreatureID::SKELETON));
+
+	BattleSnapshot copy = snapshot;
+	copy.apply(SnapshotAction::makeShotAttack(liches, skeletons));
+
+	EXPECT_EQ(findStack(1, CreatureID::SKELETON)->health.available(), snapshot.availableHealth(skeletons));
+	EXPECT_GT(snapshot.availableHealth(skeletons), copy.availableHealth(skeletons));
+}
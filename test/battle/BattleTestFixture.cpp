@@ -0,0 +1,58 @@
+/*
+ * BattleTestFixture.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "BattleTestFixture.h"
+
+#include "../lib/CStack.h"
+#include "../lib/NetPacks.h"
+#include "../lib/battle/BattleInfo.h"
+
+void BattleTestFixture::startBattle(const TStacks & attackerStacks, const TStacks & defenderStacks, const CGTownInstance * siegedTown)
+{
+	attackers.tempOwner = PlayerColor(0);
+	for(size_t i = 0; i < attackerStacks.size(); i++)
+		attackers.putStack(SlotID(i), new CStackInstance(attackerStacks[i].first, attackerStacks[i].second));
+	defenders.tempOwner = PlayerColor(1);
+	for(size_t i = 0; i < defenderStacks.size(); i++)
+		defenders.putStack(SlotID(i), new CStackInstance(defenderStacks[i].first, defenderStacks[i].second));
+
+	const CArmedInstance * armies[2] = {&attackers, &defenders};
+	const CGHeroInstance * heroes[2] = {nullptr, nullptr};
+	BattleStart start;
+	start.info = BattleInfo::setupBattle(int3(0, 0, 0), ETerrainType::GRASS, BFieldType::NONE, armies, heroes, false, siegedTown);
+	gs.apply(&start);
+}
+
+void BattleTestFixture::TearDown()
+{
+	if(gs.curB)
+	{
+		BattleResult result;
+		gs.apply(&result);
+	}
+}
+
+const CGTownInstance * BattleTestFixture::castleWithFort()
+{
+	town.subID = ETownType::CASTLE;
+	town.builtBuildings.insert(BuildingID::FORT);
+	return &town;
+}
+
+const CStack * BattleTestFixture::findStack(ui8 side, CreatureID creature) const
+{
+	for(const CStack * stack : gs.curB->stacks)
+	{
+		if(stack->side == side && stack->getCreature()->idNumber == creature)
+			return stack;
+	}
+	return nullptr;
+}
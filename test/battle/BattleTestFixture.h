@@ -0,0 +1,34 @@
+/*
+ * BattleTestFixture.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "../lib/CGameState.h"
+#include "../lib/mapObjects/CGTownInstance.h"
+
+class CStack;
+
+/// Battle between armies of two players without heroes, ended on tear down
+struct BattleTestFixture : testing::Test
+{
+	typedef std::vector<std::pair<CreatureID, TQuantity>> TStacks;
+
+	CGameState gs;
+	CGTownInstance town;
+	CArmedInstance attackers, defenders;
+
+	/// Stacks are placed in slots in given order. With town given battle is a siege of that town
+	void startBattle(const TStacks & attackerStacks, const TStacks & defenderStacks, const CGTownInstance * siegedTown = nullptr);
+	void TearDown() override;
+
+	/// Makes fixture town a castle with fort, so siege has walls
+	const CGTownInstance * castleWithFort();
+	/// First stack of given creature on given side
+	const CStack * findStack(ui8 side, CreatureID creature) const;
+};
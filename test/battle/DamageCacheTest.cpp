@@ -0,0 +1,124 @@
+/*
+ * DamageCacheTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "BattleTestFixture.h"
+
+#include "../../lib/CStack.h"
+#include "../../lib/NetPacks.h"
+#include "../../lib/battle/BattleInfo.h"
+#include "../../lib/battle/BattleAttackInfo.h"
+
+namespace
+{
+	/// Bonuses of another bearer under different identity, damage of such bearers is never cached
+	class BonusForwarder : public IBonusBearer
+	{
+		const IBonusBearer * target;
+	public:
+		explicit BonusForwarder(const IBonusBearer * target)
+			: target(target)
+		{
+		}
+
+		const TBonusListPtr getAllBonuses(const CSelector & selector, const CSelector & limit, const CBonusSystemNode * root = nullptr, const BonusCacheKey & cachingKey = BonusCacheKey()) const override
+		{
+			return target->getAllBonuses(selector, limit, root, cachingKey);
+		}
+
+		int64_t getTreeVersion() const override
+		{
+			return target->getTreeVersion();
+		}
+	};
+}
+
+/// Siege of castle with fort, liches shooting at skeletons behind the wall
+struct DamageCacheTest : BattleTestFixture
+{
+	const CStack * shooter;
+	const CStack * target;
+
+	DamageCacheTest()
+		: shooter(nullptr), target(nullptr)
+	{
+	}
+
+	void SetUp() override
+	{
+		startBattle({{CreatureID::LICHES, 10}}, {{CreatureID::SKELETON, 20}}, castleWithFort());
+
+		shooter = findStack(0, CreatureID::LICHES);
+		target = findStack(1, CreatureID::SKELETON);
+		ASSERT_TRUE(shooter && target);
+		ASSERT_TRUE(gs.curB->battleHasWallPenalty(shooter, target->position));
+	}
+
+	TDmgRange freshRange(const BattleAttackInfo & info) const
+	{
+		BonusForwarder attackerBonuses(info.attackerBonuses), defenderBonuses(info.defenderBonuses);
+		BattleAttackInfo uncached = info;
+		uncached.attackerBonuses = &attackerBonuses;
+		uncached.defenderBonuses = &defenderBonuses;
+		return gs.curB->calculateDmgRange(uncached);
+	}
+};
+
+TEST_F(DamageCacheTest, sameStateIsServedFromCache)
+{
+	BattleAttackInfo info(shooter, target, true);
+	const TDmgRange range = gs.curB->calculateDmgRange(info);
+
+	EXPECT_EQ(range, gs.curB->calculateDmgRange(info));
+	EXPECT_EQ(range, freshRange(info));
+	EXPECT_EQ(1, gs.curB->battleDamageCacheStats().hits);
+}
+
+TEST_F(DamageCacheTest, catapultHitInvalidatesCachedRange)
+{
+	BattleAttackInfo info(shooter, target, true);
+	gs.curB->calculateDmgRange(info);
+
+	CatapultAttack hit;
+	hit.attacker = -1;
+	for(int part = EWallPart::KEEP; part < EWallPart::PARTS_COUNT; part++)
+	{
+		if(!gs.curB->isWallPartPotentiallyAttackable(EWallPart::EWallPart(part)))
+			continue;
+		CatapultAttack::AttackInfo attack;
+		attack.destinationTile = gs.curB->wallPartToBattleHex(EWallPart::EWallPart(part));
+		attack.attackedPart = part;
+		attack.damageDealt = 2;
+		hit.attackedParts.push_back(attack);
+	}
+	gs.apply(&hit);
+	ASSERT_EQ(EWallState::DESTROYED, gs.curB->battleGetWallState(EWallPart::UPPER_WALL));
+
+	EXPECT_EQ(freshRange(info), gs.curB->calculateDmgRange(info));
+	EXPECT_EQ(0, gs.curB->battleDamageCacheStats().hits);
+	EXPECT_EQ(1, gs.curB->battleDamageCacheStats().invalidations);
+}
+
+TEST_F(DamageCacheTest, spellEffectInvalidatesCachedRange)
+{
+	BattleAttackInfo info(shooter, target, true);
+	const TDmgRange before = gs.curB->calculateDmgRange(info);
+
+	SetStackEffect effect;
+	effect.stacks.push_back(shooter->ID);
+	effect.effect.push_back(Bonus(Bonus::N_TURNS, Bonus::PRIMARY_SKILL, Bonus::SPELL_EFFECT, 10, SpellID::PRECISION, PrimarySkill::ATTACK));
+	gs.apply(&effect);
+
+	const TDmgRange after = gs.curB->calculateDmgRange(info);
+	EXPECT_EQ(freshRange(info), after);
+	EXPECT_LT(before.first, after.first);
+	EXPECT_EQ(0, gs.curB->battleDamageCacheStats().hits);
+}
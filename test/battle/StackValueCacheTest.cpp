@@ -0,0 +1,112 @@
+/*
+ * StackValueCacheTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "../../AI/BattleAI/StackValueCache.h"
+
+namespace
+{
+	std::vector<Bonus> haste(si32 speed)
+	{
+		return {Bonus(Bonus::N_TURNS, Bonus::STACKS_SPEED, Bonus::SPELL_EFFECT, speed, SpellID::HASTE)};
+	}
+
+	/// Evaluator counting its calls
+	class CountingEvaluator
+	{
+	public:
+		std::atomic<int> calls;
+		int value;
+
+		explicit CountingEvaluator(int value)
+			: calls(0), value(value)
+		{
+		}
+
+		StackValueCache::TEvaluator operator()()
+		{
+			return [this]()
+			{
+				calls++;
+				return value;
+			};
+		}
+	};
+}
+
+TEST(StackValueCacheTest, reusesValueOfEqualBonuses)
+{
+	StackValueCache cache;
+	CountingEvaluator evaluator(42);
+
+	EXPECT_EQ(42, cache.get(nullptr, haste(3), evaluator()));
+	EXPECT_EQ(42, cache.get(nullptr, haste(3), evaluator()));
+
+	EXPECT_EQ(1, evaluator.calls);
+	EXPECT_EQ(1, cache.reusedCount());
+}
+
+TEST(StackValueCacheTest, evaluatesDifferentBonusesSeparately)
+{
+	StackValueCache cache;
+	CountingEvaluator evaluator(42);
+
+	cache.get(nullptr, haste(3), evaluator());
+	cache.get(nullptr, haste(5), evaluator());
+
+	auto withDuration = haste(3);
+	withDuration.front().turnsRemain = 2;
+	cache.get(nullptr, withDuration, evaluator());
+
+	EXPECT_EQ(3, evaluator.calls);
+	EXPECT_EQ(0, cache.reusedCount());
+}
+
+TEST(StackValueCacheTest, doesNotReuseBonusesWithLimiterOrPropagator)
+{
+	StackValueCache cache;
+	CountingEvaluator evaluator(42);
+
+	auto limited = haste(3);
+	limited.front().limiter = std::make_shared<RankRangeLimiter>(2);
+	auto propagated = haste(3);
+	propagated.front().propagator = std::make_shared<CPropagatorNodeType>(CBonusSystemNode::BATTLE);
+
+	EXPECT_FALSE(StackValueCache::fingerprint(limited).is_initialized());
+	EXPECT_FALSE(StackValueCache::fingerprint(propagated).is_initialized());
+
+	cache.get(nullptr, limited, evaluator());
+	cache.get(nullptr, limited, evaluator());
+	cache.get(nullptr, propagated, evaluator());
+	cache.get(nullptr, haste(3), evaluator());
+
+	EXPECT_EQ(4, evaluator.calls);
+	EXPECT_EQ(0, cache.reusedCount());
+}
+
+TEST(StackValueCacheTest, returnsSameValueToConcurrentCallers)
+{
+	const int threads = 8;
+	StackValueCache cache;
+	CountingEvaluator evaluator(42);
+	std::vector<int> results(threads, 0);
+
+	boost::thread_group group;
+	for(int i = 0; i < threads; i++)
+		group.create_thread([&, i]()
+		{
+			results[i] = cache.get(nullptr, haste(3), evaluator());
+		});
+	group.join_all();
+
+	EXPECT_EQ(std::vector<int>(threads, 42), results);
+	EXPECT_EQ(threads, evaluator.calls + cache.reusedCount());
+}
@@ -0,0 +1,32 @@
+/*
+ * Benchmark.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+/// Helpers for micro-benchmarks. Benchmarks are regular tests prefixed with DISABLED_,
+/// run them with: vcmitest --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+namespace Benchmark
+{
+	typedef std::chrono::steady_clock TClock;
+
+	/// Runs body given number of times and prints average wall time of one iteration
+	/// Returns average time in nanoseconds
+	template<typename Body>
+	double measure(const std::string & name, size_t iterations, Body && body)
+	{
+		auto start = TClock::now();
+		for(size_t i = 0; i < iterations; i++)
+			body(i);
+		auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(TClock::now() - start);
+
+		double perIteration = double(elapsed.count()) / std::max<size_t>(iterations, 1);
+		std::cout << boost::format("[ BENCH    ] %-50s %12.1f ns/op (%d iterations)") % name % perIteration % iterations << std::endl;
+		return perIteration;
+	}
+}
@@ -0,0 +1,107 @@
+/*
+ * BonusCacheBenchmark.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "Benchmark.h"
+#include "../lib/HeroBonus.h"
+
+namespace
+{
+	const size_t ITERATIONS = 1000000;
+	const int SUBTYPES = 8;
+
+	struct BonusCacheBenchmark : testing::Test
+	{
+		CBonusSystemNode creature;
+		CBonusSystemNode stack;
+
+		void SetUp() override
+		{
+			for(int subtype = 0; subtype < SUBTYPES; subtype++)
+			{
+				creature.addNewBonus(std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::CREATURE_ABILITY, subtype + 1, 0, subtype));
+				creature.addNewBonus(std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::CREATURE_DAMAGE, Bonus::CREATURE_ABILITY, subtype + 1, 0, subtype));
+			}
+			creature.addNewBonus(std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::STACKS_SPEED, Bonus::CREATURE_ABILITY, 7, 0));
+			creature.addNewBonus(std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::STACK_HEALTH, Bonus::CREATURE_ABILITY, 10, 0));
+			stack.attachTo(&creature);
+		}
+
+		void TearDown() override
+		{
+			stack.detachFrom(&creature);
+		}
+	};
+}
+
+TEST_F(BonusCacheBenchmark, DISABLED_lookup)
+{
+	//reproduces string keyed cache used before typed keys
+	std::map<std::string, TBonusListPtr> stringCache;
+	BonusQueryCache typedCache;
+
+	for(int subtype = 0; subtype < SUBTYPES; subtype++)
+	{
+		std::stringstream cachingStr;
+		cachingStr << "type_" << Bonus::PRIMARY_SKILL << "s_" << subtype;
+		stringCache[cachingStr.str()] = stack.getBonuses(Selector::typeSubtype(Bonus::PRIMARY_SKILL, subtype));
+		typedCache.insert(BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, subtype), stringCache[cachingStr.str()]);
+	}
+
+	size_t found = 0;
+
+	Benchmark::measure("string key, std::map lookup", ITERATIONS, [&](size_t i)
+	{
+		std::stringstream cachingStr;
+		cachingStr << "type_" << Bonus::PRIMARY_SKILL << "s_" << (i % SUBTYPES);
+		found += stringCache.count(cachingStr.str());
+	});
+
+	Benchmark::measure("typed key, flat cache lookup", ITERATIONS, [&](size_t i)
+	{
+		found += !!typedCache.find(BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, i % SUBTYPES));
+	});
+
+	EXPECT_EQ(found, 2 * ITERATIONS);
+}
+
+TEST_F(BonusCacheBenchmark, DISABLED_valOfBonuses)
+{
+	int total = 0;
+
+	Benchmark::measure("valOfBonuses, legacy string key", ITERATIONS, [&](size_t i)
+	{
+		std::stringstream cachingStr;
+		cachingStr << "type_" << Bonus::PRIMARY_SKILL << "s_" << (i % SUBTYPES);
+		total += stack.valOfBonuses(Selector::typeSubtype(Bonus::PRIMARY_SKILL, i % SUBTYPES), cachingStr.str());
+	});
+
+	Benchmark::measure("valOfBonuses, typed key", ITERATIONS, [&](size_t i)
+	{
+		total += stack.valOfBonuses(Bonus::PRIMARY_SKILL, i % SUBTYPES);
+	});
+
+	Benchmark::measure("Speed", ITERATIONS, [&](size_t i)
+	{
+		total += stack.Speed();
+	});
+
+	Benchmark::measure("MaxHealth", ITERATIONS, [&](size_t i)
+	{
+		total += stack.MaxHealth();
+	});
+
+	Benchmark::measure("getMinDamage", ITERATIONS, [&](size_t i)
+	{
+		total += stack.getMinDamage();
+	});
+
+	EXPECT_GT(total, 0);
+}
@@ -0,0 +1,63 @@
+/*
+ * FogOfWarBenchmark.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "Benchmark.h"
+
+#include "../lib/FogOfWarMap.h"
+
+namespace
+{
+	const size_t ITERATIONS = 200;
+	const int3 XL_TWO_LEVEL(144, 144, 2);
+
+	typedef std::vector<std::vector<std::vector<ui8>>> TLegacyFow;
+}
+
+TEST(FogOfWarBenchmark, DISABLED_revealAndScan)
+{
+	TLegacyFow legacy(XL_TWO_LEVEL.x, std::vector<std::vector<ui8>>(XL_TWO_LEVEL.y, std::vector<ui8>(XL_TWO_LEVEL.z, 0)));
+	FogOfWarMap packed(XL_TWO_LEVEL);
+	const int radius = 12;
+
+	Benchmark::measure("XL 144x144x2, legacy reveal radius", ITERATIONS, [&](size_t i)
+	{
+		const int3 center((i * 37) % XL_TWO_LEVEL.x, (i * 11) % XL_TWO_LEVEL.y, i % 2);
+		for(int y = std::max(center.y - radius, 0); y <= std::min(center.y + radius, XL_TWO_LEVEL.y - 1); y++)
+			for(int x = std::max(center.x - radius, 0); x <= std::min(center.x + radius, XL_TWO_LEVEL.x - 1); x++)
+				if(center.dist2d(int3(x, y, center.z)) - 0.5 <= radius)
+					legacy[x][y][center.z] = 1;
+	});
+
+	Benchmark::measure("XL 144x144x2, packed reveal radius", ITERATIONS, [&](size_t i)
+	{
+		const int3 center((i * 37) % XL_TWO_LEVEL.x, (i * 11) % XL_TWO_LEVEL.y, i % 2);
+		packed.revealRadius(center, radius);
+	});
+
+	size_t hidden[2] = {0, 0};
+	Benchmark::measure("XL 144x144x2, legacy hidden tiles scan", ITERATIONS, [&](size_t i)
+	{
+		for(int x = 0; x < XL_TWO_LEVEL.x; x++)
+			for(int y = 0; y < XL_TWO_LEVEL.y; y++)
+				for(int z = 0; z < XL_TWO_LEVEL.z; z++)
+					hidden[0] += legacy[x][y][z] ? 0 : 1;
+	});
+
+	Benchmark::measure("XL 144x144x2, packed hidden tiles scan", ITERATIONS, [&](size_t i)
+	{
+		packed.forEachTile(false, [&](const int3 & tile)
+		{
+			hidden[1]++;
+		});
+	});
+
+	EXPECT_EQ(hidden[0], hidden[1]);
+}
@@ -0,0 +1,76 @@
+/*
+ * MapTilesBenchmark.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "Benchmark.h"
+
+#include "../lib/filesystem/ResourceID.h"
+#include "../lib/mapping/CMap.h"
+#include "../lib/mapping/CMapService.h"
+
+namespace
+{
+	const size_t ITERATIONS = 200;
+
+	std::unique_ptr<CMap> createMap(int size)
+	{
+		auto map = make_unique<CMap>();
+		map->width = size;
+		map->height = size;
+		map->twoLevel = true;
+		map->initTerrain();
+		return map;
+	}
+
+	size_t countBlocked(const TerrainTile & tile)
+	{
+		return tile.blocked || tile.terType == ETerrainType::ROCK ? 1 : 0;
+	}
+}
+
+TEST(MapTilesBenchmark, DISABLED_fullScan)
+{
+	std::vector<std::pair<std::string, std::unique_ptr<CMap>>> maps;
+	maps.push_back(std::make_pair("test/TerrainViewTest", CMapService::loadMap(ResourceID("test/TerrainViewTest", EResType::MAP))));
+	maps.push_back(std::make_pair("XL 144x144x2", createMap(144)));
+	maps.push_back(std::make_pair("252x252x2", createMap(252)));
+
+	for(const auto & entry : maps)
+	{
+		const CMap * map = entry.second.get();
+		const int levels = map->twoLevel ? 2 : 1;
+		size_t blocked[3] = {0, 0, 0};
+
+		Benchmark::measure(entry.first + ", getTile x-y-z order", ITERATIONS, [&](size_t i)
+		{
+			for(int x = 0; x < map->width; x++)
+				for(int y = 0; y < map->height; y++)
+					for(int z = 0; z < levels; z++)
+						blocked[0] += countBlocked(map->getTile(int3(x, y, z)));
+		});
+
+		Benchmark::measure(entry.first + ", getTile z-y-x order", ITERATIONS, [&](size_t i)
+		{
+			for(int z = 0; z < levels; z++)
+				for(int y = 0; y < map->height; y++)
+					for(int x = 0; x < map->width; x++)
+						blocked[1] += countBlocked(map->getTile(int3(x, y, z)));
+		});
+
+		Benchmark::measure(entry.first + ", linear getTiles", ITERATIONS, [&](size_t i)
+		{
+			for(const auto & tile : map->getTiles())
+				blocked[2] += countBlocked(tile);
+		});
+
+		EXPECT_EQ(blocked[0], blocked[1]);
+		EXPECT_EQ(blocked[0], blocked[2]);
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ * PathfinderBenchmark.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "Benchmark.h"
+
+#include "../pathfinder/PathfinderTestGame.h"
+
+#include "../lib/mapObjects/CGHeroInstance.h"
+
+namespace
+{
+	const size_t ITERATIONS = 20;
+}
+
+TEST(PathfinderBenchmark, DISABLED_queues)
+{
+	const std::vector<std::pair<int, bool>> mapSizes = { {CMapHeader::MAP_SIZE_MIDDLE, false}, {CMapHeader::MAP_SIZE_LARGE, true} };
+
+	for(const auto & mapSize : mapSizes)
+	{
+		PathfinderTestGame game(1337, mapSize.first, mapSize.second);
+		const CGHeroInstance * hero = game.getHero(PlayerColor(0));
+		ASSERT_TRUE(hero);
+
+		const std::string name = boost::str(boost::format("%dx%d%s") % mapSize.first % mapSize.first % (mapSize.second ? "x2" : ""));
+		CPathsInfo heapPaths(game.getMapSize());
+		CPathsInfo bucketPaths(game.getMapSize());
+		CPathfinder::PathfinderOptions options;
+
+		options.useBucketQueue = false;
+		Benchmark::measure(name + ", binary heap", ITERATIONS, [&](size_t i)
+		{
+			CPathfinder(heapPaths, &game.gs, hero, options).calculatePaths();
+		});
+
+		options.useBucketQueue = true;
+		Benchmark::measure(name + ", bucket queue", ITERATIONS, [&](size_t i)
+		{
+			CPathfinder(bucketPaths, &game.gs, hero, options).calculatePaths();
+		});
+
+		comparePaths(heapPaths, bucketPaths);
+	}
+}
@@ -0,0 +1,129 @@
+/*
+ * RmgBenchmark.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "Benchmark.h"
+
+#include "../lib/VCMI_Lib.h"
+#include "../lib/mapping/CMap.h"
+#include "../lib/rmg/CMapGenerator.h"
+#include "../lib/rmg/CMapGenOptions.h"
+#include "../lib/rmg/CRmgTemplate.h"
+#include "../lib/rmg/CRmgTemplateStorage.h"
+
+#include "../map/MapHasher.h"
+
+#ifdef VCMI_WINDOWS
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+namespace
+{
+	const std::vector<int> MAP_SIZES = {CMapHeader::MAP_SIZE_SMALL, CMapHeader::MAP_SIZE_MIDDLE, CMapHeader::MAP_SIZE_LARGE, CMapHeader::MAP_SIZE_XLARGE};
+	const std::vector<int> SEEDS = {1337, 20170901};
+
+	/// High-water mark of resident memory of the whole process in kilobytes, it never decreases
+	size_t getPeakMemoryKb()
+	{
+#ifdef VCMI_WINDOWS
+		PROCESS_MEMORY_COUNTERS counters;
+		if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return 0;
+		return counters.PeakWorkingSetSize / 1024;
+#else
+		struct rusage usage;
+		if(getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0;
+	#ifdef VCMI_APPLE
+		return usage.ru_maxrss / 1024; //bytes
+	#else
+		return usage.ru_maxrss; //kilobytes
+	#endif
+#endif
+	}
+
+	CMapGenOptions makeOptions(const CRmgTemplate * tpl, int size, bool twoLevels, int playerCount)
+	{
+		CMapGenOptions opt;
+		opt.setWidth(size);
+		opt.setHeight(size);
+		opt.setHasTwoLevels(twoLevels);
+		opt.setPlayerCount(playerCount);
+		opt.setMapTemplate(tpl);
+		return opt;
+	}
+}
+
+/// Generates maps for every template with all sizes it supports, smallest and largest player count and several seeds.
+/// Prints time of each generation phase, process memory high-water mark with its increase caused by the map, and map hash.
+/// Increase is zero for maps that fit into memory used by earlier ones.
+/// Every map is generated twice to detect nondeterministic generation
+TEST(RmgBenchmark, DISABLED_templateMatrix)
+{
+	MapHasher hasher;
+
+	for(const auto & entry : VLC->tplh->getTemplates())
+	{
+		const CRmgTemplate * tpl = entry.second;
+		const auto allowedPlayers = tpl->getPlayers().getNumbers();
+		if(allowedPlayers.empty())
+			continue;
+		const std::set<int> playerCounts = {*allowedPlayers.begin(), *allowedPlayers.rbegin()};
+
+		for(int size : MAP_SIZES)
+		{
+			for(bool twoLevels : {false, true})
+			{
+				const CRmgTemplate::CSize mapSize(size, size, twoLevels);
+				if(!(mapSize >= tpl->getMinSize() && mapSize <= tpl->getMaxSize()))
+					continue;
+
+				for(int playerCount : playerCounts)
+				{
+					for(int seed : SEEDS)
+					{
+						const std::string name = boost::str(boost::format("%s %dx%dx%d, %d players, seed %d")
+							% tpl->getName() % size % size % (twoLevels ? 2 : 1) % playerCount % seed);
+						SCOPED_TRACE(name);
+
+						const size_t peakBefore = getPeakMemoryKb();
+						size_t hashes[2];
+						CMapGenerator::TPhaseTimings timings;
+						for(size_t run = 0; run < 2; run++)
+						{
+							CMapGenOptions opt = makeOptions(tpl, size, twoLevels, playerCount);
+							CMapGenerator gen;
+							auto map = gen.generate(&opt, seed);
+							hashes[run] = hasher(map.get());
+							if(run == 0)
+								timings = gen.getPhaseTimings();
+						}
+						EXPECT_EQ(hashes[0], hashes[1]) << "map generation is not deterministic";
+						const size_t peakAfter = getPeakMemoryKb();
+
+						si64 total = 0;
+						std::string phases;
+						for(const auto & phase : timings)
+						{
+							total += phase.second;
+							phases += boost::str(boost::format(" %s %.1f ms,") % phase.first % (phase.second / 1000.0));
+						}
+
+						std::cout << boost::format("[ BENCH    ] %-50s %10.1f ms total,%s process peak %d KB (+%d KB), hash %016x")
+							% name % (total / 1000.0) % phases % peakAfter % (peakAfter - peakBefore) % hashes[0] << std::endl;
+					}
+				}
+			}
+		}
+	}
+}
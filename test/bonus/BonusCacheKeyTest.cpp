@@ -0,0 +1,69 @@
+/*
+ * BonusCacheKeyTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../lib/HeroBonus.h"
+
+TEST(BonusCacheKeyTest, emptyKeyDisablesCaching)
+{
+	EXPECT_FALSE(BonusCacheKey().isValid());
+	EXPECT_FALSE(BonusCacheKey("").isValid());
+	EXPECT_FALSE(BonusCacheKey(std::string()).isValid());
+	EXPECT_TRUE(BonusCacheKey("type_1").isValid());
+}
+
+TEST(BonusCacheKeyTest, legacyStringKeys)
+{
+	EXPECT_EQ(BonusCacheKey("type_1s_2"), BonusCacheKey(std::string("type_1s_2")));
+	EXPECT_NE(BonusCacheKey("type_1s_2"), BonusCacheKey("type_1s_3"));
+	EXPECT_NE(BonusCacheKey("type_1"), BonusCacheKey::type(Bonus::BonusType(1)));
+}
+
+TEST(BonusCacheKeyTest, typedKeys)
+{
+	EXPECT_EQ(BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, 0), BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, 0));
+	EXPECT_NE(BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, 0), BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, 1));
+	EXPECT_NE(BonusCacheKey::type(Bonus::PRIMARY_SKILL), BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, 0));
+	EXPECT_NE(BonusCacheKey::type(Bonus::STACKS_SPEED).turns(0), BonusCacheKey::type(Bonus::STACKS_SPEED).turns(1));
+	EXPECT_NE(BonusCacheKey().turns(1), BonusCacheKey().days(1));
+	EXPECT_NE(BonusCacheKey::source(Bonus::SPELL_EFFECT, 5), BonusCacheKey::sourceType(Bonus::SPELL_EFFECT));
+	EXPECT_NE(BonusCacheKey::composite(BonusCacheKey::MIN_DAMAGE), BonusCacheKey::composite(BonusCacheKey::MAX_DAMAGE));
+}
+
+TEST(BonusQueryCacheTest, insertAndFind)
+{
+	BonusQueryCache subject;
+
+	EXPECT_FALSE(subject.find(BonusCacheKey::type(Bonus::MORALE)));
+
+	std::vector<TBonusListPtr> values;
+	for(int subtype = 0; subtype < 100; subtype++)
+	{
+		values.push_back(std::make_shared<BonusList>());
+		subject.insert(BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, subtype), values.back());
+	}
+
+	EXPECT_EQ(subject.size(), 100);
+
+	for(int subtype = 0; subtype < 100; subtype++)
+		EXPECT_EQ(subject.find(BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, subtype)), values[subtype]);
+
+	EXPECT_FALSE(subject.find(BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, 100)));
+	EXPECT_FALSE(subject.find(BonusCacheKey::type(Bonus::PRIMARY_SKILL)));
+
+	auto replacement = std::make_shared<BonusList>();
+	subject.insert(BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, 0), replacement);
+	EXPECT_EQ(subject.size(), 100);
+	EXPECT_EQ(subject.find(BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, 0)), replacement);
+
+	subject.clear();
+	EXPECT_EQ(subject.size(), 0);
+	EXPECT_FALSE(subject.find(BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, 1)));
+}
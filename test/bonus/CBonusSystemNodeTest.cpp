@@ -0,0 +1,120 @@
+/*
+ * CBonusSystemNodeTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../lib/HeroBonus.h"
+
+namespace
+{
+	std::shared_ptr<Bonus> makeAttackBonus(si32 val)
+	{
+		return std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::OTHER, val, 0, PrimarySkill::ATTACK);
+	}
+}
+
+/// Root with two children, first child has its own child
+struct CBonusSystemNodeTest : testing::Test
+{
+	CBonusSystemNode root, child, sibling, grandchild;
+
+	void SetUp() override
+	{
+		child.attachTo(&root);
+		sibling.attachTo(&root);
+		grandchild.attachTo(&child);
+	}
+
+	void TearDown() override
+	{
+		grandchild.detachFrom(&child);
+		sibling.detachFrom(&root);
+		child.detachFrom(&root);
+	}
+
+	/// Cached per node under type and subtype key
+	static int skill(const CBonusSystemNode & node, PrimarySkill::PrimarySkill which = PrimarySkill::ATTACK)
+	{
+		return node.valOfBonuses(Bonus::PRIMARY_SKILL, which);
+	}
+};
+
+TEST_F(CBonusSystemNodeTest, newBonusInvalidatesDescendantsOnly)
+{
+	EXPECT_EQ(0, skill(grandchild));
+	EXPECT_EQ(0, skill(sibling));
+	const int64_t siblingVersion = sibling.getTreeVersion();
+	const int64_t rootVersion = root.getTreeVersion();
+
+	child.addNewBonus(makeAttackBonus(3));
+
+	EXPECT_EQ(3, skill(child));
+	EXPECT_EQ(3, skill(grandchild));
+	EXPECT_EQ(0, skill(sibling));
+	EXPECT_EQ(siblingVersion, sibling.getTreeVersion());
+	EXPECT_EQ(rootVersion, root.getTreeVersion());
+}
+
+TEST_F(CBonusSystemNodeTest, attachingAndDetachingAncestorInvalidatesDescendants)
+{
+	CBonusSystemNode source;
+	source.addNewBonus(makeAttackBonus(5));
+
+	EXPECT_EQ(0, skill(grandchild));
+	const int64_t siblingVersion = sibling.getTreeVersion();
+
+	child.attachTo(&source);
+	EXPECT_EQ(5, skill(grandchild));
+	EXPECT_EQ(0, skill(sibling));
+
+	child.detachFrom(&source);
+	EXPECT_EQ(0, skill(grandchild));
+	EXPECT_EQ(siblingVersion, sibling.getTreeVersion());
+}
+
+TEST_F(CBonusSystemNodeTest, removedBonusIsNotServedFromCache)
+{
+	auto bonus = makeAttackBonus(4);
+	root.addNewBonus(bonus);
+	EXPECT_EQ(4, skill(grandchild));
+	EXPECT_EQ(4, skill(sibling));
+
+	root.removeBonus(bonus);
+	EXPECT_EQ(0, skill(grandchild));
+	EXPECT_EQ(0, skill(sibling));
+}
+
+TEST_F(CBonusSystemNodeTest, inPlaceChangeIsVisibleAfterNodeHasChanged)
+{
+	auto bonus = makeAttackBonus(2);
+	child.addNewBonus(bonus);
+	EXPECT_EQ(2, skill(grandchild));
+
+	//bonus objects are shared, nodes learn about their changes only when told
+	bonus->subtype = PrimarySkill::DEFENSE;
+	EXPECT_EQ(2, skill(grandchild));
+
+	const int64_t siblingVersion = sibling.getTreeVersion();
+	child.nodeHasChanged();
+	EXPECT_EQ(0, skill(child));
+	EXPECT_EQ(0, skill(grandchild));
+	EXPECT_EQ(2, skill(grandchild, PrimarySkill::DEFENSE));
+	EXPECT_EQ(siblingVersion, sibling.getTreeVersion());
+}
+
+TEST_F(CBonusSystemNodeTest, directBonusListChangeInvalidatesOwner)
+{
+	EXPECT_EQ(0, skill(grandchild));
+	const int64_t siblingVersion = sibling.getTreeVersion();
+
+	child.exportBonus(makeAttackBonus(7));
+
+	EXPECT_EQ(7, skill(grandchild));
+	EXPECT_EQ(siblingVersion, sibling.getTreeVersion());
+}
@@ -0,0 +1,137 @@
+/*
+ * CMapInfoCacheTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "../lib/mapping/CMapInfoCache.h"
+#include "../lib/filesystem/Filesystem.h"
+#include "../lib/filesystem/AdapterLoaders.h"
+#include "../lib/filesystem/CFilesystemLoader.h"
+
+/// Fake maps in temporary directory mounted under unique prefix, parser takes file content as date of map
+struct CMapInfoCacheTest : testing::Test
+{
+	static const ui32 MODS_CHECKSUM = 0x1234;
+
+	boost::filesystem::path dir;
+	boost::filesystem::path cacheFile;
+	std::string mountPoint;
+	std::unordered_set<ResourceID> files;
+	std::atomic<int> parsed;
+
+	CMapInfoCache::TParser parser;
+
+	void SetUp() override
+	{
+		dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("vcmi-mapinfo-%%%%%%%%");
+		boost::filesystem::create_directories(dir / "maps");
+		cacheFile = dir / "cache.bin";
+		mountPoint = boost::filesystem::unique_path("MAPINFOCACHETEST%%%%%%%%/").string();
+
+		writeMap("A.h3m", "first");
+		writeMap("B.h3m", "second");
+		writeMap("C.h3m", "third");
+		dynamic_cast<CFilesystemList *>(CResourceHandler::get())->addLoader(new CFilesystemLoader(mountPoint, dir / "maps"), false);
+
+		for(auto name : {"A.h3m", "B.h3m", "C.h3m"})
+			files.insert(ResourceID(mountPoint + name));
+
+		parsed = 0;
+		parser = [this](CMapInfo & info, const ResourceID & file)
+		{
+			std::ifstream stream(CResourceHandler::get()->getResourceName(file)->string());
+			if(!stream)
+				throw std::runtime_error("Cannot open " + file.getName());
+			info.fileURI = file.getName();
+			std::getline(stream, info.date);
+			parsed++;
+		};
+	}
+
+	void TearDown() override
+	{
+		boost::filesystem::remove_all(dir);
+	}
+
+	void writeMap(const std::string & name, const std::string & content)
+	{
+		std::ofstream file((dir / "maps" / name).string());
+		file << content;
+	}
+
+	std::map<std::string, std::string> scan(ui32 modsChecksum = MODS_CHECKSUM)
+	{
+		std::map<std::string, std::string> ret;
+		for(auto & info : CMapInfoCache::scan(cacheFile, modsChecksum, files, parser))
+			ret[info.fileURI] = info.date;
+		return ret;
+	}
+};
+
+TEST_F(CMapInfoCacheTest, unchangedFilesAreServedFromCache)
+{
+	const auto first = scan();
+	EXPECT_EQ(3, parsed);
+	EXPECT_TRUE(boost::filesystem::exists(cacheFile));
+
+	parsed = 0;
+	EXPECT_EQ(first, scan());
+	EXPECT_EQ(0, parsed);
+	EXPECT_EQ("second", first.at(ResourceID(mountPoint + "B.h3m").getName()));
+}
+
+TEST_F(CMapInfoCacheTest, changedFileIsParsedAgain)
+{
+	scan();
+
+	const auto path = dir / "maps" / "B.h3m";
+	const auto modified = boost::filesystem::last_write_time(path);
+	writeMap("B.h3m", "SECOND");
+	boost::filesystem::last_write_time(path, modified + 10);
+
+	parsed = 0;
+	const auto infos = scan();
+	EXPECT_EQ(1, parsed);
+	EXPECT_EQ("SECOND", infos.at(ResourceID(mountPoint + "B.h3m").getName()));
+	EXPECT_EQ("first", infos.at(ResourceID(mountPoint + "A.h3m").getName()));
+}
+
+TEST_F(CMapInfoCacheTest, removedFileIsDropped)
+{
+	scan();
+
+	boost::filesystem::remove(dir / "maps" / "C.h3m");
+	parsed = 0;
+	auto infos = scan();
+	EXPECT_EQ(0, parsed);
+	EXPECT_EQ(2, infos.size());
+	EXPECT_FALSE(vstd::contains(infos, ResourceID(mountPoint + "C.h3m").getName()));
+
+	//entry of removed file is dropped from cache file, so recreated file is never mistaken for old one
+	writeMap("C.h3m", "THIRD");
+	parsed = 0;
+	infos = scan();
+	EXPECT_EQ(1, parsed);
+	EXPECT_EQ("THIRD", infos.at(ResourceID(mountPoint + "C.h3m").getName()));
+}
+
+TEST_F(CMapInfoCacheTest, cacheOfOtherModsIsIgnored)
+{
+	scan();
+
+	parsed = 0;
+	scan(MODS_CHECKSUM + 1);
+	EXPECT_EQ(3, parsed);
+
+	//cache is rewritten for current mods
+	parsed = 0;
+	scan(MODS_CHECKSUM + 1);
+	EXPECT_EQ(0, parsed);
+}
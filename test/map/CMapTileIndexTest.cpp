@@ -0,0 +1,40 @@
+/*
+ * CMapTileIndexTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "../lib/mapping/CMap.h"
+
+TEST(CMapTileIndexTest, indexIsZMajorAndReversible)
+{
+	CMap map;
+	map.width = 5;
+	map.height = 3;
+	map.twoLevel = true;
+	map.initTerrain();
+
+	ASSERT_EQ(5 * 3 * 2, map.getTiles().size());
+
+	size_t expected = 0;
+	for(int z = 0; z < 2; z++)
+	{
+		for(int y = 0; y < map.height; y++)
+		{
+			for(int x = 0; x < map.width; x++)
+			{
+				const int3 pos(x, y, z);
+				EXPECT_EQ(expected, map.getTileIndex(pos));
+				EXPECT_EQ(pos, map.getTilePos(expected));
+				EXPECT_EQ(&map.getTiles()[expected], &map.getTile(pos));
+				expected++;
+			}
+		}
+	}
+}
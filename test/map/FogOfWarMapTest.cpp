@@ -0,0 +1,156 @@
+/*
+ * FogOfWarMapTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "../lib/FogOfWarMap.h"
+
+namespace
+{
+	bool inRange(const int3 & center, const int3 & tile, int radius, bool patrolDistance)
+	{
+		const double distance = patrolDistance ? center.mandist2d(tile) : center.dist2d(tile) - 0.5;
+		return distance <= radius;
+	}
+}
+
+TEST(FogOfWarMapTest, setAndQuerySingleTiles)
+{
+	FogOfWarMap fow(int3(70, 3, 2));
+
+	EXPECT_EQ(0, fow.countVisible());
+
+	fow.reveal(int3(0, 0, 0));
+	fow.reveal(int3(63, 1, 1));
+	fow.reveal(int3(64, 1, 1));
+	fow.reveal(int3(69, 2, 1));
+
+	EXPECT_TRUE(fow.isVisible(int3(0, 0, 0)));
+	EXPECT_TRUE(fow.isVisible(int3(63, 1, 1)));
+	EXPECT_TRUE(fow.isVisible(int3(64, 1, 1)));
+	EXPECT_TRUE(fow.isVisible(int3(69, 2, 1)));
+	EXPECT_FALSE(fow.isVisible(int3(63, 1, 0)));
+	EXPECT_FALSE(fow.isVisible(int3(0, 1, 0)));
+	EXPECT_EQ(4, fow.countVisible());
+
+	fow.hide(int3(64, 1, 1));
+	EXPECT_FALSE(fow.isVisible(int3(64, 1, 1)));
+	EXPECT_TRUE(fow.isVisible(int3(63, 1, 1)));
+	EXPECT_EQ(3, fow.countVisible());
+}
+
+TEST(FogOfWarMapTest, spansAreClippedAndCrossWords)
+{
+	FogOfWarMap fow(int3(200, 2, 1));
+
+	fow.setSpan(-10, 130, 0, 0, true);
+	fow.setSpan(190, 250, 1, 0, true);
+	fow.setSpan(0, 10, 5, 0, true);
+
+	EXPECT_EQ(131 + 10, fow.countVisible());
+	for(int x = 0; x < 200; x++)
+	{
+		EXPECT_EQ(x <= 130, fow.isVisible(int3(x, 0, 0)));
+		EXPECT_EQ(x >= 190, fow.isVisible(int3(x, 1, 0)));
+	}
+
+	fow.setSpan(60, 70, 0, 0, false);
+	EXPECT_EQ(131 + 10 - 11, fow.countVisible());
+
+	std::vector<int3> hidden;
+	fow.forEachInSpan(50, 80, 0, 0, false, [&](const int3 & tile)
+	{
+		hidden.push_back(tile);
+	});
+	ASSERT_EQ(11, hidden.size());
+	for(int i = 0; i < 11; i++)
+		EXPECT_EQ(int3(60 + i, 0, 0), hidden[i]);
+
+	fow.setAll(true);
+	EXPECT_EQ(400, fow.countVisible());
+}
+
+TEST(FogOfWarMapTest, revealRadiusMatchesDistanceRules)
+{
+	for(bool patrolDistance : {false, true})
+	{
+		for(int radius : {0, 1, 3, 8, 15})
+		{
+			FogOfWarMap fow(int3(40, 30, 2));
+			const int3 center(5, 20, 1);
+			fow.revealRadius(center, radius, patrolDistance);
+
+			for(int z = 0; z < 2; z++)
+				for(int y = 0; y < 30; y++)
+					for(int x = 0; x < 40; x++)
+					{
+						const int3 tile(x, y, z);
+						EXPECT_EQ(z == center.z && inRange(center, tile, radius, patrolDistance), fow.isVisible(tile))
+							<< "radius " << radius << " at " << tile.toString();
+					}
+		}
+	}
+
+	FogOfWarMap fow(int3(10, 10, 2));
+	fow.revealRadius(int3(3, 3, 0), -1);
+	EXPECT_EQ(200, fow.countVisible());
+}
+
+TEST(FogOfWarMapTest, forEachTileAndDifference)
+{
+	FogOfWarMap first(int3(100, 4, 2));
+	first.setSpan(10, 80, 2, 1, true);
+	FogOfWarMap second = first;
+	EXPECT_TRUE(first == second);
+
+	size_t visible = 0, hidden = 0;
+	first.forEachTile(true, [&](const int3 & tile)
+	{
+		EXPECT_TRUE(first.isVisible(tile));
+		visible++;
+	});
+	first.forEachTile(false, [&](const int3 & tile)
+	{
+		EXPECT_FALSE(first.isVisible(tile));
+		hidden++;
+	});
+	EXPECT_EQ(71, visible);
+	EXPECT_EQ(800 - 71, hidden);
+
+	second.hide(int3(10, 2, 1));
+	second.reveal(int3(99, 3, 0));
+	EXPECT_TRUE(first != second);
+
+	std::vector<std::pair<int3, bool>> differences;
+	first.forEachDifference(second, [&](const int3 & tile, bool visibleHere)
+	{
+		differences.push_back(std::make_pair(tile, visibleHere));
+	});
+	ASSERT_EQ(2, differences.size());
+	EXPECT_EQ(int3(99, 3, 0), differences[0].first);
+	EXPECT_FALSE(differences[0].second);
+	EXPECT_EQ(int3(10, 2, 1), differences[1].first);
+	EXPECT_TRUE(differences[1].second);
+}
+
+TEST(FogOfWarMapTest, loadsLegacyArray)
+{
+	std::vector<std::vector<std::vector<ui8>>> legacy(3, std::vector<std::vector<ui8>>(2, std::vector<ui8>(2, 0)));
+	legacy[2][1][1] = 1;
+	legacy[0][1][0] = 1;
+
+	FogOfWarMap fow;
+	fow.loadLegacy(legacy);
+
+	EXPECT_EQ(int3(3, 2, 2), fow.getSizes());
+	EXPECT_EQ(2, fow.countVisible());
+	EXPECT_TRUE(fow.isVisible(int3(2, 1, 1)));
+	EXPECT_TRUE(fow.isVisible(int3(0, 1, 0)));
+}
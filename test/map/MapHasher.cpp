@@ -0,0 +1,69 @@
+/*
+ * MapHasher.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "MapHasher.h"
+
+#include "../lib/mapping/CMap.h"
+
+namespace
+{
+	void hashPos(size_t & seed, const int3 & pos)
+	{
+		boost::hash_combine(seed, pos.x);
+		boost::hash_combine(seed, pos.y);
+		boost::hash_combine(seed, pos.z);
+	}
+}
+
+size_t MapHasher::operator() (const CMap * map) const
+{
+	size_t seed = 0;
+
+	boost::hash_combine(seed, map->width);
+	boost::hash_combine(seed, map->height);
+	boost::hash_combine(seed, map->twoLevel);
+	hashPos(seed, map->grailPos);
+
+	for(const PlayerInfo & player : map->players)
+	{
+		boost::hash_combine(seed, player.canHumanPlay);
+		boost::hash_combine(seed, player.canComputerPlay);
+		boost::hash_combine(seed, player.team.getNum());
+		hashPos(seed, player.posOfMainTown);
+	}
+
+	for(const TerrainTile & tile : map->getTiles())
+	{
+		boost::hash_combine(seed, static_cast<int>(tile.terType));
+		boost::hash_combine(seed, tile.terView);
+		boost::hash_combine(seed, static_cast<int>(tile.riverType));
+		boost::hash_combine(seed, tile.riverDir);
+		boost::hash_combine(seed, static_cast<int>(tile.roadType));
+		boost::hash_combine(seed, tile.roadDir);
+		boost::hash_combine(seed, tile.extTileFlags);
+		boost::hash_combine(seed, tile.visitable);
+		boost::hash_combine(seed, tile.blocked);
+	}
+
+	for(const auto & object : map->objects)
+	{
+		if(!object)
+			continue;
+		boost::hash_combine(seed, object->ID.num);
+		boost::hash_combine(seed, object->subID);
+		boost::hash_combine(seed, object->tempOwner.getNum());
+		boost::hash_combine(seed, object->instanceName);
+		boost::hash_combine(seed, object->appearance.animationFile);
+		hashPos(seed, object->pos);
+	}
+
+	return seed;
+}
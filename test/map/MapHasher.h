@@ -0,0 +1,19 @@
+/*
+ * MapHasher.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#pragma once
+
+class CMap;
+
+/// Hash of map terrain and objects. Two maps generated with the same options and seed must have the same hash
+struct MapHasher
+{
+	size_t operator() (const CMap * map) const;
+};
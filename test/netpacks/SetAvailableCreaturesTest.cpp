@@ -0,0 +1,113 @@
+/*
+ * SetAvailableCreaturesTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "../lib/NetPacks.h"
+#include "../lib/CRandomGenerator.h"
+#include "../lib/mapObjects/CGTownInstance.h"
+#include "../lib/serializer/CMemorySerializer.h"
+
+namespace
+{
+	const size_t LEVELS = 4;
+
+	SetAvailableCreatures transfer(const SetAvailableCreatures & sent)
+	{
+		CMemorySerializer mem;
+		mem.oser & sent;
+
+		SetAvailableCreatures received;
+		mem.iser & received;
+		return received;
+	}
+
+	/// Changes counts (and rarely creature types) of a random level, the way server does during game
+	CGDwelling::TCreaturesSet nextState(const CGDwelling::TCreaturesSet & current, CRandomGenerator & rand)
+	{
+		CGDwelling::TCreaturesSet state = current;
+		auto & level = state.at(rand.nextInt(LEVELS - 1));
+		if(rand.nextInt(9) == 0)
+			level.second.push_back(CreatureID(rand.nextInt(100)));
+		else
+			level.first = rand.nextInt(50);
+		return state;
+	}
+}
+
+TEST(SetAvailableCreaturesTest, replayedDeltasKeepClientInSync)
+{
+	CGDwelling server, client;
+	server.creatures.resize(LEVELS);
+	for(size_t level = 0; level < LEVELS; level++)
+		server.creatures[level].second.push_back(CreatureID(level));
+	client.creatures = server.creatures;
+
+	CRandomGenerator rand;
+	rand.setSeed(42);
+	size_t deltas = 0;
+
+	for(int step = 0; step < 500; step++)
+	{
+		SetAvailableCreatures pack;
+		pack.creatures = nextState(server.creatures, rand);
+		const auto expected = pack.creatures;
+
+		if(!pack.encodeDelta(&server))
+			continue;
+		if(!pack.full)
+		{
+			EXPECT_TRUE(pack.creatures.empty());
+			deltas++;
+		}
+
+		EXPECT_TRUE(pack.applyTo(&server));
+		EXPECT_TRUE(transfer(pack).applyTo(&client));
+
+		ASSERT_EQ(expected, server.creatures);
+		ASSERT_EQ(server.creatures, client.creatures);
+		ASSERT_EQ(server.creaturesVersion, client.creaturesVersion);
+	}
+	EXPECT_GT(deltas, 0);
+}
+
+TEST(SetAvailableCreaturesTest, missedDeltaIsDetectedAndResynced)
+{
+	CGDwelling server, client;
+	server.creatures.resize(1);
+	server.creatures[0] = std::make_pair(10, std::vector<CreatureID>(1, CreatureID(1)));
+	client.creatures = server.creatures;
+
+	SetAvailableCreatures lost;
+	lost.creatures = server.creatures;
+	lost.creatures[0].first = 5;
+	ASSERT_TRUE(lost.encodeDelta(&server));
+	EXPECT_FALSE(lost.full);
+	lost.applyTo(&server);
+
+	SetAvailableCreatures next;
+	next.creatures = server.creatures;
+	next.creatures[0].first = 3;
+	ASSERT_TRUE(next.encodeDelta(&server));
+	next.applyTo(&server);
+
+	EXPECT_FALSE(transfer(next).applyTo(&client));
+	EXPECT_EQ(10, client.creatures[0].first);
+	EXPECT_NE(server.creaturesVersion, client.creaturesVersion);
+
+	SetAvailableCreatures resync;
+	resync.creatures = server.creatures;
+	resync.version = server.creaturesVersion + 1;
+	resync.applyTo(&server);
+	EXPECT_TRUE(transfer(resync).applyTo(&client));
+
+	EXPECT_EQ(server.creatures, client.creatures);
+	EXPECT_EQ(server.creaturesVersion, client.creaturesVersion);
+}
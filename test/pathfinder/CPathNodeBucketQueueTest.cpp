@@ -0,0 +1,90 @@
+/*
+ * CPathNodeBucketQueueTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "../lib/CPathfinder.h"
+#include "../lib/CRandomGenerator.h"
+
+namespace
+{
+	bool isBefore(const CGPathNode * lhs, const CGPathNode * rhs)
+	{
+		if(lhs->turns != rhs->turns)
+			return lhs->turns < rhs->turns;
+		return lhs->moveRemains > rhs->moveRemains;
+	}
+}
+
+TEST(CPathNodeBucketQueueTest, popsInCostOrder)
+{
+	CRandomGenerator rand;
+	rand.setSeed(42);
+	std::vector<CGPathNode> nodes(1000);
+	CPathNodeBucketQueue queue;
+
+	for(auto & node : nodes)
+	{
+		node.turns = rand.nextInt(0, 5);
+		node.moveRemains = rand.nextInt(0, 2000);
+		queue.push(&node);
+	}
+
+	const CGPathNode * previous = nullptr;
+	size_t popped = 0;
+	while(!queue.empty())
+	{
+		const CGPathNode * node = queue.pop();
+		if(previous)
+		{
+			EXPECT_FALSE(isBefore(node, previous));
+		}
+		previous = node;
+		popped++;
+	}
+	EXPECT_EQ(nodes.size(), popped);
+}
+
+TEST(CPathNodeBucketQueueTest, acceptsPushBelowPoppedCost)
+{
+	CGPathNode first, second, third;
+	first.turns = 1;
+	first.moveRemains = 100;
+	second.turns = 1;
+	second.moveRemains = 50;
+	third.turns = 0;
+	third.moveRemains = 10;
+
+	CPathNodeBucketQueue queue;
+	queue.push(&first);
+	queue.push(&second);
+	EXPECT_EQ(&first, queue.pop());
+
+	queue.push(&third);
+	EXPECT_EQ(&third, queue.pop());
+	EXPECT_EQ(&second, queue.pop());
+	EXPECT_TRUE(queue.empty());
+}
+
+TEST(CPathNodeBucketQueueTest, clearKeepsQueueUsable)
+{
+	CGPathNode node;
+	node.turns = 2;
+	node.moveRemains = 300;
+
+	CPathNodeBucketQueue queue;
+	queue.push(&node);
+	queue.clear();
+	EXPECT_TRUE(queue.empty());
+
+	queue.push(&node);
+	EXPECT_EQ(&node, queue.pop());
+	EXPECT_TRUE(queue.empty());
+}
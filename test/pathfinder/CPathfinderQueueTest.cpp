@@ -0,0 +1,73 @@
+/*
+ * CPathfinderQueueTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "PathfinderTestGame.h"
+
+#include "../lib/mapObjects/CGHeroInstance.h"
+
+namespace
+{
+	/// Paths of hero calculated with both queues have to be the same
+	void compareQueues(PathfinderTestGame & game, const CGHeroInstance * hero)
+	{
+		CPathfinder::PathfinderOptions options;
+
+		options.useBucketQueue = false;
+		CPathsInfo heapPaths(game.getMapSize());
+		CPathfinder(heapPaths, &game.gs, hero, options).calculatePaths();
+
+		options.useBucketQueue = true;
+		CPathsInfo bucketPaths(game.getMapSize());
+		CPathfinder(bucketPaths, &game.gs, hero, options).calculatePaths();
+
+		comparePaths(heapPaths, bucketPaths);
+	}
+}
+
+TEST(CPathfinderQueueTest, bucketQueueGivesSamePathsAsBinaryHeap)
+{
+	for(int seed : {1337, 42})
+	{
+		PathfinderTestGame game(seed);
+		for(int player = 0; player < 2; player++)
+		{
+			SCOPED_TRACE(boost::str(boost::format("seed %d, player %d") % seed % player));
+			CGHeroInstance * hero = game.getHero(PlayerColor(player));
+			ASSERT_TRUE(hero);
+			compareQueues(game, hero);
+		}
+	}
+}
+
+TEST(CPathfinderQueueTest, bucketQueueGivesSamePathsAsBinaryHeapUnderground)
+{
+	PathfinderTestGame game(7, CMapHeader::MAP_SIZE_MIDDLE, true);
+	CGHeroInstance * hero = game.getHero(PlayerColor(0));
+	ASSERT_TRUE(hero);
+	compareQueues(game, hero);
+}
+
+TEST(CPathfinderQueueTest, bucketQueueGivesSamePathsAsBinaryHeapWithMovementSpent)
+{
+	PathfinderTestGame game(1337);
+	CGHeroInstance * hero = game.getHero(PlayerColor(0));
+	ASSERT_TRUE(hero);
+
+	//first turn ends after few steps, so most nodes are reached in later turns
+	const int maxMovement = hero->movement;
+	for(int movement : {0, 150, maxMovement - 1})
+	{
+		SCOPED_TRACE(boost::str(boost::format("movement %d") % movement));
+		hero->movement = movement;
+		compareQueues(game, hero);
+	}
+}
@@ -0,0 +1,158 @@
+/*
+ * CPathfinderRepairTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "PathfinderTestGame.h"
+
+#include "../lib/NetPacks.h"
+#include "../lib/mapObjects/CGHeroInstance.h"
+#include "../lib/mapping/CMap.h"
+
+/// Paths repaired after a change of the game state have to be the same as calculated from scratch
+struct CPathfinderRepairTest : testing::Test
+{
+	typedef std::unordered_set<int3, ShashInt3> TTiles;
+
+	PathfinderTestGame game;
+	CGHeroInstance * hero;
+	CPathfinder::PathfinderOptions options;
+	std::unique_ptr<CPathsInfo> paths;
+
+	CPathfinderRepairTest()
+		: game(1337), hero(nullptr)
+	{
+		options.incremental = true;
+	}
+
+	void SetUp() override
+	{
+		hero = game.getHero(PlayerColor(0));
+		ASSERT_TRUE(hero);
+
+		paths = make_unique<CPathsInfo>(game.getMapSize());
+		CPathfinder(*paths, &game.gs, hero, options).calculatePaths();
+	}
+
+	void repairAndCompare(const TTiles & changedTiles)
+	{
+		paths->changedTiles = changedTiles;
+		ASSERT_TRUE(CPathfinder(*paths, &game.gs, hero, options).repairPaths());
+
+		CPathsInfo expected(game.getMapSize());
+		CPathfinder(expected, &game.gs, hero, options).calculatePaths();
+		comparePaths(expected, *paths);
+	}
+
+	/// Empty land tile at given distance from hero, reachable in current turn
+	const CGPathNode * findFreeNode(int distance) const
+	{
+		const int3 heroPos = hero->getPosition(false);
+		for(size_t i = 0; i < paths->nodes.num_elements(); i++)
+		{
+			const CGPathNode * node = paths->nodes.data() + i;
+			if(node->layer != EPathfindingLayer::LAND || node->turns != 0 || !node->reachable())
+				continue;
+			if(node->accessible != CGPathNode::ACCESSIBLE || node->action != CGPathNode::NORMAL)
+				continue;
+			if(std::max(std::abs(node->coord.x - heroPos.x), std::abs(node->coord.y - heroPos.y)) != distance || node->coord.z != heroPos.z)
+				continue;
+
+			const TerrainTile & tile = game.gs.map->getTile(node->coord);
+			if(!tile.blocked && !tile.visitable)
+				return node;
+		}
+		return nullptr;
+	}
+
+	/// Same tiles as client passes when object appears or disappears
+	TTiles getAffectedTiles(const CGObjectInstance * obj) const
+	{
+		TTiles tiles;
+		for(const int3 & pos : obj->getBlockedPos())
+		{
+			for(int dx = -1; dx <= 1; dx++)
+			{
+				for(int dy = -1; dy <= 1; dy++)
+				{
+					if(game.gs.map->isInTheMap(pos + int3(dx, dy, 0)))
+						tiles.insert(pos + int3(dx, dy, 0));
+				}
+			}
+		}
+		return tiles;
+	}
+};
+
+TEST_F(CPathfinderRepairTest, heroMovedAlongPath)
+{
+	const CGPathNode * node = findFreeNode(1);
+	ASSERT_TRUE(node);
+
+	TryMoveHero move;
+	move.id = hero->id;
+	move.result = TryMoveHero::SUCCESS;
+	move.start = hero->pos;
+	move.end = CGHeroInstance::convertPosition(node->coord, true);
+	move.movePoints = node->moveRemains;
+	game.gs.getTilesInRange(move.fowRevealed, hero->getSightCenter() + (move.end - move.start), hero->getSightRadius(), hero->tempOwner, 1);
+	game.gs.apply(&move);
+
+	TTiles changedTiles = move.fowRevealed;
+	changedTiles.insert(move.start - int3(1, 0, 0));
+	changedTiles.insert(move.end - int3(1, 0, 0));
+	repairAndCompare(changedTiles);
+}
+
+TEST_F(CPathfinderRepairTest, objectRemoved)
+{
+	const int3 heroPos = hero->getPosition(false);
+	const CGObjectInstance * nearest = nullptr;
+	for(const CGObjectInstance * obj : game.gs.map->objects)
+	{
+		if(!obj || obj->ID == Obj::HERO || obj->ID == Obj::TOWN || obj->pos.z != heroPos.z || obj->getBlockedPos().empty())
+			continue;
+		if(!nearest || obj->visitablePos().dist2dSQ(heroPos) < nearest->visitablePos().dist2dSQ(heroPos))
+			nearest = obj;
+	}
+	ASSERT_TRUE(nearest);
+
+	const TTiles changedTiles = getAffectedTiles(nearest);
+	RemoveObject remove(nearest->id);
+	game.gs.apply(&remove);
+
+	repairAndCompare(changedTiles);
+}
+
+TEST_F(CPathfinderRepairTest, objectAdded)
+{
+	const CGPathNode * node = findFreeNode(3);
+	ASSERT_TRUE(node);
+
+	NewObject add;
+	add.ID = Obj::MONSTER;
+	add.subID = CreatureID::SKELETON;
+	add.pos = node->coord;
+	game.gs.apply(&add);
+
+	repairAndCompare(getAffectedTiles(game.gs.getObj(add.id)));
+}
+
+TEST_F(CPathfinderRepairTest, fogOfWarRevealed)
+{
+	FoWChange reveal;
+	reveal.player = hero->tempOwner;
+	reveal.mode = 1;
+	game.gs.getTilesInRange(reveal.tiles, hero->getSightCenter(), hero->getSightRadius() + 4, hero->tempOwner, 1);
+	ASSERT_FALSE(reveal.tiles.empty());
+	game.gs.apply(&reveal);
+
+	repairAndCompare(reveal.tiles);
+}
@@ -0,0 +1,87 @@
+/*
+ * PathfinderTestGame.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "PathfinderTestGame.h"
+
+#include "../lib/CPlayerState.h"
+#include "../lib/StartInfo.h"
+#include "../lib/mapObjects/CGHeroInstance.h"
+#include "../lib/mapping/CMap.h"
+#include "../lib/rmg/CMapGenOptions.h"
+
+PathfinderTestGame::PathfinderTestGame(int seed, int mapSize, bool twoLevels)
+{
+	auto options = std::make_shared<CMapGenOptions>();
+	options->setWidth(mapSize);
+	options->setHeight(mapSize);
+	options->setHasTwoLevels(twoLevels);
+	options->setPlayerCount(2);
+
+	StartInfo si;
+	si.mode = StartInfo::NEW_GAME;
+	si.seedToBeUsed = seed;
+	si.mapGenOptions = options;
+	gs.init(&si);
+}
+
+CGHeroInstance * PathfinderTestGame::getHero(PlayerColor player)
+{
+	auto state = gs.getPlayer(player);
+	if(!state || state->heroes.empty())
+		return nullptr;
+
+	CGHeroInstance * hero = state->heroes.front();
+	hero->movement = hero->maxMovePoints(true);
+	return hero;
+}
+
+int3 PathfinderTestGame::getMapSize() const
+{
+	return int3(gs.map->width, gs.map->height, gs.map->twoLevel ? 2 : 1);
+}
+
+void comparePaths(const CPathsInfo & expected, const CPathsInfo & actual)
+{
+	ASSERT_EQ(expected.sizes, actual.sizes);
+	EXPECT_EQ(expected.hero, actual.hero);
+	EXPECT_EQ(expected.hpos, actual.hpos);
+
+	auto sameCost = [](const CGPathNode * lhs, const CGPathNode * rhs)
+	{
+		return lhs->turns == rhs->turns && lhs->moveRemains == rhs->moveRemains;
+	};
+
+	int mismatches = 0;
+	for(size_t i = 0; i < expected.nodes.num_elements(); i++)
+	{
+		const CGPathNode * e = expected.nodes.data() + i;
+		const CGPathNode * a = actual.nodes.data() + i;
+
+		bool same = e->coord == a->coord && e->layer == a->layer && sameCost(e, a)
+			&& e->accessible == a->accessible && e->action == a->action && e->locked == a->locked
+			&& !e->theNodeBefore == !a->theNodeBefore;
+
+		if(same && e->theNodeBefore && (e->theNodeBefore->coord != a->theNodeBefore->coord || e->theNodeBefore->layer != a->theNodeBefore->layer))
+		{
+			//node before in actual paths has to be as good in expected ones
+			const CGPathNode * alternative = expected.nodes.data() + (a->theNodeBefore - actual.nodes.data());
+			same = sameCost(alternative, a->theNodeBefore) && sameCost(alternative, e->theNodeBefore);
+		}
+
+		if(!same && mismatches++ == 0)
+		{
+			ADD_FAILURE() << "First mismatch at " << e->coord.toString() << " layer " << e->layer
+				<< ": expected turns " << static_cast<int>(e->turns) << " moveRemains " << e->moveRemains << " action " << static_cast<int>(e->action)
+				<< ", actual turns " << static_cast<int>(a->turns) << " moveRemains " << a->moveRemains << " action " << static_cast<int>(a->action);
+		}
+	}
+	EXPECT_EQ(0, mismatches);
+}
@@ -0,0 +1,31 @@
+/*
+ * PathfinderTestGame.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "../lib/CGameState.h"
+#include "../lib/CPathfinder.h"
+#include "../lib/mapping/CMap.h"
+
+class CGHeroInstance;
+
+/// New game on random map with starting heroes placed at main towns
+struct PathfinderTestGame
+{
+	CGameState gs;
+
+	explicit PathfinderTestGame(int seed, int mapSize = CMapHeader::MAP_SIZE_SMALL, bool twoLevels = false);
+
+	CGHeroInstance * getHero(PlayerColor player); //first hero of player with full movement points
+	int3 getMapSize() const;
+};
+
+/// Expects same turns, movement points, actions and accessibility of every node.
+/// Previous nodes may differ only if both give the same turns and movement points, ties can be broken either way.
+void comparePaths(const CPathsInfo & expected, const CPathsInfo & actual);
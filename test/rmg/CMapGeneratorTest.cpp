@@ -0,0 +1,55 @@
+/*
+ * CMapGeneratorTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "../lib/mapping/CMap.h"
+#include "../lib/rmg/CMapGenerator.h"
+#include "../lib/rmg/CMapGenOptions.h"
+
+#include "../map/MapHasher.h"
+
+namespace
+{
+	std::unique_ptr<CMap> generateSmallMap(int seed, CMapGenerator::TPhaseTimings * timings = nullptr)
+	{
+		CMapGenOptions opt;
+		opt.setWidth(CMapHeader::MAP_SIZE_SMALL);
+		opt.setHeight(CMapHeader::MAP_SIZE_SMALL);
+		opt.setHasTwoLevels(false);
+		opt.setPlayerCount(2);
+
+		CMapGenerator gen;
+		auto map = gen.generate(&opt, seed);
+		if(timings)
+			*timings = gen.getPhaseTimings();
+		return map;
+	}
+}
+
+TEST(CMapGeneratorTest, sameSeedGivesSameMap)
+{
+	MapHasher hasher;
+
+	CMapGenerator::TPhaseTimings timings;
+	auto first = generateSmallMap(1337, &timings);
+	auto second = generateSmallMap(1337);
+
+	EXPECT_EQ(hasher(first.get()), hasher(second.get()));
+
+	std::vector<std::string> phases;
+	for(const auto & phase : timings)
+	{
+		phases.push_back(phase.first);
+		EXPECT_GE(phase.second, 0);
+	}
+	const std::vector<std::string> expectedPhases = {"init", "zone placement", "fill zones", "obstacles", "roads"};
+	EXPECT_EQ(expectedPhases, phases);
+}
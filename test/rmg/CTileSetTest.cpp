@@ -0,0 +1,68 @@
+/*
+ * CTileSetTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "../lib/rmg/CTileSet.h"
+#include "../lib/CRandomGenerator.h"
+
+TEST(CTileSetTest, matchesStdSet)
+{
+	const int3 sizes(67, 31, 2);
+	CTileSet tiles(sizes);
+	std::set<int3> reference;
+	CRandomGenerator rand;
+	rand.setSeed(42);
+
+	for(int i = 0; i < 3000; i++)
+	{
+		const int3 tile(rand.nextInt(sizes.x - 1), rand.nextInt(sizes.y - 1), rand.nextInt(sizes.z - 1));
+		if(rand.nextInt(1))
+			EXPECT_EQ(reference.erase(tile) > 0, tiles.erase(tile)) << tile.toString();
+		else
+			EXPECT_EQ(reference.insert(tile).second, tiles.insert(tile)) << tile.toString();
+	}
+
+	EXPECT_EQ(reference.size(), tiles.size());
+	EXPECT_TRUE(std::equal(reference.begin(), reference.end(), tiles.begin()));
+	EXPECT_EQ(reference.size(), std::distance(tiles.begin(), tiles.end()));
+
+	EXPECT_FALSE(tiles.insert(int3(-1, 0, 0)));
+	EXPECT_FALSE(tiles.contains(int3(sizes.x, 0, 0)));
+
+	tiles.clear();
+	EXPECT_TRUE(tiles.empty());
+	EXPECT_TRUE(tiles.begin() == tiles.end());
+}
+
+TEST(CTileSetTest, eraseIfAndForEachInRect)
+{
+	CTileSet tiles(int3(10, 10, 2));
+	for(int z = 0; z < 2; z++)
+		for(int y = 0; y < 10; y++)
+			for(int x = 0; x < 10; x++)
+				tiles.insert(int3(x, y, z));
+
+	tiles.eraseIf([](const int3 & tile)
+	{
+		return tile.x % 2 == 0;
+	});
+	EXPECT_EQ(100, tiles.size());
+	EXPECT_FALSE(tiles.contains(int3(4, 3, 1)));
+	EXPECT_TRUE(tiles.contains(int3(5, 3, 1)));
+
+	std::vector<int3> found;
+	tiles.forEachInRect(-3, 8, 2, 12, [&](const int3 & tile)
+	{
+		found.push_back(tile);
+	});
+	const std::vector<int3> expected = {int3(1, 8, 0), int3(1, 9, 0), int3(1, 8, 1), int3(1, 9, 1)};
+	EXPECT_EQ(expected, found);
+}
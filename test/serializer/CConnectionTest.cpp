@@ -0,0 +1,121 @@
+/*
+ * CConnectionTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include <boost/asio.hpp>
+
+#include "../lib/serializer/Connection.h"
+
+namespace
+{
+	/// Payload with pattern unique to given seed, large enough to be compressed with default settings
+	std::vector<ui8> makePayload(ui8 seed, size_t size)
+	{
+		std::vector<ui8> ret(size);
+		for(size_t i = 0; i < size; i++)
+			ret[i] = seed + (i / 256) % 7;
+		return ret;
+	}
+}
+
+/// Two connections talking over loopback socket
+struct CConnectionTest : testing::Test
+{
+	std::unique_ptr<CConnection> server, client;
+
+	void SetUp() override
+	{
+		auto io = new boost::asio::io_service(); //deleted by server connection
+		TAcceptor acceptor(*io, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+		const ui16 port = acceptor.local_endpoint().port();
+
+		boost::thread accepting([&]()
+		{
+			auto socket = new TSocket(*io);
+			acceptor.accept(*socket);
+			server = make_unique<CConnection>(socket, "server");
+		});
+		client = make_unique<CConnection>("127.0.0.1", port, "client");
+		accepting.join();
+	}
+};
+
+TEST_F(CConnectionTest, framesKeepBoundaries)
+{
+	const std::string text = "hello";
+	const si32 number = -1337;
+	const auto small = makePayload(1, 100);
+	const auto large = makePayload(2, 100000);
+
+	*client << text << number << small << large << number;
+
+	std::string receivedText;
+	si32 receivedNumber = 0;
+	std::vector<ui8> receivedSmall, receivedLarge;
+	*server >> receivedText >> receivedNumber >> receivedSmall >> receivedLarge;
+	EXPECT_EQ(text, receivedText);
+	EXPECT_EQ(number, receivedNumber);
+	EXPECT_EQ(small, receivedSmall);
+	EXPECT_EQ(large, receivedLarge);
+
+	receivedNumber = 0;
+	*server >> receivedNumber;
+	EXPECT_EQ(number, receivedNumber);
+}
+
+TEST_F(CConnectionTest, batchedFramesAreReceivedInOrder)
+{
+	{
+		CConnection::Batch batch(*server);
+		for(ui8 i = 0; i < 10; i++)
+			*server << makePayload(i, i % 2 ? 10 : 5000);
+	}
+
+	for(ui8 i = 0; i < 10; i++)
+	{
+		std::vector<ui8> received;
+		*client >> received;
+		EXPECT_EQ(makePayload(i, i % 2 ? 10 : 5000), received);
+	}
+}
+
+TEST_F(CConnectionTest, compressedFramesSentWhileReceiving)
+{
+	const int FRAMES = 50;
+	auto send = [](CConnection & connection, ui8 seed)
+	{
+		for(int i = 0; i < FRAMES; i++)
+			connection << makePayload(seed + i, 20000 + i * 100);
+	};
+	auto receive = [](CConnection & connection, ui8 seed, int & mismatches)
+	{
+		for(int i = 0; i < FRAMES; i++)
+		{
+			std::vector<ui8> received;
+			connection >> received;
+			if(received != makePayload(seed + i, 20000 + i * 100))
+				mismatches++;
+		}
+	};
+
+	//every connection sends on one thread while it receives on another
+	int serverMismatches = 0, clientMismatches = 0;
+	boost::thread serverSending([&](){ send(*server, 0); });
+	boost::thread clientSending([&](){ send(*client, 100); });
+	boost::thread serverReceiving([&](){ receive(*server, 100, serverMismatches); });
+	receive(*client, 0, clientMismatches);
+
+	serverSending.join();
+	clientSending.join();
+	serverReceiving.join();
+	EXPECT_EQ(0, serverMismatches);
+	EXPECT_EQ(0, clientMismatches);
+}
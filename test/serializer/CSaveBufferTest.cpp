@@ -0,0 +1,186 @@
+/*
+ * CSaveBufferTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include <boost/asio.hpp>
+
+#include "../lib/serializer/CSaveBuffer.h"
+#include "../lib/serializer/CompressedSave.h"
+#include "../lib/serializer/BinaryDeserializer.h"
+
+namespace
+{
+	std::vector<ui8> readFile(const boost::filesystem::path & fname)
+	{
+		std::ifstream file(fname.string(), std::ios::binary);
+		return std::vector<ui8>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+}
+
+/// Same data as saved by game, written through CSaveFile and CSaveBuffer
+struct CSaveBufferTest : testing::Test
+{
+	boost::filesystem::path dir;
+
+	std::vector<si32> numbers;
+	std::map<std::string, std::string> strings;
+
+	void SetUp() override
+	{
+		dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("vcmi-savebuffer-%%%%%%%%");
+		boost::filesystem::create_directories(dir);
+
+		//large enough to be split into several chunks
+		for(si32 i = 0; i < static_cast<si32>(CompressedSave::MAX_CHUNK_SIZE / 2); i++)
+			numbers.push_back(i % 7 ? i / 100 : -i);
+		strings["first"] = "header";
+		strings["second"] = std::string(1000, 'x');
+	}
+
+	void TearDown() override
+	{
+		boost::filesystem::remove_all(dir);
+	}
+
+	template<typename Saver>
+	void save(Saver & saver)
+	{
+		saver.putMagicBytes("VCMISVG");
+		saver << strings;
+		saver.startSection();
+		saver << numbers << std::string("end");
+	}
+
+	void expectLoaded(const boost::filesystem::path & fname)
+	{
+		CLoadFile loader(fname);
+		loader.checkMagicBytes("VCMISVG");
+
+		std::map<std::string, std::string> loadedStrings;
+		std::vector<si32> loadedNumbers;
+		std::string end;
+		loader >> loadedStrings >> loadedNumbers >> end;
+
+		EXPECT_EQ(strings, loadedStrings);
+		EXPECT_EQ(numbers, loadedNumbers);
+		EXPECT_EQ("end", end);
+	}
+};
+
+TEST_F(CSaveBufferTest, bufferIsSameAsSaveFile)
+{
+	const auto fileName = dir / "file.vsgm1";
+	{
+		CSaveFile file(fileName);
+		save(file);
+	}
+	CSaveBuffer buffer;
+	save(buffer);
+
+	EXPECT_EQ(readFile(fileName), buffer.buffer);
+	expectLoaded(fileName);
+}
+
+TEST_F(CSaveBufferTest, writtenFileDecompressesToSaveFile)
+{
+	const auto fileName = dir / "file.vsgm1";
+	const auto bufferName = dir / "buffer.vsgm1";
+	{
+		CSaveFile file(fileName);
+		save(file);
+	}
+	CSaveBuffer buffer;
+	save(buffer);
+	buffer.writeToFile(bufferName);
+	EXPECT_FALSE(boost::filesystem::exists(dir / "buffer.vsgm1.tmp"));
+
+	const auto expected = readFile(fileName);
+	std::ifstream stream(bufferName.string(), std::ios::binary);
+	std::string magic(CompressedSave::MAGIC.size(), '\0');
+	stream.read(&magic[0], magic.size());
+	ASSERT_EQ(CompressedSave::MAGIC, magic);
+
+	CCompressedSaveReader reader(stream);
+	std::vector<ui8> decompressed(expected.size());
+	reader.read(decompressed.data(), decompressed.size());
+	EXPECT_EQ(expected, decompressed);
+
+	ui8 pastEnd;
+	EXPECT_THROW(reader.read(&pastEnd, 1), std::runtime_error);
+
+	expectLoaded(bufferName);
+}
+
+TEST_F(CSaveBufferTest, backgroundWriterReportsFailure)
+{
+	auto buffer = make_unique<CSaveBuffer>();
+	save(*buffer);
+
+	std::string error;
+	CBackgroundSaveWriter writer;
+	writer.write(std::move(buffer), dir / "missing" / "buffer.vsgm1", [&](const std::string & e){ error = e; });
+	writer.wait();
+
+	EXPECT_FALSE(error.empty());
+	EXPECT_FALSE(boost::filesystem::exists(dir / "missing" / "buffer.vsgm1"));
+}
+
+TEST_F(CSaveBufferTest, failureIsReportedOnStrandWhileConnectionsAreRemoved)
+{
+	//like server: connections are removed and failures are sent only by tasks run on network strand
+	boost::asio::io_service io;
+	boost::asio::io_service::strand strand(io);
+	std::unique_ptr<boost::asio::io_service::work> work(new boost::asio::io_service::work(io));
+	boost::thread network([&io](){ io.run(); });
+
+	const int ATTEMPTS = 20;
+	const int CONNECTIONS_PER_ATTEMPT = 50;
+	std::set<int> connections;
+	for(int i = 0; i < ATTEMPTS * CONNECTIONS_PER_ATTEMPT; i++)
+		connections.insert(i);
+
+	int reported = 0;
+	size_t messagesSent = 0;
+	CBackgroundSaveWriter writer;
+	for(int attempt = 0; attempt < ATTEMPTS; attempt++)
+	{
+		auto buffer = make_unique<CSaveBuffer>();
+		save(*buffer);
+		writer.write(std::move(buffer), dir / "missing" / "buffer.vsgm1", [&](const std::string & error)
+		{
+			strand.post([&]()
+			{
+				for(int connection : connections)
+					messagesSent += connection >= 0;
+				reported++;
+			});
+		});
+
+		for(int i = 0; i < CONNECTIONS_PER_ATTEMPT; i++)
+		{
+			strand.post([&]()
+			{
+				connections.erase(connections.begin());
+			});
+		}
+	}
+	writer.wait();
+
+	boost::promise<void> finished;
+	strand.post([&](){ finished.set_value(); });
+	finished.get_future().wait();
+	work.reset();
+	network.join();
+
+	EXPECT_EQ(ATTEMPTS, reported);
+	EXPECT_TRUE(connections.empty());
+	EXPECT_GT(messagesSent, 0);
+}
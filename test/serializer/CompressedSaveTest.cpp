@@ -0,0 +1,110 @@
+/*
+ * CompressedSaveTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+
+#include "../lib/CRandomGenerator.h"
+#include "../lib/serializer/CompressedSave.h"
+
+namespace
+{
+	std::vector<ui8> makeData(size_t size)
+	{
+		CRandomGenerator rand;
+		rand.setSeed(7);
+		std::vector<ui8> data(size);
+		for(size_t i = 0; i < size; i++)
+			data[i] = i % 3 ? static_cast<ui8>(i / 64) : static_cast<ui8>(rand.nextInt(255)); //somewhat compressible
+		return data;
+	}
+
+	std::stringstream writeContainer(const std::vector<ui8> & data, const std::vector<size_t> & sections)
+	{
+		std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+		CompressedSave::write(stream, data, sections);
+
+		std::string magic(CompressedSave::MAGIC.size(), '\0');
+		stream.read(&magic[0], magic.size());
+		EXPECT_EQ(CompressedSave::MAGIC, magic);
+		return stream;
+	}
+}
+
+TEST(CompressedSaveTest, readsBackWrittenStream)
+{
+	const auto data = makeData(CompressedSave::MAX_CHUNK_SIZE * 2 + 12345);
+	auto stream = writeContainer(data, {100, 5000, 5000, CompressedSave::MAX_CHUNK_SIZE + 7});
+	EXPECT_LT(stream.str().size(), data.size());
+
+	CCompressedSaveReader reader(stream);
+	std::vector<ui8> loaded(data.size());
+	size_t position = 0;
+	for(unsigned step = 1; position < data.size(); step = step * 3 % 70001 + 1)
+	{
+		const unsigned size = std::min<size_t>(step, data.size() - position);
+		reader.read(loaded.data() + position, size);
+		position += size;
+		EXPECT_EQ(position, reader.tell());
+	}
+	EXPECT_EQ(data, loaded);
+
+	ui8 pastEnd;
+	EXPECT_THROW(reader.read(&pastEnd, 1), std::runtime_error);
+}
+
+TEST(CompressedSaveTest, headerSectionIsReadAlone)
+{
+	const size_t headerSize = 300;
+	const auto data = makeData(CompressedSave::MAX_CHUNK_SIZE * 3);
+	auto stream = writeContainer(data, {headerSize});
+	const auto indexEnd = static_cast<size_t>(stream.tellg()) + sizeof(ui32) * 9; //count and 4 chunks
+
+	CCompressedSaveReader reader(stream);
+	std::vector<ui8> header(headerSize - 1);
+	reader.read(header.data(), header.size());
+
+	EXPECT_TRUE(std::equal(header.begin(), header.end(), data.begin()));
+	EXPECT_LT(static_cast<size_t>(stream.tellg()), indexEnd + headerSize + 64); //only first chunk was read
+}
+
+TEST(CompressedSaveTest, indexIsLittleEndian)
+{
+	const auto data = makeData(CompressedSave::MAX_CHUNK_SIZE + 0x123);
+	auto stream = writeContainer(data, {});
+
+	const std::string index = stream.str().substr(CompressedSave::MAGIC.size(), 4 * 5);
+	EXPECT_EQ(std::string("\x02\x00\x00\x00", 4), index.substr(0, 4)); //count
+	EXPECT_EQ(std::string("\x00\x00\x10\x00", 4), index.substr(8, 4)); //raw size of first chunk
+	EXPECT_EQ(std::string("\x23\x01\x00\x00", 4), index.substr(16, 4)); //raw size of second chunk
+}
+
+TEST(CompressedSaveTest, rejectsIndexLargerThanFile)
+{
+	const auto data = makeData(1000);
+	auto stream = writeContainer(data, {});
+
+	std::string contents = stream.str();
+	contents.replace(CompressedSave::MAGIC.size(), 4, std::string("\xff\xff\xff\x7f", 4));
+
+	std::stringstream corrupted(contents, std::ios::in | std::ios::binary);
+	corrupted.seekg(CompressedSave::MAGIC.size());
+	EXPECT_THROW(CCompressedSaveReader reader(corrupted), std::runtime_error);
+}
+
+TEST(CompressedSaveTest, rejectsTruncatedFile)
+{
+	const auto data = makeData(CompressedSave::MAX_CHUNK_SIZE + 1000);
+	auto stream = writeContainer(data, {});
+
+	const std::string contents = stream.str();
+	std::stringstream truncated(contents.substr(0, contents.size() - 10), std::ios::in | std::ios::binary);
+	truncated.seekg(CompressedSave::MAGIC.size());
+	EXPECT_THROW(CCompressedSaveReader reader(truncated), std::runtime_error);
+}